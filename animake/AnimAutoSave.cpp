@@ -0,0 +1,136 @@
+﻿#include "AnimAutoSave.hpp"
+#include "AnimText.hpp"
+#include "AtomicFile.hpp"
+
+namespace siapp
+{
+	bool AnimSnapshot::ToDocument(AnimDocument& outDoc) const
+	{
+		outDoc.textureName = textureName;
+		outDoc.textName    = textName;
+		outDoc.animations.clear();
+		outDoc.animations.resize(animations.size());
+
+		for (size_t i = 0; i < animations.size(); ++i)
+		{
+			if (animations[i] != nullptr)
+			{
+				outDoc.animations[i] = *animations[i];
+			}
+		}
+
+		//未読み込みのものはファイルの中身のままなので、ここで索引からデコードする。
+		//読めないものがあれば、パターンが空のまま書き出さないように写し全体を諦める。(前回の自動保存のファイルが残る)
+		for (const AnimSnapshotLazy& lazy : lazyAnimations)
+		{
+			AnimInfoData& info = outDoc.animations[lazy.position];
+			if (pIndex == nullptr || !pIndex->DecodeAnimation(lazy.index, info) || info.pattern.empty())
+			{
+				return false;
+			}
+			info.name = lazy.name;
+		}
+		return true;
+	}
+
+	AnimAutoSave::AnimAutoSave(void) :
+		m_Thread(),
+		m_Mutex(),
+		m_Condition(),
+		m_pPending(),
+		m_bBusy(false),
+		m_bQuit(false),
+		m_bLastResult(true),
+		m_SaveCount(0)
+	{
+		m_Thread = std::thread([this]() { Run(); });
+	}
+
+	AnimAutoSave::~AnimAutoSave(void)
+	{
+		//待っている写しは書き出してから終了する。
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_bQuit = true;
+		}
+		m_Condition.notify_one();
+		m_Thread.join();
+	}
+
+	void AnimAutoSave::Request(std::unique_ptr<AnimSnapshot> pSnapshot)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_pPending = std::move(pSnapshot);
+		}
+		m_Condition.notify_one();
+	}
+
+	bool AnimAutoSave::IsBusy(void)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_bBusy || m_pPending != nullptr;
+	}
+
+	bool AnimAutoSave::LastResult(void)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_bLastResult;
+	}
+
+	size_t AnimAutoSave::SaveCount(void)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_SaveCount;
+	}
+
+	bool AnimAutoSave::Save(const AnimSnapshot& snapshot)
+	{
+		AnimDocument doc;
+		if (!snapshot.ToDocument(doc))
+		{
+			return false;
+		}
+
+		//SaveDataと同じく両方をメモリ上に作ってから書き出す。
+		std::vector<uint8_t> animBuffer;
+		if (!AnimCodec::Encode(doc, animBuffer, snapshot.format, snapshot.compression))
+		{
+			return false;
+		}
+
+		std::string text;
+		AnimText::Export(doc, snapshot.animPath, text);
+
+		return AtomicFile::Write(snapshot.animFilePath, animBuffer.data(), animBuffer.size()) &&
+			AtomicFile::Write(snapshot.textFilePath, text.data(), text.size());
+	}
+
+	void AnimAutoSave::Run(void)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		for (;;)
+		{
+			m_Condition.wait(lock, [this]() { return m_bQuit || m_pPending != nullptr; });
+
+			if (m_pPending == nullptr)
+			{
+				break;
+			}
+
+			std::unique_ptr<AnimSnapshot> pSnapshot = std::move(m_pPending);
+			m_bBusy = true;
+
+			//書き出している間は新しい写しを受け取れるようにロックを外しておく。
+			lock.unlock();
+			bool bResult = Save(*pSnapshot);
+			pSnapshot.reset();
+			lock.lock();
+
+			m_bBusy       = false;
+			m_bLastResult = bResult;
+			m_SaveCount++;
+		}
+	}
+}
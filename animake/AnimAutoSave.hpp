@@ -0,0 +1,78 @@
+﻿#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "AnimCodec.hpp"
+#include "AnimIndex.hpp"
+
+//別スレッドでの自動保存。Siv3Dには依存しない。
+
+namespace siapp
+{
+	//写しを作る時点でまだ読み込んでいないアニメーション。書き出す時にワーカースレッドで索引からデコードする。
+	struct AnimSnapshotLazy
+	{
+		size_t                                            position     = 0;    //animations内の番号
+		size_t                                            index        = 0;    //索引内の番号
+		std::string                                       name;
+	};
+
+	//保存する時点のドキュメントの写し。
+	//アニメーションは変更のないものを前回の写しと共有するので、写しを作る時は変更されたものだけをコピーすればよい。
+	//一度作ったAnimInfoDataは書き換えないこと。
+	//未読み込みのアニメーションはanimationsをnullptrにしておき、索引を共有してlazyAnimationsに番号を入れる。
+	struct AnimSnapshot
+	{
+		std::filesystem::path                             animFilePath;
+		std::filesystem::path                             textFilePath;
+		std::string                                       animPath;       //.txtの1行目に書くパス
+		std::string                                       textureName;
+		std::string                                       textName;
+		std::vector<std::shared_ptr<const AnimInfoData>>  animations;
+		std::shared_ptr<const AnimIndex>                  pIndex;
+		std::vector<AnimSnapshotLazy>                     lazyAnimations;
+		AnimFormat                                        format       = AnimFormat::Legacy;
+		AnimCompression                                   compression  = AnimCompression::None;
+
+		//エンコードできるようにAnimDocumentにコピーする。未読み込みのものをデコードできなければfalseを返す。
+		bool ToDocument(AnimDocument& outDoc) const;
+	};
+
+	//受け取った写しをワーカースレッドで.animと.txtに書き出す。
+	//書き出し中に次の写しが来た場合は、最後に来たものだけを書き出す。
+	class AnimAutoSave
+	{
+	private:
+		std::thread                                       m_Thread;
+		std::mutex                                        m_Mutex;
+		std::condition_variable                           m_Condition;
+		std::unique_ptr<AnimSnapshot>                     m_pPending;
+		bool                                              m_bBusy;
+		bool                                              m_bQuit;
+		bool                                              m_bLastResult;
+		size_t                                            m_SaveCount;
+	public:
+		AnimAutoSave(void);
+		~AnimAutoSave(void);
+		AnimAutoSave(const AnimAutoSave&) = delete;
+		AnimAutoSave& operator= (const AnimAutoSave&) = delete;
+
+		//写しを渡して書き出しを頼む。すぐに戻る。
+		void Request(std::unique_ptr<AnimSnapshot> pSnapshot);
+
+		//書き出し待ちか書き出し中ならtrueを返す。
+		bool IsBusy(void);
+
+		//最後の書き出しが成功したか。
+		bool LastResult(void);
+
+		//書き出しが終わった回数。
+		size_t SaveCount(void);
+
+		//写しを.animと.txtに書き出す。ワーカースレッドを使わずに保存したい場合にも使える。
+		static bool Save(const AnimSnapshot& snapshot);
+	private:
+		void Run(void);
+	};
+}
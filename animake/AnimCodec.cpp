@@ -0,0 +1,320 @@
+﻿#include "AnimCodec.hpp"
+#include "AnimCompact.hpp"
+#include "AnimV2.hpp"
+#include "AtomicFile.hpp"
+#include "AnimZstd.hpp"
+#include "BufferIO.hpp"
+#include <fstream>
+
+namespace siapp
+{
+	namespace
+	{
+		//アニメーション1つ分の最小サイズ。(名前の長さ + 矩形4つ + ループフラグ + パターン数)
+		constexpr size_t animRecordMinSize    = sizeof(int32_t) + sizeof(float) * 4 + sizeof(char) + sizeof(int32_t);
+
+		//パターン1つ分のサイズ。
+		constexpr size_t patternRecordSize    = sizeof(float) + sizeof(int32_t) * 2;
+	}
+
+	namespace AnimCodec
+	{
+		bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& outBuffer)
+		{
+			//ディレクトリもifstreamで開けてしまい、大きさが壊れた値になるので先に弾く。
+			std::error_code ec;
+			if (!std::filesystem::is_regular_file(path, ec))
+			{
+				return false;
+			}
+
+			std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+			if (!ifs)
+			{
+				return false;
+			}
+
+			std::streamoff size = ifs.tellg();
+			if (size < 0)
+			{
+				return false;
+			}
+
+			//ファイルサイズ分を確保して一度で読み込む。
+			outBuffer.resize(static_cast<size_t>(size));
+			ifs.seekg(0, std::ios::beg);
+			if (size > 0 && !ifs.read(reinterpret_cast<char*>(outBuffer.data()), size))
+			{
+				return false;
+			}
+			return true;
+		}
+
+		AnimFormat Detect(const uint8_t* data, size_t size)
+		{
+			if (AnimV2::IsFlat(data, size))
+			{
+				return AnimFormat::Flat;
+			}
+			return AnimCompact::IsCompact(data, size) ? AnimFormat::Compact : AnimFormat::Legacy;
+		}
+
+		bool Decode(const uint8_t* data, size_t size, AnimDocument& outDoc)
+		{
+			//圧縮されていれば展開してから中身の形式を判別する。
+			if (AnimZstd::IsCompressed(data, size))
+			{
+				std::vector<uint8_t> buffer;
+				if (!AnimZstd::Decompress(data, size, buffer) || AnimZstd::IsCompressed(buffer.data(), buffer.size()))
+				{
+					return false;
+				}
+				return Decode(buffer.data(), buffer.size(), outDoc);
+			}
+
+			switch (Detect(data, size))
+			{
+			case AnimFormat::Flat:
+				return AnimV2::Decode(data, size, outDoc);
+			case AnimFormat::Compact:
+				return AnimCompact::Decode(data, size, outDoc);
+			case AnimFormat::Legacy:
+			default:
+				return DecodeLegacy(data, size, outDoc);
+			}
+		}
+
+		bool DecodeLegacy(const uint8_t* data, size_t size, AnimDocument& outDoc)
+		{
+			//読み込み順はEncode関数を参照。
+			BufferReader br(data, size);
+
+			outDoc.animations.clear();
+
+			if (!br.ReadString(outDoc.textureName))
+			{
+				return false;
+			}
+
+			int32_t animCount;
+			if (!br.Read(animCount) || animCount < 0 || br.Remain() / animRecordMinSize < static_cast<size_t>(animCount))
+			{
+				return false;
+			}
+
+			outDoc.animations.resize(static_cast<size_t>(animCount));
+
+			size_t pos = br.Pos();
+			for (AnimInfoData& info : outDoc.animations)
+			{
+				if (!DecodeLegacyAnimation(data, size, pos, info))
+				{
+					return false;
+				}
+			}
+			br = BufferReader(data, size, pos);
+
+			//テキスト出力に対応する前のファイルにはテキストファイル名がないので空にしておく。
+			//テキストファイル名は表示にしか使わないので、途中で切れていて読めない時も空にして読み込みは続ける。
+			if (br.Remain() == 0 || !br.ReadString(outDoc.textName))
+			{
+				outDoc.textName.clear();
+			}
+			return true;
+		}
+
+		bool DecodeLegacyAnimation(const uint8_t* data, size_t size, size_t& inoutPos, AnimInfoData& outInfo)
+		{
+			BufferReader br(data, size, inoutPos);
+
+			char loop;
+			int32_t patternCount;
+
+			if (!br.ReadString(outInfo.name) ||
+				!br.Read(outInfo.offsetX)    ||
+				!br.Read(outInfo.offsetY)    ||
+				!br.Read(outInfo.width)      ||
+				!br.Read(outInfo.height)     ||
+				!br.Read(loop)               ||
+				!br.Read(patternCount))
+			{
+				return false;
+			}
+
+			outInfo.bLoop = loop != 0;
+
+			if (patternCount < 0 || br.Remain() / patternRecordSize < static_cast<size_t>(patternCount))
+			{
+				return false;
+			}
+
+			outInfo.pattern.resize(static_cast<size_t>(patternCount));
+			for (AnimPatternData& ptn : outInfo.pattern)
+			{
+				br.Read(ptn.wait);
+				br.Read(ptn.no);
+				br.Read(ptn.step);
+			}
+
+			inoutPos = br.Pos();
+			return true;
+		}
+
+		bool SkipLegacyAnimation(const uint8_t* data, size_t size, size_t& inoutPos, std::string_view& outName)
+		{
+			BufferReader br(data, size, inoutPos);
+
+			int32_t patternCount;
+
+			//矩形4つとループフラグは読まずに飛ばす。
+			if (!br.ReadStringView(outName)                    ||
+				!br.Skip(sizeof(float) * 4 + sizeof(char))    ||
+				!br.Read(patternCount)                         ||
+				patternCount < 0                               ||
+				!br.Skip(patternRecordSize * static_cast<size_t>(patternCount)))
+			{
+				return false;
+			}
+
+			inoutPos = br.Pos();
+			return true;
+		}
+
+		size_t EncodedSize(const AnimDocument& doc)
+		{
+			size_t size = sizeof(int32_t) + doc.textureName.size() + sizeof(int32_t);
+			for (const AnimInfoData& info : doc.animations)
+			{
+				size += animRecordMinSize + info.name.size() + patternRecordSize * info.pattern.size();
+			}
+			size += sizeof(int32_t) + doc.textName.size();
+			return size;
+		}
+
+		bool Encode(const AnimDocument& doc, std::vector<uint8_t>& outBuffer, AnimFormat format, AnimCompression compression)
+		{
+			if (compression == AnimCompression::Zstd)
+			{
+				std::vector<uint8_t> raw;
+				Encode(doc, raw, format, AnimCompression::None);
+				return AnimZstd::Compress(raw.data(), raw.size(), outBuffer);
+			}
+
+			if (format == AnimFormat::Flat)
+			{
+				AnimV2::Encode(doc, outBuffer);
+				return true;
+			}
+
+			if (format == AnimFormat::Compact)
+			{
+				AnimCompact::Encode(doc, outBuffer);
+				return true;
+			}
+
+			/// ###          書き込むデータの順番は以下の通り          ###
+			//     ・テクスチャのファイル名の長さ( int   )
+			//     ・テクスチャのファイル名      ( char  )
+			//     ・アニメーションの数          ( int   )
+			/// ##ここからアニメーションの数だけループ
+			//     ・アニメーション名の長さ      ( int   )
+			//     ・アニメーション名            ( char  )
+			//     ・オフセットX                 ( float )
+			//     ・オフセットY                 ( float )
+			//     ・横幅                        ( float )
+			//     ・高さ                        ( float )
+			//     ・ループフラグ                ( char  )
+			//     ・アニメーションパターン数    ( int   )
+			///  #ここからパターンの数だけループ
+			//     ・待機フレーム                ( float )
+			//     ・No                          ( int   )
+			//     ・Step                        ( int   )
+			///  #ここまでパターンの数だけループ
+			/// ##ここまでアニメーションの数だけループ
+			//     ・テキストファイル名の長さ    ( int   )
+			//     ・テキストファイル名          ( char  )
+			//     ・EOF
+			outBuffer.clear();
+			outBuffer.reserve(EncodedSize(doc));
+
+			BufferWriter bw(outBuffer);
+
+			bw.WriteString(doc.textureName);
+			bw.Write(static_cast<int32_t>(doc.animations.size()));
+
+			for (const AnimInfoData& info : doc.animations)
+			{
+				EncodeLegacyAnimation(info, outBuffer);
+			}
+
+			bw.WriteString(doc.textName);
+			return true;
+		}
+
+		void EncodeLegacyAnimation(const AnimInfoData& info, std::vector<uint8_t>& outBuffer)
+		{
+			BufferWriter bw(outBuffer);
+
+			char loop = info.bLoop ? 1 : 0;
+			bw.WriteString(info.name);
+			bw.Write(info.offsetX);
+			bw.Write(info.offsetY);
+			bw.Write(info.width);
+			bw.Write(info.height);
+			bw.Write(loop);
+			bw.Write(static_cast<int32_t>(info.pattern.size()));
+
+			for (const AnimPatternData& ptn : info.pattern)
+			{
+				bw.Write(ptn.wait);
+				bw.Write(ptn.no);
+				bw.Write(ptn.step);
+			}
+		}
+
+		bool Load(const std::filesystem::path& path, AnimDocument& outDoc)
+		{
+			std::vector<uint8_t> buffer;
+			if (!ReadFile(path, buffer))
+			{
+				return false;
+			}
+			return Decode(buffer.data(), buffer.size(), outDoc);
+		}
+
+		std::filesystem::path ResolveTexturePath(const std::filesystem::path& animPath, const std::string& textureName)
+		{
+			if (textureName.empty())
+			{
+				return std::filesystem::path();
+			}
+
+			//GUIで保存した.animには作業フォルダからの相対パスが入っている。
+			std::error_code ec;
+			std::filesystem::path texturePath = textureName;
+			if (std::filesystem::is_regular_file(texturePath, ec))
+			{
+				return texturePath;
+			}
+
+			//別の作業フォルダで作られた.animは、画像が.animと同じフォルダに置かれていることが多い。
+			std::filesystem::path localPath = animPath.parent_path() / texturePath;
+			if (texturePath.is_relative() && std::filesystem::is_regular_file(localPath, ec))
+			{
+				return localPath;
+			}
+			return std::filesystem::path();
+		}
+
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc, AnimFormat format, AnimCompression compression)
+		{
+			std::vector<uint8_t> buffer;
+			if (!Encode(doc, buffer, format, compression))
+			{
+				return false;
+			}
+
+			return AtomicFile::Write(path, buffer.data(), buffer.size());
+		}
+	}
+}
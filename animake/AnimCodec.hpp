@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//Siv3Dに依存しない.animファイルの読み書き。
+//ツールやアセットパイプラインからウィンドウなしで使えるように標準ライブラリのみで実装する。
+
+namespace siapp
+{
+	//パターン1つ分のデータ。ファイル上の並び(float, int, int)と同じ。
+	struct AnimPatternData
+	{
+		float                        wait    = 1.0f;
+		int32_t                      no      = 0;
+		int32_t                      step    = 0;
+	};
+
+	//アニメーション1つ分のデータ。文字列は.animに書かれているままのバイト列で持つ。
+	struct AnimInfoData
+	{
+		std::string                  name;
+		float                        offsetX = 0.0f;
+		float                        offsetY = 0.0f;
+		float                        width   = 0.0f;
+		float                        height  = 0.0f;
+		bool                         bLoop   = false;
+		std::vector<AnimPatternData> pattern;
+	};
+
+	//.animファイル1つ分のデータ。
+	struct AnimDocument
+	{
+		std::string                  textureName;
+		std::vector<AnimInfoData>    animations;
+		std::string                  textName;
+	};
+
+	//.animファイルの形式。
+	enum class AnimFormat
+	{
+		Legacy,  //長さ付き文字列と項目ごとの値を順番に並べた従来の形式
+		Flat,    //テーブルを固定長で並べたv2形式。(AnimV2.hpp)
+		Compact, //パターンを差分にして可変長整数で詰めた形式。(AnimCompact.hpp)
+	};
+
+	//.animファイルの圧縮方式。どちらの形式にも使える。
+	enum class AnimCompression
+	{
+		None,
+		Zstd,    //zstdで圧縮したコンテナ。(AnimZstd.hpp)
+	};
+
+	namespace AnimCodec
+	{
+		//ファイル全体を一度の読み込みでバッファに取り込む。
+		bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& outBuffer);
+
+		//先頭のマジックナンバーから形式を判別する。v2形式でもコンパクト形式でもなければ従来の形式として扱う。
+		AnimFormat Detect(const uint8_t* data, size_t size);
+
+		//メモリ上の.animデータを形式を判別してデコードする。圧縮されていれば展開してからデコードする。
+		//途中で途切れていたり壊れていた場合はfalseを返す。
+		bool Decode(const uint8_t* data, size_t size, AnimDocument& outDoc);
+
+		//従来の形式のデータをデコードする。
+		bool DecodeLegacy(const uint8_t* data, size_t size, AnimDocument& outDoc);
+
+		//従来の形式のアニメーション1つ分を指定位置からデコードする。成功したら次のアニメーションの位置に進める。
+		bool DecodeLegacyAnimation(const uint8_t* data, size_t size, size_t& inoutPos, AnimInfoData& outInfo);
+
+		//従来の形式のアニメーション1つ分を名前だけ読んで飛ばす。名前はdataの中を直接指す。
+		bool SkipLegacyAnimation(const uint8_t* data, size_t size, size_t& inoutPos, std::string_view& outName);
+
+		//.animデータを指定の形式でバッファにエンコードする。バッファは書き込む前に必要な分だけ確保する。
+		//圧縮に失敗した場合はfalseを返す。
+		bool Encode(const AnimDocument& doc, std::vector<uint8_t>& outBuffer, AnimFormat format = AnimFormat::Legacy, AnimCompression compression = AnimCompression::None);
+
+		//従来の形式のアニメーション1つ分をバッファの後ろに書き足す。
+		void EncodeLegacyAnimation(const AnimInfoData& info, std::vector<uint8_t>& outBuffer);
+
+		//従来の形式でエンコードした時のサイズを計算する。
+		size_t EncodedSize(const AnimDocument& doc);
+
+		//ReadFileとDecodeをまとめて行う。
+		bool Load(const std::filesystem::path& path, AnimDocument& outDoc);
+
+		//.animに書かれた画像のパスから画像ファイルを探す。作業フォルダからの相対パスを先に探し、なければ.animと同じフォルダを探す。
+		//見つからなければ空のパスを返す。GUIの読み込みとツールで同じ画像を使うように、画像の場所はここで決める。
+		std::filesystem::path ResolveTexturePath(const std::filesystem::path& animPath, const std::string& textureName);
+
+		//Encodeした結果を一度の書き込みで一時ファイルに書き出し、元のファイルと置き換える。(AtomicFile.hpp)
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc, AnimFormat format = AnimFormat::Legacy, AnimCompression compression = AnimCompression::None);
+	}
+}
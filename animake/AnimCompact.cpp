@@ -0,0 +1,255 @@
+﻿#include "AnimCompact.hpp"
+#include "BufferIO.hpp"
+#include <cstring>
+
+namespace siapp
+{
+	namespace
+	{
+		constexpr char     animCompactMagic[4] = { 'A', 'N', 'M', 'C' };
+		constexpr uint8_t  compactLoopFlag     = 1u << 0;
+		constexpr uint64_t tagWaitChanged      = 1u << 0;
+		constexpr uint64_t tagStepChanged      = 1u << 1;
+		constexpr int      tagShift            = 2;
+
+		//名前以外の固定長部分。(オフセットX, Y, 横幅, 高さ, フラグ)
+		constexpr size_t   compactFixedSize    = sizeof(float) * 4 + sizeof(uint8_t);
+
+		uint32_t FloatBits(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(float));
+			return bits;
+		}
+
+		bool IsInt32(int64_t value)
+		{
+			return value >= INT32_MIN && value <= INT32_MAX;
+		}
+
+		void EncodeAnimation(const AnimInfoData& info, std::vector<uint8_t>& outBuffer)
+		{
+			BufferWriter bw(outBuffer);
+
+			bw.WriteVarintString(info.name);
+			bw.Write(info.offsetX);
+			bw.Write(info.offsetY);
+			bw.Write(info.width);
+			bw.Write(info.height);
+			bw.Write(static_cast<uint8_t>(info.bLoop ? compactLoopFlag : 0));
+			bw.WriteVarint(info.pattern.size());
+
+			//waitはビット列で比べるので、-0や非数もそのまま元に戻る。
+			int64_t  prevNo   = -1;
+			int64_t  prevStep = 0;
+			uint32_t prevWait = FloatBits(1.0f);
+
+			for (const AnimPatternData& ptn : info.pattern)
+			{
+				uint32_t wait = FloatBits(ptn.wait);
+				bool bWaitChanged = wait != prevWait;
+				bool bStepChanged = ptn.step != prevStep;
+
+				uint64_t tag = ZigZagEncode(ptn.no - (prevNo + 1)) << tagShift;
+				tag |= bWaitChanged ? tagWaitChanged : 0;
+				tag |= bStepChanged ? tagStepChanged : 0;
+				bw.WriteVarint(tag);
+
+				if (bWaitChanged)
+				{
+					bw.Write(ptn.wait);
+				}
+				if (bStepChanged)
+				{
+					bw.WriteVarint(ZigZagEncode(ptn.step - prevStep));
+				}
+
+				prevNo   = ptn.no;
+				prevStep = ptn.step;
+				prevWait = wait;
+			}
+		}
+	}
+
+	namespace AnimCompact
+	{
+		bool IsCompact(const uint8_t* data, size_t size)
+		{
+			return size >= sizeof(animCompactMagic) + sizeof(uint32_t) && std::memcmp(data, animCompactMagic, sizeof(animCompactMagic)) == 0;
+		}
+
+		void Encode(const AnimDocument& doc, std::vector<uint8_t>& outBuffer)
+		{
+			outBuffer.clear();
+
+			BufferWriter bw(outBuffer);
+			bw.Write(animCompactMagic, sizeof(animCompactMagic));
+			bw.Write(animCompactVersion);
+			bw.WriteVarintString(doc.textureName);
+			bw.WriteVarintString(doc.textName);
+			bw.WriteVarint(doc.animations.size());
+
+			//アニメーションごとに一度別のバッファに書いて、先頭にバイト数を付けてから書き足す。
+			std::vector<uint8_t> record;
+			for (const AnimInfoData& info : doc.animations)
+			{
+				record.clear();
+				EncodeAnimation(info, record);
+
+				bw.WriteVarint(record.size());
+				bw.Write(record.data(), record.size());
+			}
+		}
+
+		bool Decode(const uint8_t* data, size_t size, AnimDocument& outDoc)
+		{
+			size_t pos;
+			size_t animCount;
+			if (!DecodeHeader(data, size, pos, outDoc.textureName, outDoc.textName, animCount))
+			{
+				return false;
+			}
+
+			outDoc.animations.resize(animCount);
+			for (AnimInfoData& info : outDoc.animations)
+			{
+				if (!DecodeAnimation(data, size, pos, info))
+				{
+					return false;
+				}
+			}
+			return pos == size;
+		}
+
+		bool DecodeHeader(const uint8_t* data, size_t size, size_t& outPos, std::string& outTextureName, std::string& outTextName, size_t& outAnimCount)
+		{
+			if (!IsCompact(data, size))
+			{
+				return false;
+			}
+
+			BufferReader br(data, size, sizeof(animCompactMagic));
+
+			uint32_t version;
+			uint64_t animCount;
+			if (!br.Read(version) || version != animCompactVersion ||
+				!br.ReadVarintString(outTextureName) ||
+				!br.ReadVarintString(outTextName) ||
+				!br.ReadVarint(animCount) ||
+				animCount > br.Remain())   //アニメーション1つは最低1バイトある
+			{
+				return false;
+			}
+
+			outPos       = br.Pos();
+			outAnimCount = static_cast<size_t>(animCount);
+			return true;
+		}
+
+		bool DecodeAnimation(const uint8_t* data, size_t size, size_t& inoutPos, AnimInfoData& outInfo)
+		{
+			BufferReader br(data, size, inoutPos);
+
+			uint64_t recordSize;
+			if (!br.ReadVarint(recordSize) || br.Remain() < recordSize)
+			{
+				return false;
+			}
+
+			//アニメーションの範囲だけを読む。
+			size_t end = br.Pos() + static_cast<size_t>(recordSize);
+			br = BufferReader(data, end, br.Pos());
+
+			uint8_t  flags;
+			uint64_t patternCount;
+			if (!br.ReadVarintString(outInfo.name) ||
+				!br.Read(outInfo.offsetX) ||
+				!br.Read(outInfo.offsetY) ||
+				!br.Read(outInfo.width)   ||
+				!br.Read(outInfo.height)  ||
+				!br.Read(flags)           ||
+				!br.ReadVarint(patternCount) ||
+				patternCount > br.Remain())   //パターン1つは最低1バイトある
+			{
+				return false;
+			}
+
+			outInfo.bLoop = (flags & compactLoopFlag) != 0;
+			outInfo.pattern.resize(static_cast<size_t>(patternCount));
+
+			int64_t prevNo   = -1;
+			int64_t prevStep = 0;
+			float   prevWait = 1.0f;
+
+			for (AnimPatternData& ptn : outInfo.pattern)
+			{
+				uint64_t tag;
+				if (!br.ReadVarint(tag))
+				{
+					return false;
+				}
+
+				int64_t no   = prevNo + 1 + ZigZagDecode(tag >> tagShift);
+				int64_t step = prevStep;
+				float   wait = prevWait;
+
+				if ((tag & tagWaitChanged) && !br.Read(wait))
+				{
+					return false;
+				}
+				if (tag & tagStepChanged)
+				{
+					uint64_t delta;
+					if (!br.ReadVarint(delta))
+					{
+						return false;
+					}
+					step += ZigZagDecode(delta);
+				}
+
+				if (!IsInt32(no) || !IsInt32(step))
+				{
+					return false;
+				}
+
+				ptn.wait = wait;
+				ptn.no   = static_cast<int32_t>(no);
+				ptn.step = static_cast<int32_t>(step);
+
+				prevNo   = no;
+				prevStep = step;
+				prevWait = wait;
+			}
+
+			//書かれたバイト数とちょうど合わなければ壊れている。
+			if (br.Pos() != end)
+			{
+				return false;
+			}
+
+			inoutPos = end;
+			return true;
+		}
+
+		bool SkipAnimation(const uint8_t* data, size_t size, size_t& inoutPos, std::string_view& outName)
+		{
+			BufferReader br(data, size, inoutPos);
+
+			uint64_t recordSize;
+			if (!br.ReadVarint(recordSize) || br.Remain() < recordSize)
+			{
+				return false;
+			}
+
+			size_t end = br.Pos() + static_cast<size_t>(recordSize);
+			BufferReader nameReader(data, end, br.Pos());
+			if (!nameReader.ReadVarintStringView(outName) || nameReader.Remain() < compactFixedSize)
+			{
+				return false;
+			}
+
+			inoutPos = end;
+			return true;
+		}
+	}
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+
+//.animのコンパクト形式。パターンを前のパターンとの差分にして、可変長整数(LEB128)で詰めて書く。
+//noは前のパターン+1、stepとwaitは前のパターンと同じことが多いので、ほとんどのパターンは1バイトで済む。
+//
+//ファイルの並び:
+//    "ANMC", バージョン(uint32)
+//    テクスチャのファイル名, テキストファイル名        (可変長整数の長さ付き文字列)
+//    アニメーションの数                                (可変長整数)
+//    アニメーションの数だけ:
+//        この後に続くアニメーション1つ分のバイト数     (可変長整数) 索引を作る時に中身を読まずに飛ばせるようにする
+//        アニメーション名                              (可変長整数の長さ付き文字列)
+//        オフセットX, オフセットY, 横幅, 高さ          (float)
+//        フラグ                                        (uint8) bit0: ループ
+//        パターン数                                    (可変長整数)
+//        パターンの数だけ:
+//            タグ (可変長整数) = zigzag(no - (前のno + 1)) << 2 | stepが変わった << 1 | waitが変わった
+//            wait (float)                              waitが変わった時だけ
+//            zigzag(step - 前のstep) (可変長整数)      stepが変わった時だけ
+//最初のパターンは、前のパターンを no = -1, step = 0, wait = 1.0 として扱う。
+
+namespace siapp
+{
+	constexpr uint32_t               animCompactVersion = 1;
+
+	namespace AnimCompact
+	{
+		//先頭のマジックナンバーでコンパクト形式か調べる。
+		bool IsCompact(const uint8_t* data, size_t size);
+
+		void Encode(const AnimDocument& doc, std::vector<uint8_t>& outBuffer);
+
+		bool Decode(const uint8_t* data, size_t size, AnimDocument& outDoc);
+
+		//アニメーションより前の部分を読む。outPosには最初のアニメーションの位置を入れる。(AnimIndex用)
+		bool DecodeHeader(const uint8_t* data, size_t size, size_t& outPos, std::string& outTextureName, std::string& outTextName, size_t& outAnimCount);
+
+		//アニメーション1つ分を指定位置からデコードする。成功したら次のアニメーションの位置に進める。
+		bool DecodeAnimation(const uint8_t* data, size_t size, size_t& inoutPos, AnimInfoData& outInfo);
+
+		//アニメーション1つ分を名前だけ読んで飛ばす。名前はdataの中を直接指す。
+		bool SkipAnimation(const uint8_t* data, size_t size, size_t& inoutPos, std::string_view& outName);
+	}
+}
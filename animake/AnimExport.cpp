@@ -0,0 +1,387 @@
+﻿#include "AnimExport.hpp"
+#include "AnimText.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace siapp
+{
+	namespace
+	{
+		constexpr int32_t exportVersion = 1;
+
+		//MessagePackのキー。JSONのキーと同じ名前にする。
+		constexpr char keyVersion[]    = "version";
+		constexpr char keyTexture[]    = "texture";
+		constexpr char keyAnimations[] = "animations";
+		constexpr char keyName[]       = "name";
+		constexpr char keyOffsetX[]    = "offsetX";
+		constexpr char keyOffsetY[]    = "offsetY";
+		constexpr char keyWidth[]      = "width";
+		constexpr char keyHeight[]     = "height";
+		constexpr char keyLoop[]       = "loop";
+		constexpr char keyPatterns[]   = "patterns";
+		constexpr char keyWait[]       = "wait";
+		constexpr char keyNo[]         = "no";
+		constexpr char keyStep[]       = "step";
+
+		//MessagePackの値はビッグエンディアンで書く。
+		template<class T>
+		void AppendBigEndian(std::string& out, T value)
+		{
+			for (int shift = static_cast<int>(sizeof(T) - 1) * 8; shift >= 0; shift -= 8)
+			{
+				out += static_cast<char>(static_cast<uint8_t>(value >> shift));
+			}
+		}
+	}
+
+	AnimExportWriter::AnimExportWriter(void) :
+		m_Stream(),
+		m_Format(AnimExportFormat::Json),
+		m_Buffer(),
+		m_AnimCount(0),
+		m_WriteCount(0),
+		m_WrittenSize(0),
+		m_MaxBufferSize(0)
+	{
+	}
+
+	bool AnimExportWriter::Open(const std::filesystem::path& path, AnimExportFormat format)
+	{
+		m_Format        = format;
+		m_AnimCount     = 0;
+		m_WriteCount    = 0;
+		m_WrittenSize   = 0;
+		m_MaxBufferSize = 0;
+
+		//アニメーション1つ分がはみ出しても確保し直さないように少し多めに取っておく。
+		m_Buffer.clear();
+		m_Buffer.reserve(flushSize * 2);
+
+		return m_Stream.Open(path);
+	}
+
+	void AnimExportWriter::Flush(void)
+	{
+		m_MaxBufferSize = std::max(m_MaxBufferSize, m_Buffer.size());
+		m_Stream.Write(m_Buffer.data(), m_Buffer.size());
+		m_WrittenSize += m_Buffer.size();
+		m_Buffer.clear();
+	}
+
+	void AnimExportWriter::FlushIfFull(void)
+	{
+		if (m_Buffer.size() >= flushSize)
+		{
+			Flush();
+		}
+	}
+
+	void AnimExportWriter::BeginDocument(const std::string& textureName, size_t animCount)
+	{
+		m_AnimCount = animCount;
+
+		switch (m_Format)
+		{
+		case AnimExportFormat::Json:
+			m_Buffer += "{\"version\":";
+			AppendJsonNumber(exportVersion);
+			m_Buffer += ",\"texture\":";
+			AppendJsonString(AnimText::NativeToUtf8(textureName));
+			m_Buffer += ",\"animations\":[";
+			break;
+		case AnimExportFormat::MessagePack:
+			AppendPackMap(3);
+			AppendPackString(keyVersion, sizeof(keyVersion) - 1);
+			AppendPackInt(exportVersion);
+			AppendPackString(keyTexture, sizeof(keyTexture) - 1);
+			AppendPackString(AnimText::NativeToUtf8(textureName));
+			AppendPackString(keyAnimations, sizeof(keyAnimations) - 1);
+			AppendPackArray(static_cast<uint32_t>(animCount));
+			break;
+		}
+	}
+
+	void AnimExportWriter::WriteAnimation(const AnimInfoData& info)
+	{
+		switch (m_Format)
+		{
+		case AnimExportFormat::Json:
+			//差分を見やすいようにアニメーションごとに改行する。
+			m_Buffer += (m_WriteCount == 0) ? "\n{\"name\":" : ",\n{\"name\":";
+			AppendJsonString(AnimText::NativeToUtf8(info.name));
+			m_Buffer += ",\"offsetX\":";
+			AppendJsonNumber(info.offsetX);
+			m_Buffer += ",\"offsetY\":";
+			AppendJsonNumber(info.offsetY);
+			m_Buffer += ",\"width\":";
+			AppendJsonNumber(info.width);
+			m_Buffer += ",\"height\":";
+			AppendJsonNumber(info.height);
+			m_Buffer += info.bLoop ? ",\"loop\":true" : ",\"loop\":false";
+			m_Buffer += ",\"patterns\":[";
+
+			for (size_t j = 0; j < info.pattern.size(); ++j)
+			{
+				const AnimPatternData& ptn = info.pattern[j];
+
+				m_Buffer += (j == 0) ? "{\"wait\":" : ",{\"wait\":";
+				AppendJsonNumber(ptn.wait);
+				m_Buffer += ",\"no\":";
+				AppendJsonNumber(ptn.no);
+				m_Buffer += ",\"step\":";
+				AppendJsonNumber(ptn.step);
+				m_Buffer += '}';
+
+				//パターンの多いアニメーションでもバッファが大きくなりすぎないようにする。
+				FlushIfFull();
+			}
+			m_Buffer += "]}";
+			break;
+		case AnimExportFormat::MessagePack:
+			AppendPackMap(7);
+			AppendPackString(keyName, sizeof(keyName) - 1);
+			AppendPackString(AnimText::NativeToUtf8(info.name));
+			AppendPackString(keyOffsetX, sizeof(keyOffsetX) - 1);
+			AppendPackFloat(info.offsetX);
+			AppendPackString(keyOffsetY, sizeof(keyOffsetY) - 1);
+			AppendPackFloat(info.offsetY);
+			AppendPackString(keyWidth, sizeof(keyWidth) - 1);
+			AppendPackFloat(info.width);
+			AppendPackString(keyHeight, sizeof(keyHeight) - 1);
+			AppendPackFloat(info.height);
+			AppendPackString(keyLoop, sizeof(keyLoop) - 1);
+			AppendPackBool(info.bLoop);
+			AppendPackString(keyPatterns, sizeof(keyPatterns) - 1);
+			AppendPackArray(static_cast<uint32_t>(info.pattern.size()));
+
+			for (const AnimPatternData& ptn : info.pattern)
+			{
+				AppendPackMap(3);
+				AppendPackString(keyWait, sizeof(keyWait) - 1);
+				AppendPackFloat(ptn.wait);
+				AppendPackString(keyNo, sizeof(keyNo) - 1);
+				AppendPackInt(ptn.no);
+				AppendPackString(keyStep, sizeof(keyStep) - 1);
+				AppendPackInt(ptn.step);
+
+				FlushIfFull();
+			}
+			break;
+		}
+
+		++m_WriteCount;
+		FlushIfFull();
+	}
+
+	bool AnimExportWriter::Close(void)
+	{
+		if (m_WriteCount != m_AnimCount)
+		{
+			m_Buffer.clear();
+			m_Stream.Abort();
+			return false;
+		}
+
+		if (m_Format == AnimExportFormat::Json)
+		{
+			m_Buffer += "\n]}\n";
+		}
+
+		Flush();
+		return m_Stream.Commit();
+	}
+
+	uint64_t AnimExportWriter::WrittenSize(void) const
+	{
+		return m_WrittenSize;
+	}
+
+	size_t AnimExportWriter::MaxBufferSize(void) const
+	{
+		return m_MaxBufferSize;
+	}
+
+	void AnimExportWriter::AppendJsonString(const std::string& str)
+	{
+		static constexpr char hex[] = "0123456789abcdef";
+
+		m_Buffer += '"';
+		for (char c : str)
+		{
+			uint8_t code = static_cast<uint8_t>(c);
+			if (c == '"' || c == '\\')
+			{
+				m_Buffer += '\\';
+				m_Buffer += c;
+			}
+			else if (code < 0x20)
+			{
+				m_Buffer += "\\u00";
+				m_Buffer += hex[code >> 4];
+				m_Buffer += hex[code & 0x0F];
+			}
+			else
+			{
+				m_Buffer += c;
+			}
+		}
+		m_Buffer += '"';
+	}
+
+	void AnimExportWriter::AppendJsonNumber(float value)
+	{
+		//JSONにはNaNや無限大を書けないのでnullにする。
+		if (!std::isfinite(value))
+		{
+			m_Buffer += "null";
+			return;
+		}
+
+		//-0は0として書く。
+		if (value == 0.0f)
+		{
+			m_Buffer += '0';
+			return;
+		}
+
+		char buffer[32];
+		auto [pEnd, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		m_Buffer.append(buffer, pEnd);
+	}
+
+	void AnimExportWriter::AppendJsonNumber(int32_t value)
+	{
+		char buffer[16];
+		auto [pEnd, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		m_Buffer.append(buffer, pEnd);
+	}
+
+	void AnimExportWriter::AppendPackMap(uint32_t count)
+	{
+		if (count < 16)
+		{
+			m_Buffer += static_cast<char>(0x80 | count);
+		}
+		else if (count <= 0xFFFF)
+		{
+			m_Buffer += static_cast<char>(0xDE);
+			AppendBigEndian(m_Buffer, static_cast<uint16_t>(count));
+		}
+		else
+		{
+			m_Buffer += static_cast<char>(0xDF);
+			AppendBigEndian(m_Buffer, count);
+		}
+	}
+
+	void AnimExportWriter::AppendPackArray(uint32_t count)
+	{
+		if (count < 16)
+		{
+			m_Buffer += static_cast<char>(0x90 | count);
+		}
+		else if (count <= 0xFFFF)
+		{
+			m_Buffer += static_cast<char>(0xDC);
+			AppendBigEndian(m_Buffer, static_cast<uint16_t>(count));
+		}
+		else
+		{
+			m_Buffer += static_cast<char>(0xDD);
+			AppendBigEndian(m_Buffer, count);
+		}
+	}
+
+	void AnimExportWriter::AppendPackString(const char* str, size_t length)
+	{
+		if (length < 32)
+		{
+			m_Buffer += static_cast<char>(0xA0 | length);
+		}
+		else if (length <= 0xFF)
+		{
+			m_Buffer += static_cast<char>(0xD9);
+			m_Buffer += static_cast<char>(length);
+		}
+		else if (length <= 0xFFFF)
+		{
+			m_Buffer += static_cast<char>(0xDA);
+			AppendBigEndian(m_Buffer, static_cast<uint16_t>(length));
+		}
+		else
+		{
+			m_Buffer += static_cast<char>(0xDB);
+			AppendBigEndian(m_Buffer, static_cast<uint32_t>(length));
+		}
+		m_Buffer.append(str, length);
+	}
+
+	void AnimExportWriter::AppendPackString(const std::string& str)
+	{
+		AppendPackString(str.data(), str.size());
+	}
+
+	void AnimExportWriter::AppendPackFloat(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(float));
+
+		m_Buffer += static_cast<char>(0xCA);
+		AppendBigEndian(m_Buffer, bits);
+	}
+
+	void AnimExportWriter::AppendPackInt(int32_t value)
+	{
+		//一番短い表現を使う。
+		if (value >= 0 && value < 128)
+		{
+			m_Buffer += static_cast<char>(value);
+		}
+		else if (value < 0 && value >= -32)
+		{
+			m_Buffer += static_cast<char>(static_cast<uint8_t>(value));
+		}
+		else if (value >= INT16_MIN && value <= INT16_MAX)
+		{
+			m_Buffer += static_cast<char>(0xD1);
+			AppendBigEndian(m_Buffer, static_cast<uint16_t>(value));
+		}
+		else
+		{
+			m_Buffer += static_cast<char>(0xD2);
+			AppendBigEndian(m_Buffer, static_cast<uint32_t>(value));
+		}
+	}
+
+	void AnimExportWriter::AppendPackBool(bool value)
+	{
+		m_Buffer += static_cast<char>(value ? 0xC3 : 0xC2);
+	}
+
+	namespace AnimExport
+	{
+		const char* Extension(AnimExportFormat format)
+		{
+			return format == AnimExportFormat::Json ? ".json" : ".msgpack";
+		}
+
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc, AnimExportFormat format)
+		{
+			AnimExportWriter writer;
+			if (!writer.Open(path, format))
+			{
+				return false;
+			}
+
+			writer.BeginDocument(doc.textureName, doc.animations.size());
+			for (const AnimInfoData& info : doc.animations)
+			{
+				writer.WriteAnimation(info);
+			}
+			return writer.Close();
+		}
+	}
+}
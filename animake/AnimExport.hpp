@@ -0,0 +1,91 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+#include "AtomicFile.hpp"
+
+//UnityやGodotなど他のエンジンのツールから読めるJSONとMessagePackの書き出し。Siv3Dには依存しない。
+//全体を木構造にしてから書くのではなく、アニメーションを1つずつ受け取って一定サイズごとにファイルへ流すので、
+//パターンが何十万個あっても使うメモリはバッファ1つ分で済む。
+//
+//どちらの形式も同じ構造で、MessagePackはJSONのオブジェクトをmap、配列をarrayにしたもの。
+//    {
+//        "version": 1,
+//        "texture": "chara/player.png",
+//        "animations": [
+//            { "name": "NewAnimation1", "offsetX": 0, "offsetY": 0, "width": 60, "height": 70, "loop": true,
+//              "patterns": [ { "wait": 5, "no": 0, "step": 0 }, ... ] },
+//            ...
+//        ]
+//    }
+//文字列はUTF-8で書く。数値はfloatで表せる最短の表記(MessagePackはfloat32)なので.animと同じ値に戻る。
+
+namespace siapp
+{
+	enum class AnimExportFormat
+	{
+		Json,
+		MessagePack,
+	};
+
+	//アニメーションを順番に受け取ってファイルに書き出す。
+	//Open → BeginDocument → WriteAnimationをアニメーションの数だけ → Close の順に呼ぶ。
+	class AnimExportWriter
+	{
+	private:
+		AtomicFileStream             m_Stream;
+		AnimExportFormat             m_Format;
+		std::string                  m_Buffer;
+		size_t                       m_AnimCount;
+		size_t                       m_WriteCount;
+		uint64_t                     m_WrittenSize;
+		size_t                       m_MaxBufferSize;
+
+		void Flush(void);
+		void FlushIfFull(void);
+
+		void AppendJsonString(const std::string& str);
+		void AppendJsonNumber(float value);
+		void AppendJsonNumber(int32_t value);
+
+		void AppendPackMap(uint32_t count);
+		void AppendPackArray(uint32_t count);
+		void AppendPackString(const char* str, size_t length);
+		void AppendPackString(const std::string& str);
+		void AppendPackFloat(float value);
+		void AppendPackInt(int32_t value);
+		void AppendPackBool(bool value);
+	public:
+		//この大きさまで溜まったらファイルに書く。
+		static constexpr size_t      flushSize = 64 * 1024;
+
+		AnimExportWriter(void);
+		AnimExportWriter(const AnimExportWriter&) = delete;
+		AnimExportWriter& operator= (const AnimExportWriter&) = delete;
+
+		//一時ファイルを開く。(AtomicFile.hpp)
+		bool Open(const std::filesystem::path& path, AnimExportFormat format);
+
+		//textureNameは.animと同じ文字コードの文字列。MessagePackは先に要素数を書くのでアニメーションの数を渡す。
+		void BeginDocument(const std::string& textureName, size_t animCount);
+
+		//アニメーション1つ分を書く。BeginDocumentで渡した数だけ呼ぶこと。
+		void WriteAnimation(const AnimInfoData& info);
+
+		//残りを書き出して元のファイルと置き換える。呼んだ数が足りないか、書き込みに失敗していればfalseを返す。
+		bool Close(void);
+
+		//ここまでにファイルに書いたサイズ。
+		uint64_t WrittenSize(void) const;
+
+		//書き出しの途中で溜まったバッファの最大サイズ。
+		size_t MaxBufferSize(void) const;
+	};
+
+	namespace AnimExport
+	{
+		//ファイル名の拡張子。(".json", ".msgpack")
+		const char* Extension(AnimExportFormat format);
+
+		//読み込み済みのAnimDocumentをまとめて書き出す。ツール用。
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc, AnimExportFormat format);
+	}
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <cstdint>
+
+//フレーム1つ分の切り出し矩形を計算する。Siv3Dには依存しない。
+//エディタ(AnimationModel.hpp、double)と書き出しやゲーム側(AnimationBank.hpp、float)で同じ式を使うようにここにまとめる。
+
+namespace siapp
+{
+	//切り出し矩形(ピクセル)と、それを画像の大きさで割ったUV。
+	template<class T>
+	struct BasicFrameRect
+	{
+		T                            srcX    = 0;
+		T                            srcY    = 0;
+		T                            srcW    = 0;
+		T                            srcH    = 0;
+		T                            u0      = 0;
+		T                            v0      = 0;
+		T                            u1      = 0;
+		T                            v1      = 0;
+	};
+
+	using AnimFrameRect = BasicFrameRect<float>;
+
+	//画像の大きさが分からない(0)間はUVを0にしておく。
+	template<class T>
+	BasicFrameRect<T> BakeFrameRect(T offsetX, T offsetY, T width, T height, int32_t no, int32_t step, T textureWidth, T textureHeight)
+	{
+		BasicFrameRect<T> rect;
+		rect.srcX = offsetX + static_cast<T>(no) * width;
+		rect.srcY = offsetY + static_cast<T>(step) * height;
+		rect.srcW = width;
+		rect.srcH = height;
+
+		if (textureWidth > 0 && textureHeight > 0)
+		{
+			rect.u0 = rect.srcX / textureWidth;
+			rect.v0 = rect.srcY / textureHeight;
+			rect.u1 = (rect.srcX + width) / textureWidth;
+			rect.v1 = (rect.srcY + height) / textureHeight;
+		}
+		return rect;
+	}
+}
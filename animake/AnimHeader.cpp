@@ -0,0 +1,384 @@
+﻿#include "AnimHeader.hpp"
+#include "AnimText.hpp"
+#include "AtomicFile.hpp"
+#include <charconv>
+#include <cstdio>
+#include <set>
+#include <string_view>
+
+namespace siapp
+{
+	namespace
+	{
+		constexpr char utf8Bom[] = "\xEF\xBB\xBF";
+
+		//どのヘッダーにも入る型と索引の関数。複数のヘッダーを同時にincludeできるようにガードしておく。
+		constexpr char headerTypes[] =
+			"#ifndef ANIMAKE_ANIMATION_TABLE_TYPES\n"
+			"#define ANIMAKE_ANIMATION_TABLE_TYPES\n"
+			"namespace animake\n"
+			"{\n"
+			"\t//frame of an animation. src* is the rectangle cut out of the texture.\n"
+			"\tstruct AnimFrame\n"
+			"\t{\n"
+			"\t\tfloat            wait;\n"
+			"\t\tint32_t          no;\n"
+			"\t\tint32_t          step;\n"
+			"\t\tfloat            srcX;\n"
+			"\t\tfloat            srcY;\n"
+			"\t\tfloat            srcW;\n"
+			"\t\tfloat            srcH;\n"
+			"\t};\n"
+			"\n"
+			"\tstruct Animation\n"
+			"\t{\n"
+			"\t\tstd::string_view name;\n"
+			"\t\tconst AnimFrame* frames;\n"
+			"\t\tuint32_t         frameCount;\n"
+			"\t\tbool             loop;\n"
+			"\t\tfloat            offsetX;\n"
+			"\t\tfloat            offsetY;\n"
+			"\t\tfloat            width;\n"
+			"\t\tfloat            height;\n"
+			"\t};\n"
+			"\n"
+			"\tstruct AnimNameIndex\n"
+			"\t{\n"
+			"\t\tuint32_t         hash;\n"
+			"\t\tuint32_t         index;\n"
+			"\t};\n"
+			"\n"
+			"\t//FNV-1a\n"
+			"\tconstexpr uint32_t HashName(std::string_view name)\n"
+			"\t{\n"
+			"\t\tuint32_t hash = 2166136261u;\n"
+			"\t\tfor (char c : name)\n"
+			"\t\t{\n"
+			"\t\t\thash ^= static_cast<uint8_t>(c);\n"
+			"\t\t\thash *= 16777619u;\n"
+			"\t\t}\n"
+			"\t\treturn hash;\n"
+			"\t}\n"
+			"\n"
+			"\t//name hashes sorted at compile time.\n"
+			"\ttemplate<size_t N>\n"
+			"\tconstexpr std::array<AnimNameIndex, N> MakeNameTable(const Animation (&animations)[N])\n"
+			"\t{\n"
+			"\t\tstd::array<AnimNameIndex, N> table = {};\n"
+			"\t\tfor (size_t i = 0; i < N; ++i)\n"
+			"\t\t{\n"
+			"\t\t\tAnimNameIndex entry = { HashName(animations[i].name), static_cast<uint32_t>(i) };\n"
+			"\t\t\tsize_t j = i;\n"
+			"\t\t\tfor (; j > 0 && table[j - 1].hash > entry.hash; --j)\n"
+			"\t\t\t{\n"
+			"\t\t\t\ttable[j] = table[j - 1];\n"
+			"\t\t\t}\n"
+			"\t\t\ttable[j] = entry;\n"
+			"\t\t}\n"
+			"\t\treturn table;\n"
+			"\t}\n"
+			"\n"
+			"\t//binary search by hash, then compare names in the run of equal hashes.\n"
+			"\t//equal hashes keep the order of animations, so the first of duplicated names is found.\n"
+			"\ttemplate<size_t N>\n"
+			"\tconstexpr int FindAnimation(const std::array<AnimNameIndex, N>& table, const Animation (&animations)[N], std::string_view name)\n"
+			"\t{\n"
+			"\t\tuint32_t hash  = HashName(name);\n"
+			"\t\tsize_t   begin = 0;\n"
+			"\t\tsize_t   end   = N;\n"
+			"\t\twhile (begin < end)\n"
+			"\t\t{\n"
+			"\t\t\tsize_t mid = begin + (end - begin) / 2;\n"
+			"\t\t\tif (table[mid].hash < hash)\n"
+			"\t\t\t{\n"
+			"\t\t\t\tbegin = mid + 1;\n"
+			"\t\t\t}\n"
+			"\t\t\telse\n"
+			"\t\t\t{\n"
+			"\t\t\t\tend = mid;\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t\tfor (; begin < N && table[begin].hash == hash; ++begin)\n"
+			"\t\t{\n"
+			"\t\t\tif (animations[table[begin].index].name == name)\n"
+			"\t\t\t{\n"
+			"\t\t\t\treturn static_cast<int>(table[begin].index);\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t\treturn -1;\n"
+			"\t}\n"
+			"}\n"
+			"#endif\n";
+
+		//C++の予約語。(代替表記を含む) 識別子にすると生成したヘッダーがコンパイルできなくなる。
+		const std::set<std::string_view> cppKeywords =
+		{
+			"alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break",
+			"case", "catch", "char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const",
+			"consteval", "constexpr", "constinit", "const_cast", "continue", "co_await", "co_return", "co_yield", "decltype", "default",
+			"delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+			"float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace",
+			"new", "noexcept", "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected",
+			"public", "register", "reinterpret_cast", "requires", "return", "short", "signed", "sizeof", "static", "static_assert",
+			"static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef",
+			"typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while",
+			"xor", "xor_eq",
+		};
+
+		bool IsIdentifierChar(char c)
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+		}
+
+		//文字列リテラルとして書き足す。8進数のエスケープは後ろの文字とつながらないように3桁で書く。
+		void AppendStringLiteral(std::string& out, const std::string& str)
+		{
+			out += '"';
+			for (char c : str)
+			{
+				unsigned char uc = static_cast<unsigned char>(c);
+				if (c == '"' || c == '\\')
+				{
+					out += '\\';
+					out += c;
+				}
+				else if (uc < 0x20 || uc == 0x7F)
+				{
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\%03o", uc);
+					out += buffer;
+				}
+				else
+				{
+					out += c;
+				}
+			}
+			out += '"';
+		}
+	}
+
+	namespace AnimHeader
+	{
+		bool MakeIdentifier(const std::string& str, std::string& outIdentifier)
+		{
+			outIdentifier.clear();
+
+			bool bValid = false;
+			for (char c : str)
+			{
+				//ASCII以外の文字は識別子にしない。
+				if (static_cast<unsigned char>(c) >= 0x80)
+				{
+					outIdentifier.clear();
+					return false;
+				}
+
+				if (IsIdentifierChar(c))
+				{
+					outIdentifier += c;
+					bValid = true;
+				}
+				else
+				{
+					outIdentifier += '_';
+				}
+			}
+
+			if (!bValid)
+			{
+				outIdentifier.clear();
+				return false;
+			}
+
+			//数字から始まる名前や、予約されている'_'+大文字の名前にならないようにする。
+			if ((outIdentifier[0] >= '0' && outIdentifier[0] <= '9') || outIdentifier[0] == '_')
+			{
+				outIdentifier.insert(0, "id");
+			}
+
+			//予約語と、'_'が2つ続く予約された名前は識別子にしない。
+			if (cppKeywords.count(outIdentifier) != 0 || outIdentifier.find("__") != std::string::npos)
+			{
+				outIdentifier.clear();
+				return false;
+			}
+			return true;
+		}
+
+		void AppendFloatLiteral(std::string& out, float value)
+		{
+			//floatとして同じ値に戻る最短の表記で書く。
+			char buffer[64];
+			auto [pEnd, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			if (ec != std::errc())
+			{
+				out += "0.0f";
+				return;
+			}
+
+			std::string_view str(buffer, static_cast<size_t>(pEnd - buffer));
+			out.append(str);
+			if (str.find_first_of(".e") == std::string_view::npos)
+			{
+				out += ".0";
+			}
+			out += 'f';
+		}
+
+		bool Export(const AnimDocument& doc, const std::string& namespaceName, std::string& outText)
+		{
+			return Export(AnimationBank(doc), doc.textureName, namespaceName, outText);
+		}
+
+		bool Export(const AnimationBank& bank, const std::string& textureName, const std::string& namespaceName, std::string& outText)
+		{
+			outText.clear();
+
+			size_t animCount  = bank.AnimCount();
+			size_t frameCount = bank.PatternCount();
+			if (animCount == 0)
+			{
+				return false;
+			}
+
+			//1フレーム分の文字数の目安で確保しておく。
+			outText.reserve(4096 + frameCount * 64 + animCount * 128);
+
+			outText += utf8Bom;
+			outText += "//Generated by AniMake. Changes are overwritten when the animation is saved again.\n";
+			outText += "#pragma once\n";
+			outText += "#include <array>\n";
+			outText += "#include <cstddef>\n";
+			outText += "#include <cstdint>\n";
+			outText += "#include <string_view>\n\n";
+			outText += headerTypes;
+			outText += "\nnamespace ";
+			outText += namespaceName;
+			outText += "\n{\n";
+
+			outText += "\tinline constexpr std::string_view textureName = ";
+			AppendStringLiteral(outText, AnimText::NativeToUtf8(textureName));
+			outText += ";\n\n";
+
+			//全てのアニメーションのフレームを1つの配列に並べ、切り出し矩形はAnimationBankで計算済みのものを書く。
+			//並びはAnimationBankのパターン配列と同じなので、そのまま先頭から書いていく。
+			outText += "\tinline constexpr animake::AnimFrame frames[] =\n\t{\n";
+			const std::vector<AnimPatternData>& patterns   = bank.PatternPool();
+			const std::vector<AnimFrameRect>&   frameRects = bank.FrameRectPool();
+			for (size_t j = 0; j < frameCount; ++j)
+			{
+				const AnimPatternData& ptn  = patterns[j];
+				const AnimFrameRect&   rect = frameRects[j];
+
+				outText += "\t\t{ ";
+				AppendFloatLiteral(outText, ptn.wait);
+				outText += ", ";
+				AnimText::AppendNumber(outText, ptn.no);
+				outText += ", ";
+				AnimText::AppendNumber(outText, ptn.step);
+				outText += ", ";
+				AppendFloatLiteral(outText, rect.srcX);
+				outText += ", ";
+				AppendFloatLiteral(outText, rect.srcY);
+				outText += ", ";
+				AppendFloatLiteral(outText, rect.srcW);
+				outText += ", ";
+				AppendFloatLiteral(outText, rect.srcH);
+				outText += " },\n";
+			}
+			//空の配列は作れないので、パターンが1つもなければ使わないフレームを置いておく。
+			if (frameCount == 0)
+			{
+				outText += "\t\t{},\n";
+			}
+			outText += "\t};\n\n";
+
+			outText += "\tinline constexpr animake::Animation animations[] =\n\t{\n";
+			for (size_t i = 0; i < animCount; ++i)
+			{
+				outText += "\t\t{ ";
+				AppendStringLiteral(outText, AnimText::NativeToUtf8(bank.Name(i)));
+				outText += ", frames + ";
+				outText += std::to_string(bank.PatternOffset(i));
+				outText += ", ";
+				outText += std::to_string(bank.Patterns(i).size());
+				outText += bank.IsLoop(i) ? ", true, " : ", false, ";
+				AppendFloatLiteral(outText, bank.OffsetX(i));
+				outText += ", ";
+				AppendFloatLiteral(outText, bank.OffsetY(i));
+				outText += ", ";
+				AppendFloatLiteral(outText, bank.Width(i));
+				outText += ", ";
+				AppendFloatLiteral(outText, bank.Height(i));
+				outText += " },\n";
+			}
+			outText += "\t};\n\n";
+
+			outText += "\tinline constexpr size_t animationCount = ";
+			outText += std::to_string(animCount);
+			outText += ";\n\n";
+
+			//名前からの索引はコンパイル時に作る。同じ名前やハッシュが重なる名前があっても引ける。
+			outText += "\tinline constexpr auto nameTable = animake::MakeNameTable(animations);\n\n";
+			outText += "\t//returns -1 if not found, or the first one if the name is duplicated. evaluated at compile time when called with a literal.\n";
+			outText += "\tconstexpr int FindAnimation(std::string_view name)\n\t{\n";
+			outText += "\t\treturn animake::FindAnimation(nameTable, animations, name);\n\t}\n\n";
+
+			//識別子にできない名前や重なる名前は番号で呼べるようにする。
+			//先に名前をそのまま使えるものを決めてから、残りに番号の名前を付ける。番号の名前も他と重ならなくなるまで後ろに番号を足す。
+			std::vector<std::string> identifiers(animCount);
+			std::set<std::string> usedIdentifiers;
+			for (size_t i = 0; i < animCount; ++i)
+			{
+				std::string identifier;
+				if (MakeIdentifier(bank.Name(i), identifier) && usedIdentifiers.insert(identifier).second)
+				{
+					identifiers[i] = std::move(identifier);
+				}
+			}
+			for (size_t i = 0; i < animCount; ++i)
+			{
+				if (!identifiers[i].empty())
+				{
+					continue;
+				}
+
+				std::string identifier = "Animation" + std::to_string(i);
+				for (int suffix = 1; !usedIdentifiers.insert(identifier).second; ++suffix)
+				{
+					identifier = "Animation" + std::to_string(i) + "_" + std::to_string(suffix);
+				}
+				identifiers[i] = std::move(identifier);
+			}
+
+			outText += "\tenum class AnimationId : uint32_t\n\t{\n";
+			for (size_t i = 0; i < animCount; ++i)
+			{
+				outText += "\t\t";
+				outText += identifiers[i];
+				outText += " = ";
+				outText += std::to_string(i);
+				outText += ",\n";
+			}
+			outText += "\t};\n";
+			outText += "}\n";
+			return true;
+		}
+
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc)
+		{
+			std::string namespaceName;
+			if (!MakeIdentifier(path.stem().string(), namespaceName))
+			{
+				namespaceName = "animation";
+			}
+
+			std::string text;
+			if (!Export(doc, namespaceName, text))
+			{
+				return false;
+			}
+			return AtomicFile::Write(path, text.data(), text.size());
+		}
+	}
+}
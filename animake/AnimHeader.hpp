@@ -0,0 +1,47 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+#include "AnimationBank.hpp"
+
+//ゲーム側のコードにそのままincludeできるC++ヘッダーの書き出し。Siv3Dには依存しない。
+//フレームごとの切り出し矩形を計算済みのconstexpr配列と、コンパイル時に作る名前からの索引を出力する。
+//ゲーム側では初期化処理もヒープ確保もなしに参照できる。
+//
+//出力例:
+//    namespace example
+//    {
+//        inline constexpr animake::AnimFrame frames[] =
+//        {
+//            { 5.0f, 0, 0, 0.0f, 0.0f, 60.0f, 70.0f },
+//            ...
+//        };
+//        inline constexpr animake::Animation animations[] =
+//        {
+//            { "NewAnimation1", frames + 0, 4, true, 0.0f, 0.0f, 60.0f, 70.0f },
+//            ...
+//        };
+//        constexpr int FindAnimation(std::string_view name);  //見つからなければ-1。同じ名前が並んでいれば前のもの
+//        enum class AnimationId : uint32_t { NewAnimation1 = 0, ... };
+//    }
+//名前は.txtと同じくBOM付きのUTF-8で書くので、ゲーム側の文字列リテラルと同じ文字コードで比べられる。
+
+namespace siapp
+{
+	namespace AnimHeader
+	{
+		//文字列をC++の識別子として使える形にする。使えない記号は'_'にし、ASCII以外の文字を含む場合や予約語になる場合はfalseを返す。
+		bool MakeIdentifier(const std::string& str, std::string& outIdentifier);
+
+		//floatをC++のfloatリテラルとして書き足す。(例: 5.0f, 0.1f)
+		void AppendFloatLiteral(std::string& out, float value);
+
+		//ヘッダーの中身をメモリ上に作る。データはnamespaceNameの名前空間に入れる。
+		//アニメーションが1つもない場合は配列を作れないのでfalseを返す。
+		bool Export(const AnimDocument& doc, const std::string& namespaceName, std::string& outText);
+
+		//AnimationBankから作る。フレームの配列はパターン配列と同じ並びになる。
+		bool Export(const AnimationBank& bank, const std::string& textureName, const std::string& namespaceName, std::string& outText);
+
+		//Exportした結果を一度の書き込みで保存する。名前空間はファイル名から作る。(AtomicFile.hpp)
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc);
+	}
+}
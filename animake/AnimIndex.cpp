@@ -0,0 +1,250 @@
+﻿#include "AnimIndex.hpp"
+#include "AnimCompact.hpp"
+#include "AnimZstd.hpp"
+#include "BufferIO.hpp"
+
+namespace siapp
+{
+	AnimIndex::AnimIndex(void) :
+		m_File(),
+		m_Buffer(),
+		m_pData(nullptr),
+		m_Size(0),
+		m_bCompressed(false),
+		m_Format(AnimFormat::Legacy),
+		m_View(),
+		m_TextureName(),
+		m_TextName(),
+		m_Arena(),
+		m_pEntries(nullptr),
+		m_EntryCount(0)
+	{
+	}
+
+	void AnimIndex::AllocateEntries(size_t count)
+	{
+		m_pEntries   = m_Arena.AllocateArray<AnimIndexEntry>(count);
+		m_EntryCount = count;
+	}
+
+	bool AnimIndex::Open(const std::filesystem::path& path, AnimIndexSource source)
+	{
+		Close();
+
+		if (source == AnimIndexSource::Owned)
+		{
+			//一度で読み込んでファイルはすぐに閉じる。圧縮ファイルならメモリ上で展開する。
+			if (!AnimCodec::ReadFile(path, m_Buffer) || m_Buffer.empty())
+			{
+				Close();
+				return false;
+			}
+
+			if (AnimZstd::IsCompressed(m_Buffer.data(), m_Buffer.size()))
+			{
+				std::vector<uint8_t> raw;
+				m_bCompressed = true;
+				if (!AnimZstd::Decompress(m_Buffer.data(), m_Buffer.size(), raw) || raw.empty() || AnimZstd::IsCompressed(raw.data(), raw.size()))
+				{
+					Close();
+					return false;
+				}
+				m_Buffer.swap(raw);
+			}
+			m_pData = m_Buffer.data();
+			m_Size  = m_Buffer.size();
+		}
+		else
+		{
+			if (!m_File.Open(path))
+			{
+				return false;
+			}
+
+			m_pData = m_File.Data();
+			m_Size  = m_File.Size();
+		}
+
+		//圧縮ファイルならマップは閉じて、展開したバッファを索引の対象にする。
+		if (source == AnimIndexSource::Mapped && AnimZstd::IsCompressed(m_pData, m_Size))
+		{
+			m_File.Close();
+			m_bCompressed = true;
+			if (!AnimZstd::DecompressFile(path, m_Buffer) || AnimZstd::IsCompressed(m_Buffer.data(), m_Buffer.size()))
+			{
+				Close();
+				return false;
+			}
+			m_pData = m_Buffer.data();
+			m_Size  = m_Buffer.size();
+		}
+
+		const uint8_t* data = m_pData;
+		size_t size         = m_Size;
+
+		m_Format = AnimCodec::Detect(data, size);
+
+		if (m_Format == AnimFormat::Flat)
+		{
+			//v2形式はテーブルがそのまま索引になる。
+			if (!m_View.Open(data, size))
+			{
+				Close();
+				return false;
+			}
+
+			m_TextureName = m_View.TextureName();
+			m_TextName    = m_View.TextName();
+			AllocateEntries(m_View.AnimCount());
+			for (uint32_t i = 0; i < m_View.AnimCount(); ++i)
+			{
+				m_pEntries[i].name   = m_View.Name(i);
+				m_pEntries[i].offset = i;
+			}
+			return true;
+		}
+
+		//コンパクト形式はアニメーションごとのバイト数を見て、名前だけ読んで飛ばす。
+		if (m_Format == AnimFormat::Compact)
+		{
+			size_t pos;
+			size_t animCount;
+			//アニメーション1つ分は少なくとも1バイトあるので、残りより多い数は壊れている。
+			if (!AnimCompact::DecodeHeader(data, size, pos, m_TextureName, m_TextName, animCount) || animCount > size - pos)
+			{
+				Close();
+				return false;
+			}
+
+			AllocateEntries(animCount);
+			for (size_t i = 0; i < m_EntryCount; ++i)
+			{
+				AnimIndexEntry& entry = m_pEntries[i];
+				entry.offset = pos;
+				if (!AnimCompact::SkipAnimation(data, size, pos, entry.name))
+				{
+					Close();
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//従来の形式は名前を読んでパターンを飛ばしながら位置を記録する。
+		BufferReader br(data, size);
+
+		int32_t animCount;
+		if (!br.ReadString(m_TextureName) || !br.Read(animCount) || animCount < 0 || static_cast<size_t>(animCount) > br.Remain())
+		{
+			Close();
+			return false;
+		}
+
+		AllocateEntries(static_cast<size_t>(animCount));
+
+		size_t pos = br.Pos();
+		for (size_t i = 0; i < m_EntryCount; ++i)
+		{
+			AnimIndexEntry& entry = m_pEntries[i];
+			entry.offset = pos;
+			if (!AnimCodec::SkipLegacyAnimation(data, size, pos, entry.name))
+			{
+				Close();
+				return false;
+			}
+		}
+
+		br = BufferReader(data, size, pos);
+
+		//テキスト出力に対応する前のファイルにはテキストファイル名がない。
+		//表示にしか使わないので、途中で切れていて読めない時も空にして開く。(AnimCodec::DecodeLegacyと同じ)
+		if (br.Remain() != 0 && !br.ReadString(m_TextName))
+		{
+			m_TextName.clear();
+		}
+		return true;
+	}
+
+	void AnimIndex::Close(void)
+	{
+		m_File.Close();
+		m_Buffer.clear();
+		m_Buffer.shrink_to_fit();
+		m_pData       = nullptr;
+		m_Size        = 0;
+		m_bCompressed = false;
+		m_View        = AnimV2View();
+		m_TextureName.clear();
+		m_TextName.clear();
+		m_Arena.Reset();
+		m_pEntries   = nullptr;
+		m_EntryCount = 0;
+	}
+
+	bool AnimIndex::IsOpen(void) const
+	{
+		return m_pData != nullptr;
+	}
+
+	AnimFormat AnimIndex::Format(void) const
+	{
+		return m_Format;
+	}
+
+	bool AnimIndex::IsCompressed(void) const
+	{
+		return m_bCompressed;
+	}
+
+	size_t AnimIndex::AnimCount(void) const
+	{
+		return m_EntryCount;
+	}
+
+	std::string_view AnimIndex::Name(size_t index) const
+	{
+		return m_pEntries[index].name;
+	}
+
+	const std::string& AnimIndex::TextureName(void) const
+	{
+		return m_TextureName;
+	}
+
+	const std::string& AnimIndex::TextName(void) const
+	{
+		return m_TextName;
+	}
+
+	bool AnimIndex::DecodeAnimation(size_t index, AnimInfoData& outInfo) const
+	{
+		if (index >= m_EntryCount)
+		{
+			return false;
+		}
+
+		const AnimIndexEntry& entry = m_pEntries[index];
+
+		if (m_Format == AnimFormat::Flat)
+		{
+			uint32_t i                 = static_cast<uint32_t>(entry.offset);
+			const AnimV2Record& record = m_View.Record(i);
+
+			outInfo.name    = entry.name;
+			outInfo.offsetX = record.offsetX;
+			outInfo.offsetY = record.offsetY;
+			outInfo.width   = record.width;
+			outInfo.height  = record.height;
+			outInfo.bLoop   = m_View.IsLoop(i);
+			outInfo.pattern.assign(m_View.Patterns(i), m_View.Patterns(i) + m_View.PatternCount(i));
+			return true;
+		}
+
+		size_t pos = entry.offset;
+		if (m_Format == AnimFormat::Compact)
+		{
+			return AnimCompact::DecodeAnimation(m_pData, m_Size, pos, outInfo);
+		}
+		return AnimCodec::DecodeLegacyAnimation(m_pData, m_Size, pos, outInfo);
+	}
+}
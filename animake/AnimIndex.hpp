@@ -0,0 +1,67 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+#include "AnimV2.hpp"
+#include "DocumentArena.hpp"
+#include "MappedFile.hpp"
+
+namespace siapp
+{
+	//アニメーション名とデータ位置の索引。名前はマップしたファイルか展開したバッファの中を直接指す。
+	struct AnimIndexEntry
+	{
+		std::string_view             name;
+		size_t                       offset  = 0;  //従来の形式とコンパクト形式ならファイル内の位置、v2形式ならレコード番号
+	};
+
+	//ファイルの中身をどう持つか。
+	enum class AnimIndexSource
+	{
+		Mapped,                                          //マップしたままにする。読むだけのツールやパック向け
+		Owned,                                           //一度で読み込んだバッファを持ち、ファイルは開いたままにしない
+	};
+
+	//.animファイルの名前と位置の索引だけを作り、中身は必要になった時にデコードする。
+	//Mappedで開くとファイルはマップしたままになり、他のプロセスから書き換えられなくなる。同じファイルに書き込む前にCloseしておくこと。
+	//エディタのように開いたまま外で書き換えられるかもしれない場合はOwnedで開く。
+	//圧縮ファイルは少しずつ読みながら展開したものを保持する。
+	//索引の表はDocumentArenaに置き、名前はデータを直接参照するので、開く時のメモリ確保はアニメーションの数によらない。
+	//Closeで表の領域をまとめて手放し、次に開くファイルでは同じ領域を使い回す。
+	class AnimIndex
+	{
+	private:
+		MappedFile                   m_File;
+		std::vector<uint8_t>         m_Buffer;           //Ownedで読み込んだものか、圧縮ファイルを展開したもの
+		const uint8_t*               m_pData;
+		size_t                       m_Size;
+		bool                         m_bCompressed;
+		AnimFormat                   m_Format;
+		AnimV2View                   m_View;
+		std::string                  m_TextureName;
+		std::string                  m_TextName;
+		DocumentArena                m_Arena;
+		AnimIndexEntry*              m_pEntries;
+		size_t                       m_EntryCount;
+
+		//索引の表をm_Arenaから確保する。
+		void AllocateEntries(size_t count);
+	public:
+		AnimIndex(void);
+		AnimIndex(const AnimIndex&) = delete;
+		AnimIndex& operator= (const AnimIndex&) = delete;
+
+		//ファイルを開いて索引を作る。パターンデータには触れない。
+		bool Open(const std::filesystem::path& path, AnimIndexSource source = AnimIndexSource::Mapped);
+		void Close(void);
+		bool IsOpen(void) const;
+
+		AnimFormat Format(void) const;
+		bool IsCompressed(void) const;
+		size_t AnimCount(void) const;
+		std::string_view Name(size_t index) const;
+		const std::string& TextureName(void) const;
+		const std::string& TextName(void) const;
+
+		//アニメーション1つ分をデコードする。
+		bool DecodeAnimation(size_t index, AnimInfoData& outInfo) const;
+	};
+}
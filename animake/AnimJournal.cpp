@@ -0,0 +1,329 @@
+﻿#include "AnimJournal.hpp"
+#include "AnimZstd.hpp"
+#include "AtomicFile.hpp"
+#include "BufferIO.hpp"
+#include "MappedFile.hpp"
+
+namespace siapp
+{
+	namespace
+	{
+		constexpr char     animJournalMagic[4]  = { 'A', 'N', 'M', 'J' };
+		constexpr uint32_t animJournalVersion   = 1;
+
+		constexpr uint64_t fnvOffsetBasis       = 14695981039346656037ull;
+		constexpr uint64_t fnvPrime             = 1099511628211ull;
+
+		//変更1つ分の前後に付く情報のサイズ。(種類 + 中身のサイズ + チェックサム)
+		constexpr size_t   recordFrameSize      = sizeof(uint32_t) * 2 + sizeof(uint64_t);
+
+		bool HashFile(const std::filesystem::path& path, uint64_t& outSize, uint64_t& outHash)
+		{
+			MappedFile file;
+			if (!file.Open(path))
+			{
+				return false;
+			}
+			outSize = file.Size();
+			outHash = AnimJournal::Hash(file.Data(), file.Size());
+			return true;
+		}
+
+		bool DecodeRecord(AnimJournalOp op, const uint8_t* data, size_t size, AnimJournalRecord& outRecord)
+		{
+			BufferReader br(data, size);
+
+			outRecord.op = op;
+
+			switch (op)
+			{
+			case AnimJournalOp::SetAnimation:
+			{
+				if (!br.Read(outRecord.animIndex))
+				{
+					return false;
+				}
+				size_t pos = br.Pos();
+				return AnimCodec::DecodeLegacyAnimation(data, size, pos, outRecord.info) && pos == size;
+			}
+			case AnimJournalOp::RemoveAnimation:
+				return br.Read(outRecord.animIndex) && br.Remain() == 0;
+			case AnimJournalOp::SetPattern:
+				return br.Read(outRecord.animIndex)    &&
+					br.Read(outRecord.patternIndex)    &&
+					br.Read(outRecord.pattern.wait)    &&
+					br.Read(outRecord.pattern.no)      &&
+					br.Read(outRecord.pattern.step)    &&
+					br.Remain() == 0;
+			case AnimJournalOp::SetTexture:
+				return br.ReadString(outRecord.textureName) && br.Remain() == 0;
+			default:
+				return false;
+			}
+		}
+	}
+
+	namespace AnimJournal
+	{
+		std::filesystem::path JournalPath(const std::filesystem::path& animPath)
+		{
+			std::filesystem::path journalPath = animPath;
+			journalPath += ".journal";
+			return journalPath;
+		}
+
+		uint64_t Hash(const uint8_t* data, size_t size)
+		{
+			uint64_t hash = fnvOffsetBasis;
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash ^= data[i];
+				hash *= fnvPrime;
+			}
+			return hash;
+		}
+
+		bool Create(const std::filesystem::path& animPath, const uint8_t* baseData, size_t baseSize)
+		{
+			AnimJournalHeader header = {};
+			std::memcpy(header.magic, animJournalMagic, sizeof(animJournalMagic));
+			header.version  = animJournalVersion;
+			header.baseSize = baseSize;
+			header.baseHash = Hash(baseData, baseSize);
+
+			return AtomicFile::Write(JournalPath(animPath), &header, sizeof(AnimJournalHeader));
+		}
+
+		void Remove(const std::filesystem::path& animPath)
+		{
+			std::error_code ec;
+			std::filesystem::remove(JournalPath(animPath), ec);
+		}
+
+		void EncodeRecord(const AnimJournalRecord& record, std::vector<uint8_t>& outBuffer)
+		{
+			/// ###          変更1つ分の並びは以下の通り              ###
+			//     ・種類                        ( uint32 )
+			//     ・中身のサイズ                ( uint32 )
+			//     ・中身                        ( 種類ごとに違う )
+			//         SetAnimation    : アニメーション番号( uint32 ) + 従来の形式のアニメーション1つ分
+			//         RemoveAnimation : アニメーション番号( uint32 )
+			//         SetPattern      : アニメーション番号( uint32 ) + パターン番号( uint32 ) + パターン1つ分
+			//         SetTexture      : 画像ファイル名(長さ付き)
+			//     ・チェックサム                ( uint64 ) 種類から中身までのハッシュ
+			size_t begin = outBuffer.size();
+
+			BufferWriter bw(outBuffer);
+			bw.Write(static_cast<uint32_t>(record.op));
+			bw.Write(static_cast<uint32_t>(0));
+
+			switch (record.op)
+			{
+			case AnimJournalOp::SetAnimation:
+				bw.Write(record.animIndex);
+				AnimCodec::EncodeLegacyAnimation(record.info, outBuffer);
+				break;
+			case AnimJournalOp::RemoveAnimation:
+				bw.Write(record.animIndex);
+				break;
+			case AnimJournalOp::SetPattern:
+				bw.Write(record.animIndex);
+				bw.Write(record.patternIndex);
+				bw.Write(record.pattern.wait);
+				bw.Write(record.pattern.no);
+				bw.Write(record.pattern.step);
+				break;
+			case AnimJournalOp::SetTexture:
+				bw.WriteString(record.textureName);
+				break;
+			}
+
+			//中身のサイズを後から埋める。
+			uint32_t payloadSize = static_cast<uint32_t>(outBuffer.size() - begin - sizeof(uint32_t) * 2);
+			std::memcpy(outBuffer.data() + begin + sizeof(uint32_t), &payloadSize, sizeof(uint32_t));
+
+			bw.Write(Hash(outBuffer.data() + begin, outBuffer.size() - begin));
+		}
+
+		bool Append(const std::filesystem::path& animPath, const std::vector<uint8_t>& records, uint64_t validSize)
+		{
+			std::filesystem::path journalPath = JournalPath(animPath);
+
+			std::error_code ec;
+			uint64_t fileSize = std::filesystem::file_size(journalPath, ec);
+			if (ec || fileSize < validSize)
+			{
+				return false;
+			}
+
+			//前回途中で落ちた時の途切れたデータを切り捨ててから書き足す。
+			if (fileSize != validSize)
+			{
+				std::filesystem::resize_file(journalPath, validSize, ec);
+				if (ec)
+				{
+					return false;
+				}
+			}
+
+			return AtomicFile::Append(journalPath, records.data(), records.size());
+		}
+
+		bool Read(const std::filesystem::path& animPath, std::vector<AnimJournalRecord>& outRecords, uint64_t& outValidSize)
+		{
+			outRecords.clear();
+			outValidSize = 0;
+
+			std::vector<uint8_t> buffer;
+			if (!AnimCodec::ReadFile(JournalPath(animPath), buffer))
+			{
+				return false;
+			}
+
+			AnimJournalHeader header;
+			BufferReader br(buffer.data(), buffer.size());
+			if (!br.Read(header) ||
+				std::memcmp(header.magic, animJournalMagic, sizeof(animJournalMagic)) != 0 ||
+				header.version != animJournalVersion)
+			{
+				return false;
+			}
+
+			//.animを書き直した後に古いジャーナルが残っていても使わない。
+			uint64_t baseSize;
+			uint64_t baseHash;
+			if (!HashFile(animPath, baseSize, baseHash) || baseSize != header.baseSize || baseHash != header.baseHash)
+			{
+				return false;
+			}
+
+			outValidSize = br.Pos();
+
+			while (br.Remain() >= recordFrameSize)
+			{
+				size_t   begin = br.Pos();
+				uint32_t op;
+				uint32_t payloadSize;
+				br.Read(op);
+				br.Read(payloadSize);
+
+				uint64_t checksum = 0;
+				if (br.Remain() < static_cast<size_t>(payloadSize) + sizeof(uint64_t))
+				{
+					break;
+				}
+				const uint8_t* payload = br.Current();
+				br.Skip(payloadSize);
+				br.Read(checksum);
+
+				//書き込み途中で落ちた変更はここで止める。
+				if (checksum != Hash(buffer.data() + begin, sizeof(uint32_t) * 2 + payloadSize))
+				{
+					break;
+				}
+
+				AnimJournalRecord record;
+				if (!DecodeRecord(static_cast<AnimJournalOp>(op), payload, payloadSize, record))
+				{
+					break;
+				}
+
+				outRecords.push_back(std::move(record));
+				outValidSize = br.Pos();
+			}
+			return true;
+		}
+
+		bool Apply(const AnimJournalRecord& record, AnimDocument& doc)
+		{
+			size_t animCount = doc.animations.size();
+
+			switch (record.op)
+			{
+			case AnimJournalOp::SetAnimation:
+				if (record.animIndex > animCount)
+				{
+					return false;
+				}
+				if (record.animIndex == animCount)
+				{
+					doc.animations.push_back(record.info);
+				}
+				else
+				{
+					doc.animations[record.animIndex] = record.info;
+				}
+				return true;
+			case AnimJournalOp::RemoveAnimation:
+				if (record.animIndex >= animCount)
+				{
+					return false;
+				}
+				doc.animations.erase(doc.animations.begin() + record.animIndex);
+				return true;
+			case AnimJournalOp::SetPattern:
+			{
+				if (record.animIndex >= animCount || record.patternIndex >= doc.animations[record.animIndex].pattern.size())
+				{
+					return false;
+				}
+				doc.animations[record.animIndex].pattern[record.patternIndex] = record.pattern;
+				return true;
+			}
+			case AnimJournalOp::SetTexture:
+				doc.textureName = record.textureName;
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool Load(const std::filesystem::path& animPath, AnimDocument& outDoc)
+		{
+			AnimFormat format;
+			AnimCompression compression;
+			return Load(animPath, outDoc, format, compression);
+		}
+
+		bool Load(const std::filesystem::path& animPath, AnimDocument& outDoc, AnimFormat& outFormat, AnimCompression& outCompression)
+		{
+			outFormat      = AnimFormat::Legacy;
+			outCompression = AnimCompression::None;
+
+			std::vector<uint8_t> buffer;
+			if (!AnimCodec::ReadFile(animPath, buffer))
+			{
+				return false;
+			}
+
+			//形式は展開した後の中身で調べる。
+			if (AnimZstd::IsCompressed(buffer.data(), buffer.size()))
+			{
+				std::vector<uint8_t> rawBuffer;
+				if (!AnimZstd::Decompress(buffer.data(), buffer.size(), rawBuffer))
+				{
+					return false;
+				}
+				buffer.swap(rawBuffer);
+				outCompression = AnimCompression::Zstd;
+			}
+
+			outFormat = AnimCodec::Detect(buffer.data(), buffer.size());
+			if (!AnimCodec::Decode(buffer.data(), buffer.size(), outDoc))
+			{
+				return false;
+			}
+
+			std::vector<AnimJournalRecord> records;
+			uint64_t validSize;
+			if (Read(animPath, records, validSize))
+			{
+				for (const AnimJournalRecord& record : records)
+				{
+					Apply(record, outDoc);
+				}
+			}
+			return true;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+
+//.animへの変更を追記していくジャーナル。Siv3Dには依存しない。
+//保存のたびに全体を書き直す代わりに、変更したアニメーションやパターンだけを<.animのパス>.journalの末尾に書き足す。
+//.animとジャーナルをまとめて書き直す(整理する)のはジャーナルが大きくなった時だけでよい。
+
+namespace siapp
+{
+	//ジャーナルの先頭。元になった.animファイルのサイズとハッシュを持ち、違うファイルのジャーナルは読まない。
+	struct AnimJournalHeader
+	{
+		char                         magic[4];           //"ANMJ"
+		uint32_t                     version;
+		uint64_t                     baseSize;
+		uint64_t                     baseHash;
+	};
+
+	static_assert(sizeof(AnimJournalHeader) == 24, "AnimJournalHeader must match the file layout");
+
+	//変更の種類。
+	enum class AnimJournalOp : uint32_t
+	{
+		SetAnimation     = 1,  //アニメーション1つ分を置き換える。番号が数と同じなら末尾に追加する。
+		RemoveAnimation  = 2,  //アニメーションを1つ消す。
+		SetPattern       = 3,  //パターン1つ分を置き換える。
+		SetTexture       = 4,  //画像ファイル名を置き換える。
+	};
+
+	//変更1つ分。opによって使う項目が変わる。
+	struct AnimJournalRecord
+	{
+		AnimJournalOp                op            = AnimJournalOp::SetAnimation;
+		uint32_t                     animIndex     = 0;
+		uint32_t                     patternIndex  = 0;
+		AnimInfoData                 info;               //SetAnimation
+		AnimPatternData              pattern;            //SetPattern
+		std::string                  textureName;        //SetTexture
+	};
+
+	namespace AnimJournal
+	{
+		//.animファイルに対応するジャーナルのパス。(path + ".journal")
+		std::filesystem::path JournalPath(const std::filesystem::path& animPath);
+
+		//FNV-1aの64bitハッシュ。
+		uint64_t Hash(const uint8_t* data, size_t size);
+
+		//書き出した.animのデータから空のジャーナルを作る。古いジャーナルは置き換える。
+		bool Create(const std::filesystem::path& animPath, const uint8_t* baseData, size_t baseSize);
+
+		//ジャーナルを消す。
+		void Remove(const std::filesystem::path& animPath);
+
+		//変更1つ分をバッファの後ろに書き足す。
+		void EncodeRecord(const AnimJournalRecord& record, std::vector<uint8_t>& outBuffer);
+
+		//EncodeRecordしたバッファを一度の書き込みでジャーナルの末尾に追加する。
+		//validSizeより後ろにある途切れたデータは先に切り捨てる。
+		bool Append(const std::filesystem::path& animPath, const std::vector<uint8_t>& records, uint64_t validSize);
+
+		//.animに対応するジャーナルを読む。ジャーナルがないか、.animと対応していなければfalseを返す。
+		//途中で途切れた変更は捨て、そこまでの有効なサイズをoutValidSizeに返す。
+		bool Read(const std::filesystem::path& animPath, std::vector<AnimJournalRecord>& outRecords, uint64_t& outValidSize);
+
+		//変更1つ分をドキュメントに反映する。範囲外を指している場合はfalseを返す。
+		bool Apply(const AnimJournalRecord& record, AnimDocument& doc);
+
+		//.animを読み込み、ジャーナルがあれば反映する。
+		bool Load(const std::filesystem::path& animPath, AnimDocument& outDoc);
+
+		//Loadと同じだが、上書き保存で同じ形式にできるように.animの形式と圧縮方式も返す。
+		bool Load(const std::filesystem::path& animPath, AnimDocument& outDoc, AnimFormat& outFormat, AnimCompression& outCompression);
+	}
+}
@@ -0,0 +1,203 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//アニメーション名の並びと、名前から番号を引くハッシュ表。Siv3Dには依存しない。
+//名前はここにだけ持ち、アニメーションの配列と同じ番号で並べる。追加・名前の変更は表の一部を書き換えるだけで済む。
+//ハッシュ表はAnimPackの索引と同じく、番号+1を入れた2のべき乗の表を半分以上空けて線形探索する。
+//
+//StringTはdata()とsize()を持つ文字列型。ツールやゲーム側はstd::string(AnimNameIndex)、GUIはs3d::Stringで使う。
+//同じ名前が並んでいる場合(手で書き換えたファイルなど)も持てる。Findは一番前のものを返す。
+
+namespace siapp
+{
+	template<class StringT>
+	class BasicAnimNameIndex
+	{
+	public:
+		using Char = typename StringT::value_type;
+		using View = std::basic_string_view<Char>;
+
+		static constexpr size_t      npos = SIZE_MAX;
+	private:
+		std::vector<StringT>         m_Names;
+		std::vector<uint64_t>        m_Hashes;           //m_Namesと同じ並び
+		std::vector<uint32_t>        m_Buckets;          //番号+1。空は0
+		size_t                       m_Mask = 0;
+
+		//名前のハッシュ。(FNV-1a 64bit、文字単位)
+		static uint64_t Hash(View name)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (Char c : name)
+			{
+				hash ^= static_cast<uint64_t>(c);
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		static View ToView(const StringT& str)
+		{
+			return View(str.data(), str.size());
+		}
+
+		void InsertBucket(size_t index)
+		{
+			for (size_t i = static_cast<size_t>(m_Hashes[index]) & m_Mask; ; i = (i + 1) & m_Mask)
+			{
+				if (m_Buckets[i] == 0)
+				{
+					m_Buckets[i] = static_cast<uint32_t>(index + 1);
+					return;
+				}
+			}
+		}
+
+		//空けたところに後ろの要素を詰めて、探索が途切れないようにする。(墓標を置かない削除)
+		void EraseBucket(size_t index)
+		{
+			size_t hole = static_cast<size_t>(m_Hashes[index]) & m_Mask;
+			while (m_Buckets[hole] != index + 1)
+			{
+				hole = (hole + 1) & m_Mask;
+			}
+
+			for (size_t i = (hole + 1) & m_Mask; m_Buckets[i] != 0; i = (i + 1) & m_Mask)
+			{
+				size_t home = static_cast<size_t>(m_Hashes[m_Buckets[i] - 1]) & m_Mask;
+				if (((i - home) & m_Mask) >= ((i - hole) & m_Mask))
+				{
+					m_Buckets[hole] = m_Buckets[i];
+					hole            = i;
+				}
+			}
+			m_Buckets[hole] = 0;
+		}
+
+		//要素数の倍以上の大きさで表を作り直す。
+		void Rehash(size_t count)
+		{
+			size_t bucketCount = 16;
+			while (bucketCount < count * 2)
+			{
+				bucketCount *= 2;
+			}
+
+			m_Buckets.assign(bucketCount, 0);
+			m_Mask = bucketCount - 1;
+			for (size_t i = 0; i < m_Names.size(); ++i)
+			{
+				InsertBucket(i);
+			}
+		}
+	public:
+		size_t Count(void) const
+		{
+			return m_Names.size();
+		}
+
+		const StringT& Name(size_t index) const
+		{
+			return m_Names[index];
+		}
+
+		const std::vector<StringT>& Names(void) const
+		{
+			return m_Names;
+		}
+
+		//名前から番号を引く。なければnposを返す。
+		size_t Find(View name) const
+		{
+			if (m_Names.empty())
+			{
+				return npos;
+			}
+
+			uint64_t hash  = Hash(name);
+			size_t   found = npos;
+			for (size_t i = static_cast<size_t>(hash) & m_Mask; m_Buckets[i] != 0; i = (i + 1) & m_Mask)
+			{
+				size_t index = m_Buckets[i] - 1;
+				if (m_Hashes[index] == hash && index < found && ToView(m_Names[index]) == name)
+				{
+					found = index;
+				}
+			}
+			return found;
+		}
+
+		size_t Find(const StringT& name) const
+		{
+			return Find(ToView(name));
+		}
+
+		size_t Find(const Char* name) const
+		{
+			return Find(View(name));
+		}
+
+		template<class T>
+		bool Contains(const T& name) const
+		{
+			return Find(name) != npos;
+		}
+
+		void Reserve(size_t count)
+		{
+			m_Names.reserve(count);
+			m_Hashes.reserve(count);
+			if (m_Buckets.size() < count * 2)
+			{
+				Rehash(count);
+			}
+		}
+
+		void Clear(void)
+		{
+			m_Names.clear();
+			m_Hashes.clear();
+			m_Buckets.clear();
+			m_Mask = 0;
+		}
+
+		//後ろに足して、その番号を返す。
+		size_t Add(StringT name)
+		{
+			if (m_Buckets.size() < (m_Names.size() + 1) * 2)
+			{
+				Rehash(m_Names.size() + 1);
+			}
+
+			size_t index = m_Names.size();
+			m_Hashes.push_back(Hash(ToView(name)));
+			m_Names.push_back(std::move(name));
+			InsertBucket(index);
+			return index;
+		}
+
+		//名前を変える。表はこの名前の分だけ書き換える。
+		void Rename(size_t index, StringT name)
+		{
+			EraseBucket(index);
+			m_Hashes[index] = Hash(ToView(name));
+			m_Names[index]  = std::move(name);
+			InsertBucket(index);
+		}
+
+		//消した後ろの番号が1つずつ前にずれるので、表は作り直す。
+		void RemoveAt(size_t index)
+		{
+			m_Names.erase(m_Names.begin() + static_cast<std::ptrdiff_t>(index));
+			m_Hashes.erase(m_Hashes.begin() + static_cast<std::ptrdiff_t>(index));
+			Rehash(m_Names.size());
+		}
+	};
+
+	using AnimNameIndex = BasicAnimNameIndex<std::string>;
+}
@@ -0,0 +1,437 @@
+﻿#include "AnimPack.hpp"
+#include "AnimIndex.hpp"
+#include "AnimText.hpp"
+#include "AtomicFile.hpp"
+#include <cstring>
+#include <map>
+#include <set>
+
+namespace siapp
+{
+	namespace
+	{
+		constexpr char   animPackMagic[4] = { 'A', 'N', 'M', 'P' };
+		constexpr size_t dataAlignment    = 16;
+
+		uint64_t AlignUp(uint64_t size, uint64_t alignment)
+		{
+			return (size + alignment - 1) & ~(alignment - 1);
+		}
+
+		std::string PathToUtf8(const std::filesystem::path& path)
+		{
+			//C++20ではu8stringがchar8_tになるのでcharとして受け取り直す。
+			auto str = path.generic_u8string();
+			return std::string(reinterpret_cast<const char*>(str.data()), str.size());
+		}
+
+		//パックを作る時のエントリ1つ分。
+		struct PackSource
+		{
+			std::filesystem::path    path;
+			std::string              name;
+			AnimPackEntry            entry;
+		};
+	}
+
+	AnimPackFile::AnimPackFile(void) :
+		m_File(),
+		m_pHeader(nullptr),
+		m_pEntries(nullptr),
+		m_pBuckets(nullptr),
+		m_pNames(nullptr)
+	{
+	}
+
+	bool AnimPackFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+		if (!m_File.Open(path) || m_File.Size() < sizeof(AnimPackHeader))
+		{
+			Close();
+			return false;
+		}
+
+		const uint8_t* data = m_File.Data();
+		uint64_t       size = m_File.Size();
+
+		const AnimPackHeader* pHeader = reinterpret_cast<const AnimPackHeader*>(data);
+		if (std::memcmp(pHeader->magic, animPackMagic, sizeof(animPackMagic)) != 0 || pHeader->version != animPackVersion ||
+			pHeader->bucketCount == 0 || (pHeader->bucketCount & (pHeader->bucketCount - 1)) != 0 || pHeader->bucketCount <= pHeader->entryCount)
+		{
+			Close();
+			return false;
+		}
+
+		//各テーブルがファイル内に収まっているか確認する。
+		uint64_t entryEnd  = sizeof(AnimPackHeader) + static_cast<uint64_t>(pHeader->entryCount) * sizeof(AnimPackEntry);
+		uint64_t bucketEnd = entryEnd + static_cast<uint64_t>(pHeader->bucketCount) * sizeof(uint32_t);
+		if (bucketEnd > size || pHeader->nameOffset < bucketEnd || pHeader->nameOffset > size || pHeader->nameSize > size - pHeader->nameOffset)
+		{
+			Close();
+			return false;
+		}
+
+		const AnimPackEntry* pEntries = reinterpret_cast<const AnimPackEntry*>(data + sizeof(AnimPackHeader));
+		const uint32_t*      pBuckets = reinterpret_cast<const uint32_t*>(data + entryEnd);
+
+		//引いた先で範囲外を読まないように、エントリとハッシュ表は開く時に一度だけ確認しておく。
+		for (uint32_t i = 0; i < pHeader->entryCount; ++i)
+		{
+			const AnimPackEntry& entry = pEntries[i];
+			if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength >= pHeader->nameSize ||
+				entry.dataOffset > size || entry.dataSize > size - entry.dataOffset ||
+				(entry.kind != AnimPackKind::Animation && entry.kind != AnimPackKind::Texture))
+			{
+				Close();
+				return false;
+			}
+			if (entry.textureIndex != animPackNoTexture &&
+				(entry.textureIndex >= pHeader->entryCount || pEntries[entry.textureIndex].kind != AnimPackKind::Texture))
+			{
+				Close();
+				return false;
+			}
+		}
+		//Findが空のバケツに当たらずに回り続けないように、同じエントリを2度指すものと空のバケツがないものも弾く。
+		std::vector<uint8_t> bucketUsed(pHeader->entryCount, 0);
+		bool bHasEmpty = false;
+		for (uint32_t i = 0; i < pHeader->bucketCount; ++i)
+		{
+			uint32_t bucket = pBuckets[i];
+			if (bucket == 0)
+			{
+				bHasEmpty = true;
+				continue;
+			}
+			if (bucket > pHeader->entryCount || bucketUsed[bucket - 1] != 0)
+			{
+				Close();
+				return false;
+			}
+			bucketUsed[bucket - 1] = 1;
+		}
+		if (!bHasEmpty)
+		{
+			Close();
+			return false;
+		}
+
+		m_pHeader  = pHeader;
+		m_pEntries = pEntries;
+		m_pBuckets = pBuckets;
+		m_pNames   = reinterpret_cast<const char*>(data + pHeader->nameOffset);
+		return true;
+	}
+
+	void AnimPackFile::Close(void)
+	{
+		m_File.Close();
+		m_pHeader  = nullptr;
+		m_pEntries = nullptr;
+		m_pBuckets = nullptr;
+		m_pNames   = nullptr;
+	}
+
+	bool AnimPackFile::IsOpen(void) const
+	{
+		return m_pHeader != nullptr;
+	}
+
+	uint32_t AnimPackFile::EntryCount(void) const
+	{
+		return m_pHeader ? m_pHeader->entryCount : 0;
+	}
+
+	const AnimPackEntry& AnimPackFile::Entry(uint32_t index) const
+	{
+		return m_pEntries[index];
+	}
+
+	std::string_view AnimPackFile::Name(uint32_t index) const
+	{
+		const AnimPackEntry& entry = m_pEntries[index];
+		return std::string_view(m_pNames + entry.nameOffset, entry.nameLength);
+	}
+
+	const uint8_t* AnimPackFile::Data(uint32_t index) const
+	{
+		return m_File.Data() + m_pEntries[index].dataOffset;
+	}
+
+	uint32_t AnimPackFile::Find(std::string_view name) const
+	{
+		if (m_pHeader == nullptr)
+		{
+			return animPackNotFound;
+		}
+
+		//ハッシュ表は半分以上空けてあるので、空のバケツに当たるまで数回で済む。
+		//空のバケツがあることはOpenで確かめているが、念のため表を一周したら打ち切る。
+		uint64_t hash = AnimPack::Hash(name);
+		uint32_t mask = m_pHeader->bucketCount - 1;
+		uint32_t i    = static_cast<uint32_t>(hash) & mask;
+
+		for (uint32_t probe = 0; probe < m_pHeader->bucketCount; ++probe, i = (i + 1) & mask)
+		{
+			uint32_t bucket = m_pBuckets[i];
+			if (bucket == 0)
+			{
+				return animPackNotFound;
+			}
+
+			uint32_t index = bucket - 1;
+			if (m_pEntries[index].hash == hash && Name(index) == name)
+			{
+				return index;
+			}
+		}
+		return animPackNotFound;
+	}
+
+	bool AnimPackFile::DecodeAnimation(uint32_t index, AnimDocument& outDoc) const
+	{
+		if (index >= EntryCount() || m_pEntries[index].kind != AnimPackKind::Animation)
+		{
+			return false;
+		}
+		return AnimCodec::Decode(Data(index), static_cast<size_t>(m_pEntries[index].dataSize), outDoc);
+	}
+
+	bool AnimPackFile::ViewAnimation(uint32_t index, AnimV2View& outView) const
+	{
+		if (index >= EntryCount() || m_pEntries[index].kind != AnimPackKind::Animation)
+		{
+			return false;
+		}
+		return outView.Open(Data(index), static_cast<size_t>(m_pEntries[index].dataSize));
+	}
+
+	uint32_t AnimPackFile::TextureIndex(uint32_t index) const
+	{
+		if (index >= EntryCount() || m_pEntries[index].textureIndex == animPackNoTexture)
+		{
+			return animPackNotFound;
+		}
+		return m_pEntries[index].textureIndex;
+	}
+
+	namespace AnimPack
+	{
+		uint64_t Hash(std::string_view name)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (char c : name)
+			{
+				hash ^= static_cast<uint8_t>(c);
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		std::string NormalizeName(const std::string& name)
+		{
+			std::string result = name;
+			for (char& c : result)
+			{
+				if (c == '\\')
+				{
+					c = '/';
+				}
+			}
+			while (result.compare(0, 2, "./") == 0)
+			{
+				result.erase(0, 2);
+			}
+			return result;
+		}
+
+		bool Build(const std::filesystem::path& rootDir, const std::vector<std::filesystem::path>& animPaths, const std::filesystem::path& path, std::string& outMessage)
+		{
+			std::vector<PackSource>                   sources;
+			std::map<std::filesystem::path, uint32_t> textureIndices;   //同じ画像ファイルは1つにまとめる
+			std::set<std::string>                     names;
+
+			auto addSource = [&](const std::filesystem::path& sourcePath, const std::string& name, AnimPackKind kind)
+			{
+				std::error_code ec;
+				uint64_t fileSize = std::filesystem::file_size(sourcePath, ec);
+				if (ec)
+				{
+					outMessage = "failed to read " + PathToUtf8(sourcePath);
+					return false;
+				}
+				if (!names.insert(name).second)
+				{
+					outMessage = "duplicate name " + name;
+					return false;
+				}
+
+				PackSource source;
+				source.path               = sourcePath;
+				source.name               = name;
+				source.entry              = {};
+				source.entry.hash         = Hash(name);
+				source.entry.dataSize     = fileSize;
+				source.entry.kind         = kind;
+				source.entry.textureIndex = animPackNoTexture;
+				sources.push_back(std::move(source));
+				return true;
+			};
+
+			//パックの中の名前はrootDirからの相対パスにする。rootDirの外なら渡されたパスのまま。
+			auto relativeName = [&](const std::filesystem::path& sourcePath)
+			{
+				std::error_code ec;
+				std::filesystem::path relativePath = std::filesystem::relative(sourcePath, rootDir, ec);
+				if (ec || relativePath.empty())
+				{
+					relativePath = sourcePath;
+				}
+				return NormalizeName(PathToUtf8(relativePath));
+			};
+
+			for (const auto& animPath : animPaths)
+			{
+				//画像の名前を知るために索引だけ作る。パターンはデコードしない。
+				AnimIndex index;
+				if (!index.Open(animPath))
+				{
+					outMessage = "failed to load " + PathToUtf8(animPath);
+					return false;
+				}
+
+				if (!addSource(animPath, relativeName(animPath), AnimPackKind::Animation))
+				{
+					return false;
+				}
+				uint32_t animEntry = static_cast<uint32_t>(sources.size() - 1);
+
+				const std::string& textureName = index.TextureName();
+				if (textureName.empty())
+				{
+					continue;
+				}
+
+				//画像はGUIで読み込む時と同じ場所を探す。
+				std::filesystem::path texturePath = AnimCodec::ResolveTexturePath(animPath, textureName);
+				if (texturePath.empty())
+				{
+					outMessage = "texture not found " + AnimText::NativeToUtf8(textureName) + " (" + PathToUtf8(animPath) + ")";
+					return false;
+				}
+
+				std::error_code ec;
+				std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(texturePath, ec);
+				if (ec)
+				{
+					canonicalPath = texturePath;
+				}
+
+				auto it = textureIndices.find(canonicalPath);
+				if (it == textureIndices.end())
+				{
+					//.animに書かれた名前は別のフォルダの別の画像と同じことがあるので、見つかったファイルのパスで呼ぶ。
+					if (!addSource(texturePath, relativeName(canonicalPath), AnimPackKind::Texture))
+					{
+						return false;
+					}
+					it = textureIndices.emplace(canonicalPath, static_cast<uint32_t>(sources.size() - 1)).first;
+				}
+				sources[animEntry].entry.textureIndex = it->second;
+			}
+
+			if (sources.size() >= UINT32_MAX / 2)
+			{
+				outMessage = "too many files";
+				return false;
+			}
+
+			//ハッシュ表はエントリの2倍以上の大きさにして、引く時の衝突を少なくしておく。
+			uint32_t entryCount  = static_cast<uint32_t>(sources.size());
+			uint32_t bucketCount = 2;
+			while (bucketCount < entryCount * 2)
+			{
+				bucketCount *= 2;
+			}
+
+			AnimPackHeader header = {};
+			std::memcpy(header.magic, animPackMagic, sizeof(animPackMagic));
+			header.version     = animPackVersion;
+			header.entryCount  = entryCount;
+			header.bucketCount = bucketCount;
+			header.nameOffset  = sizeof(AnimPackHeader) + static_cast<uint64_t>(entryCount) * sizeof(AnimPackEntry) + static_cast<uint64_t>(bucketCount) * sizeof(uint32_t);
+
+			std::string nameArea;
+			for (PackSource& source : sources)
+			{
+				source.entry.nameOffset = static_cast<uint32_t>(nameArea.size());
+				source.entry.nameLength = static_cast<uint32_t>(source.name.size());
+				nameArea += source.name;
+				nameArea += '\0';
+			}
+			header.nameSize = nameArea.size();
+
+			uint64_t dataOffset = AlignUp(header.nameOffset + header.nameSize, dataAlignment);
+			for (PackSource& source : sources)
+			{
+				source.entry.dataOffset = dataOffset;
+				dataOffset = AlignUp(dataOffset + source.entry.dataSize, dataAlignment);
+			}
+
+			std::vector<uint32_t> buckets(bucketCount, 0);
+			for (uint32_t i = 0; i < entryCount; ++i)
+			{
+				uint32_t bucket = static_cast<uint32_t>(sources[i].entry.hash) & (bucketCount - 1);
+				while (buckets[bucket] != 0)
+				{
+					bucket = (bucket + 1) & (bucketCount - 1);
+				}
+				buckets[bucket] = i + 1;
+			}
+
+			//ファイルの中身は1つずつ読んで書き出すので、全体をメモリに置くことはない。
+			AtomicFileStream stream;
+			if (!stream.Open(path))
+			{
+				outMessage = "failed to create " + PathToUtf8(path);
+				return false;
+			}
+
+			stream.Write(&header, sizeof(AnimPackHeader));
+			for (const PackSource& source : sources)
+			{
+				stream.Write(&source.entry, sizeof(AnimPackEntry));
+			}
+			stream.Write(buckets.data(), buckets.size() * sizeof(uint32_t));
+			stream.Write(nameArea.data(), nameArea.size());
+
+			static constexpr uint8_t padding[dataAlignment] = {};
+			uint64_t writePos = header.nameOffset + header.nameSize;
+
+			std::vector<uint8_t> buffer;
+			for (const PackSource& source : sources)
+			{
+				stream.Write(padding, static_cast<size_t>(source.entry.dataOffset - writePos));
+
+				//パックを作っている間にファイルが書き換えられていたら、エントリのサイズと合わなくなるので失敗させる。
+				if (!AnimCodec::ReadFile(source.path, buffer) || buffer.size() != source.entry.dataSize)
+				{
+					outMessage = "failed to read " + PathToUtf8(source.path);
+					return false;
+				}
+
+				stream.Write(buffer.data(), buffer.size());
+				writePos = source.entry.dataOffset + source.entry.dataSize;
+			}
+
+			if (!stream.Commit())
+			{
+				outMessage = "failed to write " + PathToUtf8(path);
+				return false;
+			}
+			return true;
+		}
+	}
+}
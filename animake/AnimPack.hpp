@@ -0,0 +1,108 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+#include "AnimV2.hpp"
+#include "MappedFile.hpp"
+#include <string_view>
+
+//複数の.animファイルと、それぞれが使う画像ファイルを1つにまとめたパック。Siv3Dには依存しない。
+//ファイルを1つマップするだけで全てのアニメーションと画像を名前から引けるので、読み込み時に小さなファイルを何千回も開かずに済む。
+//
+//ファイルの並び:
+//    AnimPackHeader
+//    AnimPackEntry  × entryCount
+//    uint32_t       × bucketCount   名前のハッシュから引く表。エントリ番号+1を入れ、空は0
+//    名前の領域                     UTF-8の名前をnull終端で並べたもの
+//    データ                         .animと画像ファイルの中身をそのまま16バイト境界に並べたもの
+//
+//名前は.animも画像もパックを作った時のフォルダからの相対パスで、区切りは'/'にする。
+//画像は.animに書かれている名前ではなく実際に見つかったファイルのパスで呼ぶので、別のフォルダの同じ名前の画像も別々に入る。
+//アニメーションからはtextureIndexで画像を引く。
+//.animは中身をそのまま入れるので、v2形式ならパックのデータをコピーせずにAnimV2Viewで参照できる。
+
+namespace siapp
+{
+	struct AnimPackHeader
+	{
+		char                         magic[4];           //"ANMP"
+		uint32_t                     version;
+		uint32_t                     entryCount;
+		uint32_t                     bucketCount;        //2のべき乗
+		uint64_t                     nameOffset;
+		uint64_t                     nameSize;
+	};
+
+	enum class AnimPackKind : uint32_t
+	{
+		Animation = 1,
+		Texture   = 2,
+	};
+
+	struct AnimPackEntry
+	{
+		uint64_t                     hash;               //名前のハッシュ(AnimPack::Hash)
+		uint64_t                     dataOffset;
+		uint64_t                     dataSize;
+		uint32_t                     nameOffset;         //名前の領域内の位置
+		uint32_t                     nameLength;
+		AnimPackKind                 kind;
+		uint32_t                     textureIndex;       //アニメーションが使う画像のエントリ番号。なければanimPackNoTexture
+	};
+
+	constexpr uint32_t               animPackVersion    = 1;
+	constexpr uint32_t               animPackNoTexture  = UINT32_MAX;
+	constexpr uint32_t               animPackNotFound   = UINT32_MAX;
+
+	static_assert(sizeof(AnimPackHeader) == 32, "AnimPackHeader must match the file layout");
+	static_assert(sizeof(AnimPackEntry)  == 40, "AnimPackEntry must match the file layout");
+
+	//パックをマップしたまま参照する。データはファイルの中を直接指すので、Closeするまで有効。
+	class AnimPackFile
+	{
+	private:
+		MappedFile                   m_File;
+		const AnimPackHeader*        m_pHeader;
+		const AnimPackEntry*         m_pEntries;
+		const uint32_t*              m_pBuckets;
+		const char*                  m_pNames;
+	public:
+		AnimPackFile(void);
+		AnimPackFile(const AnimPackFile&) = delete;
+		AnimPackFile& operator= (const AnimPackFile&) = delete;
+
+		//マップしてヘッダーと各エントリの範囲を確認する。
+		bool Open(const std::filesystem::path& path);
+		void Close(void);
+		bool IsOpen(void) const;
+
+		uint32_t EntryCount(void) const;
+		const AnimPackEntry& Entry(uint32_t index) const;
+		std::string_view Name(uint32_t index) const;
+		const uint8_t* Data(uint32_t index) const;
+
+		//名前からエントリ番号を引く。なければanimPackNotFoundを返す。
+		uint32_t Find(std::string_view name) const;
+
+		//アニメーションのエントリをデコードする。圧縮やv2形式も.animファイルと同じように扱う。
+		bool DecodeAnimation(uint32_t index, AnimDocument& outDoc) const;
+
+		//v2形式のアニメーションをコピーせずに参照する。
+		bool ViewAnimation(uint32_t index, AnimV2View& outView) const;
+
+		//アニメーションが使う画像のエントリ番号。なければanimPackNotFoundを返す。
+		uint32_t TextureIndex(uint32_t index) const;
+	};
+
+	namespace AnimPack
+	{
+		//名前のハッシュ。(FNV-1a 64bit)
+		uint64_t Hash(std::string_view name);
+
+		//パックに入れる名前にする。区切りを'/'にして、先頭の"./"を省く。
+		std::string NormalizeName(const std::string& name);
+
+		//rootDir以下の.animファイルと、それぞれの画像をまとめてpathに書き出す。
+		//画像はAnimCodec::ResolveTexturePathで探し、同じファイルは1つだけ入れる。見つからない画像があれば失敗する。
+		//失敗した場合は理由をoutMessageに入れてfalseを返す。
+		bool Build(const std::filesystem::path& rootDir, const std::vector<std::filesystem::path>& animPaths, const std::filesystem::path& path, std::string& outMessage);
+	}
+}
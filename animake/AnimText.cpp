@@ -0,0 +1,588 @@
+﻿#include "AnimText.hpp"
+#include "AtomicFile.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <Windows.h>
+#endif
+
+namespace siapp
+{
+	namespace
+	{
+		//Siv3DのFormat(double)の小数点以下の桁数。
+		constexpr int  formatDecimalPlace  = 5;
+
+		//1行目以降の固定の文言。(C++20ではu8リテラルがchar8_tになるためcharとして扱う)
+		const char* const textHeaderNotice = reinterpret_cast<const char*>(u8"上記データファイル名を消すとツールで読み込めなくなります。\n");
+		const char* const textTextureLabel = reinterpret_cast<const char*>(u8"対応画像ファイル名：");
+		const char* const textCopyNotice   = reinterpret_cast<const char*>(u8"以下コピペ用\n");
+
+		constexpr char utf8Bom[]           = "\xEF\xBB\xBF";
+
+		//パターン1つ分の文字数の目安。("{5,0,0},")
+		constexpr size_t patternTextSize   = 12;
+
+		//アニメーション1つ分のパターン以外の文字数の目安。
+		constexpr size_t animTextSize      = 64;
+
+		//.txtを先頭から読み進める。トークンごとに文字列を作らず、バッファ上の位置だけを動かす。
+		class TextCursor
+		{
+		private:
+			const char*                  m_pCur;
+			const char*                  m_pEnd;
+			size_t                       m_Line;
+			const char*                  m_pError;
+		public:
+			TextCursor(const char* data, size_t size) :
+				m_pCur(data),
+				m_pEnd(data + size),
+				m_Line(1),
+				m_pError(nullptr)
+			{
+			}
+
+			size_t Line(void) const
+			{
+				return m_Line;
+			}
+
+			const char* Error(void) const
+			{
+				return m_pError;
+			}
+
+			bool Fail(const char* message)
+			{
+				if (m_pError == nullptr)
+				{
+					m_pError = message;
+				}
+				return false;
+			}
+
+			bool IsEnd(void) const
+			{
+				return m_pCur >= m_pEnd;
+			}
+
+			//1行分を改行を除いて返し、次の行に進む。
+			void ReadLine(const char*& outBegin, size_t& outLength)
+			{
+				const char* pBegin = m_pCur;
+				if (m_pCur >= m_pEnd)
+				{
+					outBegin  = pBegin;
+					outLength = 0;
+					return;
+				}
+
+				const char* pLineEnd = static_cast<const char*>(std::memchr(m_pCur, '\n', static_cast<size_t>(m_pEnd - m_pCur)));
+				if (pLineEnd == nullptr)
+				{
+					pLineEnd = m_pEnd;
+					m_pCur   = m_pEnd;
+				}
+				else
+				{
+					m_pCur = pLineEnd + 1;
+					m_Line++;
+				}
+
+				if (pLineEnd > pBegin && pLineEnd[-1] == '\r')
+				{
+					--pLineEnd;
+				}
+				outBegin  = pBegin;
+				outLength = static_cast<size_t>(pLineEnd - pBegin);
+			}
+
+			//次の行が空白を除いてcから始まっているか。読み進めはしない。
+			bool LineStartsWith(char c) const
+			{
+				const char* p = m_pCur;
+				while (p < m_pEnd && (*p == ' ' || *p == '\t'))
+				{
+					p++;
+				}
+				return p < m_pEnd && *p == c;
+			}
+
+			//空白、改行、コメントを飛ばす。
+			void SkipSpace(void)
+			{
+				while (m_pCur < m_pEnd)
+				{
+					char c = *m_pCur;
+					if (c == '\n')
+					{
+						m_Line++;
+						m_pCur++;
+					}
+					else if (c == ' ' || c == '\t' || c == '\r')
+					{
+						m_pCur++;
+					}
+					else if (c == '/' && m_pCur + 1 < m_pEnd && m_pCur[1] == '/')
+					{
+						while (m_pCur < m_pEnd && *m_pCur != '\n')
+						{
+							m_pCur++;
+						}
+					}
+					else if (c == '/' && m_pCur + 1 < m_pEnd && m_pCur[1] == '*')
+					{
+						m_pCur += 2;
+						while (m_pCur < m_pEnd && !(*m_pCur == '*' && m_pCur + 1 < m_pEnd && m_pCur[1] == '/'))
+						{
+							if (*m_pCur == '\n')
+							{
+								m_Line++;
+							}
+							m_pCur++;
+						}
+						m_pCur = (m_pCur < m_pEnd) ? m_pCur + 2 : m_pEnd;
+					}
+					else
+					{
+						break;
+					}
+				}
+			}
+
+			//次の文字がcなら読み進めてtrueを返す。
+			bool Accept(char c)
+			{
+				SkipSpace();
+				if (m_pCur < m_pEnd && *m_pCur == c)
+				{
+					m_pCur++;
+					return true;
+				}
+				return false;
+			}
+
+			bool Expect(char c, const char* message)
+			{
+				return Accept(c) || Fail(message);
+			}
+
+			//区切りのカンマ。閉じ括弧の前は省略してもよい。
+			bool Separator(char close, const char* message)
+			{
+				SkipSpace();
+				if (m_pCur < m_pEnd && *m_pCur == close)
+				{
+					return true;
+				}
+				return Expect(',', message);
+			}
+
+			//指定の文字が見つかるまで飛ばす。見つからなければfalseを返す。
+			bool SkipTo(char c)
+			{
+				while (m_pCur < m_pEnd && *m_pCur != c)
+				{
+					if (*m_pCur == '\n')
+					{
+						m_Line++;
+					}
+					m_pCur++;
+				}
+				return m_pCur < m_pEnd;
+			}
+
+			//"で囲まれた文字列。中身はバッファ上の範囲で返す。
+			bool String(const char*& outBegin, size_t& outLength)
+			{
+				if (!Expect('"', "expected '\"'"))
+				{
+					return false;
+				}
+				const char* pBegin = m_pCur;
+				while (m_pCur < m_pEnd && *m_pCur != '"')
+				{
+					if (*m_pCur == '\n')
+					{
+						return Fail("unterminated string");
+					}
+					m_pCur++;
+				}
+				if (m_pCur >= m_pEnd)
+				{
+					return Fail("unterminated string");
+				}
+				outBegin  = pBegin;
+				outLength = static_cast<size_t>(m_pCur - pBegin);
+				m_pCur++;
+				return true;
+			}
+
+			bool Number(float& out)
+			{
+				SkipSpace();
+				if (m_pCur < m_pEnd && *m_pCur == '+')
+				{
+					m_pCur++;
+				}
+				auto [pEnd, ec] = std::from_chars(m_pCur, m_pEnd, out);
+				if (ec != std::errc())
+				{
+					return Fail("expected a number");
+				}
+				m_pCur = pEnd;
+				return true;
+			}
+
+			bool Number(int32_t& out)
+			{
+				SkipSpace();
+				if (m_pCur < m_pEnd && *m_pCur == '+')
+				{
+					m_pCur++;
+				}
+				auto [pEnd, ec] = std::from_chars(m_pCur, m_pEnd, out);
+				if (ec != std::errc())
+				{
+					return Fail("expected an integer");
+				}
+				m_pCur = pEnd;
+				return true;
+			}
+
+			bool Bool(bool& out)
+			{
+				SkipSpace();
+				const char* pBegin = m_pCur;
+				while (m_pCur < m_pEnd && ((*m_pCur >= 'a' && *m_pCur <= 'z') || (*m_pCur >= 'A' && *m_pCur <= 'Z') || (*m_pCur >= '0' && *m_pCur <= '9')))
+				{
+					m_pCur++;
+				}
+
+				std::string_view word(pBegin, static_cast<size_t>(m_pCur - pBegin));
+				if (word == "TRUE" || word == "true" || word == "1")
+				{
+					out = true;
+					return true;
+				}
+				if (word == "FALSE" || word == "false" || word == "0")
+				{
+					out = false;
+					return true;
+				}
+				return Fail("expected TRUE or FALSE");
+			}
+		};
+
+		//行が指定の文字列で始まっているか。
+		bool StartsWith(const char* line, size_t length, const char* prefix)
+		{
+			size_t prefixLength = std::strlen(prefix);
+			return length >= prefixLength && std::memcmp(line, prefix, prefixLength) == 0;
+		}
+
+		//アニメーション1つ分。{ "名前", x, y, 幅, 高さ, ループ, { {待機, No, Step}, ... } }
+		bool ParseAnimation(TextCursor& cursor, AnimInfoData& outInfo)
+		{
+			const char* pName;
+			size_t nameLength;
+
+			if (!cursor.Expect('{', "expected '{' before an animation")                         ||
+				!cursor.String(pName, nameLength)       || !cursor.Expect(',', "expected ','") ||
+				!cursor.Number(outInfo.offsetX)         || !cursor.Expect(',', "expected ','") ||
+				!cursor.Number(outInfo.offsetY)         || !cursor.Expect(',', "expected ','") ||
+				!cursor.Number(outInfo.width)           || !cursor.Expect(',', "expected ','") ||
+				!cursor.Number(outInfo.height)          || !cursor.Expect(',', "expected ','") ||
+				!cursor.Bool(outInfo.bLoop)             || !cursor.Expect(',', "expected ','") ||
+				!cursor.Expect('{', "expected '{' before the patterns"))
+			{
+				return false;
+			}
+
+			outInfo.name = AnimText::Utf8ToNative(std::string(pName, nameLength));
+			outInfo.pattern.clear();
+
+			while (!cursor.Accept('}'))
+			{
+				AnimPatternData ptn;
+				if (!cursor.Expect('{', "expected '{' before a pattern")       ||
+					!cursor.Number(ptn.wait) || !cursor.Expect(',', "expected ','") ||
+					!cursor.Number(ptn.no)   || !cursor.Expect(',', "expected ','") ||
+					!cursor.Number(ptn.step) ||
+					!cursor.Expect('}', "expected '}' after a pattern")        ||
+					!cursor.Separator('}', "expected ',' between patterns"))
+				{
+					return false;
+				}
+				outInfo.pattern.push_back(ptn);
+			}
+
+			return cursor.Expect('}', "expected '}' after an animation");
+		}
+
+#ifdef _WIN32
+		std::string ConvertCodePage(const std::string& str, UINT fromCodePage, UINT toCodePage)
+		{
+			if (str.empty())
+			{
+				return str;
+			}
+
+			int wideLength = MultiByteToWideChar(fromCodePage, 0, str.data(), static_cast<int>(str.size()), nullptr, 0);
+			std::wstring wide(static_cast<size_t>(wideLength), L'\0');
+			MultiByteToWideChar(fromCodePage, 0, str.data(), static_cast<int>(str.size()), wide.data(), wideLength);
+
+			int length = WideCharToMultiByte(toCodePage, 0, wide.data(), wideLength, nullptr, 0, nullptr, nullptr);
+			std::string result(static_cast<size_t>(length), '\0');
+			WideCharToMultiByte(toCodePage, 0, wide.data(), wideLength, result.data(), length, nullptr, nullptr);
+			return result;
+		}
+#endif
+	}
+
+	namespace AnimText
+	{
+		std::string NativeToUtf8(const std::string& str)
+		{
+#ifdef _WIN32
+			return ConvertCodePage(str, CP_ACP, CP_UTF8);
+#else
+			return str;
+#endif
+		}
+
+		std::string Utf8ToNative(const std::string& str)
+		{
+#ifdef _WIN32
+			return ConvertCodePage(str, CP_UTF8, CP_ACP);
+#else
+			return str;
+#endif
+		}
+
+		void AppendNumber(std::string& out, float value)
+		{
+			char buffer[64];
+
+			//floatで表せる最短の表記を使う。(GUIのdoubleをfloatにした時の誤差を出さないため)
+			//小数点以下が多すぎる場合だけFormatと同じく5桁に丸める。
+			auto [pEnd, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+			const char* pDot = (ec == std::errc()) ? std::char_traits<char>::find(buffer, static_cast<size_t>(pEnd - buffer), '.') : nullptr;
+
+			if (ec != std::errc() || (pDot != nullptr && pEnd - pDot - 1 > formatDecimalPlace))
+			{
+				int length = std::snprintf(buffer, sizeof(buffer), "%.*f", formatDecimalPlace, static_cast<double>(value));
+				pEnd = buffer + length;
+
+				//末尾の0と小数点を省く。
+				while (pEnd[-1] == '0')
+				{
+					--pEnd;
+				}
+				if (pEnd[-1] == '.')
+				{
+					--pEnd;
+				}
+			}
+
+			//-0は0として書く。
+			if (pEnd - buffer == 2 && buffer[0] == '-' && buffer[1] == '0')
+			{
+				out += '0';
+				return;
+			}
+			out.append(buffer, pEnd);
+		}
+
+		void AppendNumber(std::string& out, int32_t value)
+		{
+			char buffer[16];
+			auto [pEnd, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			out.append(buffer, pEnd);
+		}
+
+		void Export(const AnimDocument& doc, const std::string& animPath, std::string& outText)
+		{
+			//例：
+			//    {
+			//        {
+			//                "NewAnimaiton1",
+			//                0,0,
+			//                60,70,
+			//                TRUE,{{5,0,0},{5,1,0},{5,2,0},{5,3,0}}
+			//        },
+			//    };
+			size_t reserveSize = 256 + animPath.size() + doc.textureName.size();
+			for (const AnimInfoData& info : doc.animations)
+			{
+				reserveSize += animTextSize + info.name.size() + info.pattern.size() * patternTextSize;
+			}
+
+			outText.clear();
+			outText.reserve(reserveSize);
+
+			outText += utf8Bom;
+			outText += NativeToUtf8(animPath);
+			outText += '\n';
+			outText += textHeaderNotice;
+			outText += textTextureLabel;
+			outText += NativeToUtf8(doc.textureName);
+			outText += '\n';
+			outText += textCopyNotice;
+
+			outText += "{\n";
+			for (const AnimInfoData& info : doc.animations)
+			{
+				outText += "\t{\n";
+
+				//アニメーション名
+				outText += "\t\t\"";
+				outText += NativeToUtf8(info.name);
+				outText += "\",\n";
+
+				//オフセット位置
+				outText += "\t\t";
+				AppendNumber(outText, info.offsetX);
+				outText += ',';
+				AppendNumber(outText, info.offsetY);
+				outText += ",\n";
+
+				//幅、高さ
+				outText += "\t\t";
+				AppendNumber(outText, info.width);
+				outText += ',';
+				AppendNumber(outText, info.height);
+				outText += ",\n";
+
+				//ループフラグとアニメーションパターン
+				outText += info.bLoop ? "\t\tTRUE,{" : "\t\tFALSE,{";
+				for (size_t j = 0; j < info.pattern.size(); ++j)
+				{
+					const AnimPatternData& ptn = info.pattern[j];
+
+					//最後のパターン以外はカンマで区切る。
+					if (j != 0)
+					{
+						outText += ',';
+					}
+					outText += '{';
+					AppendNumber(outText, ptn.wait);
+					outText += ',';
+					AppendNumber(outText, ptn.no);
+					outText += ',';
+					AppendNumber(outText, ptn.step);
+					outText += '}';
+				}
+				outText += "}\n\t},\n";
+			}
+			outText += "};";
+		}
+
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc, const std::string& animPath)
+		{
+			std::string text;
+			Export(doc, animPath, text);
+			return AtomicFile::Write(path, text.data(), text.size());
+		}
+
+		bool Parse(const char* data, size_t size, AnimDocument& outDoc, std::string& outAnimPath, AnimTextError* pError)
+		{
+			//BOMは読み飛ばす。
+			if (size >= 3 && std::memcmp(data, utf8Bom, 3) == 0)
+			{
+				data += 3;
+				size -= 3;
+			}
+
+			TextCursor cursor(data, size);
+
+			outDoc.textureName.clear();
+			outDoc.animations.clear();
+
+			//1行目は.animのパス。
+			const char* pLine;
+			size_t lineLength;
+			cursor.ReadLine(pLine, lineLength);
+			outAnimPath = Utf8ToNative(std::string(pLine, lineLength));
+
+			//「以下コピペ用」の行か、ブロックが始まるまでに画像ファイル名の行があれば読んでおく。
+			size_t labelLength = std::strlen(textTextureLabel);
+			while (!cursor.IsEnd() && !cursor.LineStartsWith('{'))
+			{
+				cursor.ReadLine(pLine, lineLength);
+				if (StartsWith(pLine, lineLength, textTextureLabel))
+				{
+					outDoc.textureName = Utf8ToNative(std::string(pLine + labelLength, lineLength - labelLength));
+				}
+				//textCopyNoticeは改行込みなので改行を除いて比べる。
+				else if (lineLength + 1 == std::strlen(textCopyNotice) && std::memcmp(pLine, textCopyNotice, lineLength) == 0)
+				{
+					break;
+				}
+			}
+
+			bool bResult = cursor.SkipTo('{') || cursor.Fail("copy block not found");
+			if (bResult && cursor.Expect('{', "expected '{'"))
+			{
+				while (!cursor.Accept('}'))
+				{
+					outDoc.animations.emplace_back();
+					if (!ParseAnimation(cursor, outDoc.animations.back()) ||
+						!cursor.Separator('}', "expected ',' between animations"))
+					{
+						bResult = false;
+						break;
+					}
+				}
+			}
+			else
+			{
+				bResult = false;
+			}
+
+			//最後の;は省略してもよい。
+			if (bResult)
+			{
+				cursor.Accept(';');
+			}
+
+			if (!bResult && pError != nullptr)
+			{
+				pError->line    = cursor.Line();
+				pError->message = cursor.Error() != nullptr ? cursor.Error() : "unexpected end of file";
+			}
+			return bResult;
+		}
+
+		bool Load(const std::filesystem::path& path, AnimDocument& outDoc, std::string& outAnimPath, AnimTextError* pError)
+		{
+			std::vector<uint8_t> buffer;
+			if (!AnimCodec::ReadFile(path, buffer))
+			{
+				if (pError != nullptr)
+				{
+					pError->line    = 0;
+					pError->message = "failed to read";
+				}
+				return false;
+			}
+
+			if (!Parse(reinterpret_cast<const char*>(buffer.data()), buffer.size(), outDoc, outAnimPath, pError))
+			{
+				return false;
+			}
+
+			outDoc.textName = path.string();
+			return true;
+		}
+	}
+}
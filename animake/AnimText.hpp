@@ -0,0 +1,41 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+
+//.animと一緒に出力する.txtファイルの書き出しと読み込み。Siv3Dには依存しない。
+//.txtはBOM付きのUTF-8で、AnimDocumentの文字列(.animと同じバイト列)から変換して書き出す。
+//「以下コピペ用」のブロックを手で書き換えた.txtも読み込めるので、.txtを元データとして扱える。
+
+namespace siapp
+{
+	//読み込みに失敗した場所。
+	struct AnimTextError
+	{
+		size_t                       line     = 0;   //1から数えた行番号
+		const char*                  message  = "";
+	};
+
+	namespace AnimText
+	{
+		//.animと同じ文字コード(WindowsならANSI)の文字列とUTF-8を相互に変換する。Windows以外ではそのまま返す。
+		std::string NativeToUtf8(const std::string& str);
+		std::string Utf8ToNative(const std::string& str);
+
+		//数値をSiv3DのFormatと同じ書式(小数点以下5桁まで、末尾の0は省く)で書き足す。
+		void AppendNumber(std::string& out, float value);
+		void AppendNumber(std::string& out, int32_t value);
+
+		//.txtファイルの中身をメモリ上に作る。animPathは1行目に書く.animファイルのパス。
+		void Export(const AnimDocument& doc, const std::string& animPath, std::string& outText);
+
+		//Exportした結果を一度の書き込みで一時ファイルに書き出し、元のファイルと置き換える。(AtomicFile.hpp)
+		bool Save(const std::filesystem::path& path, const AnimDocument& doc, const std::string& animPath);
+
+		//メモリ上の.txtを読み込む。1行目の.animのパスをoutAnimPathに、画像ファイル名とブロックの中身をoutDocに返す。
+		//バッファの上を直接読み進めるので、確保するのはアニメーション名とパターンの配列だけ。
+		//空白、改行、//と/* */のコメント、末尾のカンマは無視する。ループフラグはTRUE/FALSEの他にtrue/false/1/0も読める。
+		bool Parse(const char* data, size_t size, AnimDocument& outDoc, std::string& outAnimPath, AnimTextError* pError = nullptr);
+
+		//ファイル全体を読み込んでParseする。outDoc.textNameには読み込んだ.txtのパスを入れる。
+		bool Load(const std::filesystem::path& path, AnimDocument& outDoc, std::string& outAnimPath, AnimTextError* pError = nullptr);
+	}
+}
@@ -0,0 +1,318 @@
+﻿#include "AnimV2.hpp"
+#include <cstring>
+#include <unordered_map>
+
+namespace siapp
+{
+	namespace
+	{
+		constexpr char animV2Magic[4] = { 'A', 'N', 'M', '2' };
+
+		size_t AlignUp4(size_t size)
+		{
+			return (size + 3) & ~static_cast<size_t>(3);
+		}
+
+		uint64_t HashPatterns(const std::vector<AnimPatternData>& pattern)
+		{
+			//FNV-1a。AnimPatternDataは隙間のない12バイトなので、そのままバイト列として扱う。
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(pattern.data());
+			size_t size         = sizeof(AnimPatternData) * pattern.size();
+
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		bool IsSamePatterns(const std::vector<AnimPatternData>& a, const std::vector<AnimPatternData>& b)
+		{
+			return a.size() == b.size() && std::memcmp(a.data(), b.data(), sizeof(AnimPatternData) * a.size()) == 0;
+		}
+
+		//同じパターンの並びを持つアニメーションを探す。outOwnersにはアニメーションごとに、パターンを書き込む側のアニメーション番号を入れる。
+		//戻り値はパターンテーブルに書くパターンの数。
+		size_t FindSharedPatterns(const AnimDocument& doc, std::vector<uint32_t>& outOwners)
+		{
+			std::unordered_multimap<uint64_t, uint32_t> owners;
+			owners.reserve(doc.animations.size());
+			outOwners.resize(doc.animations.size());
+
+			size_t patternCount = 0;
+			for (uint32_t i = 0; i < static_cast<uint32_t>(doc.animations.size()); ++i)
+			{
+				const std::vector<AnimPatternData>& pattern = doc.animations[i].pattern;
+				outOwners[i] = i;
+
+				if (pattern.empty())
+				{
+					continue;
+				}
+
+				uint64_t hash  = HashPatterns(pattern);
+				auto     range = owners.equal_range(hash);
+				for (auto it = range.first; it != range.second; ++it)
+				{
+					if (IsSamePatterns(doc.animations[it->second].pattern, pattern))
+					{
+						outOwners[i] = it->second;
+						break;
+					}
+				}
+
+				if (outOwners[i] == i)
+				{
+					owners.emplace(hash, i);
+					patternCount += pattern.size();
+				}
+			}
+			return patternCount;
+		}
+
+		//文字列テーブルの範囲内か調べる。終端の'\0'まで含めて確認する。
+		bool IsInStringTable(const AnimV2Header& header, uint32_t offset, uint32_t length)
+		{
+			return static_cast<uint64_t>(offset) + length < header.stringTableSize;
+		}
+	}
+
+	AnimV2View::AnimV2View(void) :
+		m_pData(nullptr),
+		m_pHeader(nullptr),
+		m_pRecords(nullptr),
+		m_pPatterns(nullptr),
+		m_pStrings(nullptr)
+	{
+	}
+
+	bool AnimV2View::Open(const uint8_t* data, size_t size)
+	{
+		m_pData = nullptr;
+
+		if (!AnimV2::IsFlat(data, size) || reinterpret_cast<uintptr_t>(data) % alignof(AnimV2Header) != 0)
+		{
+			return false;
+		}
+
+		const AnimV2Header* pHeader = reinterpret_cast<const AnimV2Header*>(data);
+		if (pHeader->version != animV2Version)
+		{
+			return false;
+		}
+
+		//各テーブルがファイル内に収まっていて、4バイト境界にあるか確認する。
+		uint64_t animTableEnd    = pHeader->animTableOffset    + static_cast<uint64_t>(pHeader->animCount)    * sizeof(AnimV2Record);
+		uint64_t patternTableEnd = pHeader->patternTableOffset + static_cast<uint64_t>(pHeader->patternCount) * sizeof(AnimPatternData);
+		uint64_t stringTableEnd  = pHeader->stringTableOffset  + static_cast<uint64_t>(pHeader->stringTableSize);
+		if (animTableEnd > size || patternTableEnd > size || stringTableEnd > size ||
+			pHeader->animTableOffset % 4 != 0 || pHeader->patternTableOffset % 4 != 0)
+		{
+			return false;
+		}
+
+		if (!IsInStringTable(*pHeader, pHeader->textureNameOffset, pHeader->textureNameLength) ||
+			!IsInStringTable(*pHeader, pHeader->textNameOffset, pHeader->textNameLength))
+		{
+			return false;
+		}
+
+		const AnimV2Record* pRecords = reinterpret_cast<const AnimV2Record*>(data + pHeader->animTableOffset);
+		for (uint32_t i = 0; i < pHeader->animCount; ++i)
+		{
+			const AnimV2Record& record = pRecords[i];
+			if (!IsInStringTable(*pHeader, record.nameOffset, record.nameLength) ||
+				static_cast<uint64_t>(record.patternIndex) + record.patternCount > pHeader->patternCount)
+			{
+				return false;
+			}
+		}
+
+		m_pData     = data;
+		m_pHeader   = pHeader;
+		m_pRecords  = pRecords;
+		m_pPatterns = reinterpret_cast<const AnimPatternData*>(data + pHeader->patternTableOffset);
+		m_pStrings  = reinterpret_cast<const char*>(data + pHeader->stringTableOffset);
+		return true;
+	}
+
+	uint32_t AnimV2View::AnimCount(void) const
+	{
+		return m_pData ? m_pHeader->animCount : 0;
+	}
+
+	const AnimV2Record& AnimV2View::Record(uint32_t index) const
+	{
+		return m_pRecords[index];
+	}
+
+	std::string_view AnimV2View::Name(uint32_t index) const
+	{
+		return std::string_view(m_pStrings + m_pRecords[index].nameOffset, m_pRecords[index].nameLength);
+	}
+
+	const AnimPatternData* AnimV2View::Patterns(uint32_t index) const
+	{
+		return m_pPatterns + m_pRecords[index].patternIndex;
+	}
+
+	uint32_t AnimV2View::PatternCount(uint32_t index) const
+	{
+		return m_pRecords[index].patternCount;
+	}
+
+	bool AnimV2View::IsLoop(uint32_t index) const
+	{
+		return (m_pRecords[index].flags & animV2LoopFlag) != 0;
+	}
+
+	std::string_view AnimV2View::TextureName(void) const
+	{
+		if (!m_pData)
+		{
+			return std::string_view();
+		}
+		return std::string_view(m_pStrings + m_pHeader->textureNameOffset, m_pHeader->textureNameLength);
+	}
+
+	std::string_view AnimV2View::TextName(void) const
+	{
+		if (!m_pData)
+		{
+			return std::string_view();
+		}
+		return std::string_view(m_pStrings + m_pHeader->textNameOffset, m_pHeader->textNameLength);
+	}
+
+	bool AnimV2File::Open(const std::filesystem::path& path)
+	{
+		if (!m_File.Open(path))
+		{
+			return false;
+		}
+		return m_View.Open(m_File.Data(), m_File.Size());
+	}
+
+	const AnimV2View& AnimV2File::View(void) const
+	{
+		return m_View;
+	}
+
+	namespace AnimV2
+	{
+		bool IsFlat(const uint8_t* data, size_t size)
+		{
+			return size >= sizeof(AnimV2Header) && std::memcmp(data, animV2Magic, sizeof(animV2Magic)) == 0;
+		}
+
+		void Encode(const AnimDocument& doc, std::vector<uint8_t>& outBuffer)
+		{
+			/// ###          v2形式の並びは以下の通り                  ###
+			//     ・ヘッダー                    ( AnimV2Header    )
+			//     ・アニメーションテーブル      ( AnimV2Record    × アニメーション数 )
+			//     ・パターンテーブル            ( AnimPatternData × 全パターン数     )  同じ並びは1つだけ書いて共有する
+			//     ・文字列テーブル              ( '\0'終端の文字列を詰めたもの       )
+			AnimV2Header header = {};
+			std::memcpy(header.magic, animV2Magic, sizeof(animV2Magic));
+			header.version   = animV2Version;
+			header.animCount = static_cast<uint32_t>(doc.animations.size());
+
+			//歩きのループをオフセット違いで使い回すなど、同じパターンの並びは多いので1つにまとめる。
+			//アニメーションテーブルは先頭位置と数でパターンを指すので、読み込む側はそのまま共有された並びを参照できる。
+			std::vector<uint32_t> owners;
+			size_t patternCount = FindSharedPatterns(doc, owners);
+			size_t stringSize   = doc.textureName.size() + 1 + doc.textName.size() + 1;
+			for (const AnimInfoData& info : doc.animations)
+			{
+				stringSize += info.name.size() + 1;
+			}
+
+			header.patternCount       = static_cast<uint32_t>(patternCount);
+			header.animTableOffset    = static_cast<uint32_t>(sizeof(AnimV2Header));
+			header.patternTableOffset = header.animTableOffset    + header.animCount * static_cast<uint32_t>(sizeof(AnimV2Record));
+			header.stringTableOffset  = header.patternTableOffset + header.patternCount * static_cast<uint32_t>(sizeof(AnimPatternData));
+			header.stringTableSize    = static_cast<uint32_t>(stringSize);
+
+			//ファイル全体を確保してからテーブルごとに直接書き込む。
+			outBuffer.assign(AlignUp4(header.stringTableOffset + stringSize), 0);
+
+			uint8_t*         pBase     = outBuffer.data();
+			AnimV2Record*    pRecords  = reinterpret_cast<AnimV2Record*>(pBase + header.animTableOffset);
+			AnimPatternData* pPatterns = reinterpret_cast<AnimPatternData*>(pBase + header.patternTableOffset);
+			char*            pStrings  = reinterpret_cast<char*>(pBase + header.stringTableOffset);
+
+			uint32_t stringPos = 0;
+			auto addString = [pStrings, &stringPos](const std::string& str, uint32_t& outOffset, uint32_t& outLength)
+			{
+				outOffset = stringPos;
+				outLength = static_cast<uint32_t>(str.size());
+				std::memcpy(pStrings + stringPos, str.data(), str.size());
+				stringPos += outLength + 1;
+			};
+
+			addString(doc.textureName, header.textureNameOffset, header.textureNameLength);
+			addString(doc.textName   , header.textNameOffset   , header.textNameLength   );
+
+			uint32_t patternIndex = 0;
+			for (size_t i = 0; i < doc.animations.size(); ++i)
+			{
+				const AnimInfoData& info = doc.animations[i];
+				AnimV2Record& record     = pRecords[i];
+
+				addString(info.name, record.nameOffset, record.nameLength);
+				record.offsetX      = info.offsetX;
+				record.offsetY      = info.offsetY;
+				record.width        = info.width;
+				record.height       = info.height;
+				record.patternCount = static_cast<uint32_t>(info.pattern.size());
+				record.flags        = info.bLoop ? animV2LoopFlag : 0;
+
+				//前に同じ並びを書いていれば、その位置を指すだけにする。
+				if (owners[i] != i)
+				{
+					record.patternIndex = pRecords[owners[i]].patternIndex;
+					continue;
+				}
+
+				record.patternIndex = patternIndex;
+				if (!info.pattern.empty())
+				{
+					std::memcpy(pPatterns + patternIndex, info.pattern.data(), sizeof(AnimPatternData) * info.pattern.size());
+				}
+				patternIndex += record.patternCount;
+			}
+
+			std::memcpy(pBase, &header, sizeof(AnimV2Header));
+		}
+
+		bool Decode(const uint8_t* data, size_t size, AnimDocument& outDoc)
+		{
+			AnimV2View view;
+			if (!view.Open(data, size))
+			{
+				return false;
+			}
+
+			outDoc.textureName = view.TextureName();
+			outDoc.textName    = view.TextName();
+			outDoc.animations.resize(view.AnimCount());
+
+			for (uint32_t i = 0; i < view.AnimCount(); ++i)
+			{
+				const AnimV2Record& record = view.Record(i);
+				AnimInfoData& info         = outDoc.animations[i];
+
+				info.name    = view.Name(i);
+				info.offsetX = record.offsetX;
+				info.offsetY = record.offsetY;
+				info.width   = record.width;
+				info.height  = record.height;
+				info.bLoop   = view.IsLoop(i);
+				info.pattern.assign(view.Patterns(i), view.Patterns(i) + view.PatternCount(i));
+			}
+			return true;
+		}
+	}
+}
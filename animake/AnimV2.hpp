@@ -0,0 +1,94 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+#include "MappedFile.hpp"
+#include <string_view>
+
+//.anim v2形式。ヘッダー、アニメーションテーブル、パターンテーブル、文字列テーブルの順に並べた固定長レイアウト。
+//各テーブルは4バイト境界に揃えてあるので、マップしたファイルをそのまま参照できる。
+
+namespace siapp
+{
+	struct AnimV2Header
+	{
+		char                         magic[4];           //"ANM2"
+		uint32_t                     version;
+		uint32_t                     animCount;
+		uint32_t                     patternCount;
+		uint32_t                     animTableOffset;
+		uint32_t                     patternTableOffset;
+		uint32_t                     stringTableOffset;
+		uint32_t                     stringTableSize;
+		uint32_t                     textureNameOffset;  //文字列テーブル内の位置
+		uint32_t                     textureNameLength;
+		uint32_t                     textNameOffset;     //文字列テーブル内の位置
+		uint32_t                     textNameLength;
+	};
+
+	struct AnimV2Record
+	{
+		uint32_t                     nameOffset;         //文字列テーブル内の位置
+		uint32_t                     nameLength;
+		float                        offsetX;
+		float                        offsetY;
+		float                        width;
+		float                        height;
+		uint32_t                     patternIndex;       //パターンテーブル内の先頭番号
+		uint32_t                     patternCount;
+		uint32_t                     flags;
+	};
+
+	constexpr uint32_t               animV2Version      = 2;
+	constexpr uint32_t               animV2LoopFlag     = 1u << 0;
+
+	static_assert(sizeof(AnimV2Header)    == 48, "AnimV2Header must match the file layout");
+	static_assert(sizeof(AnimV2Record)    == 36, "AnimV2Record must match the file layout");
+	static_assert(sizeof(AnimPatternData) == 12, "AnimPatternData must match the file layout");
+
+	//v2形式のデータをコピーせずに参照する。文字列は文字列テーブル内でnull終端されている。
+	class AnimV2View
+	{
+	private:
+		const uint8_t*               m_pData;
+		const AnimV2Header*          m_pHeader;
+		const AnimV2Record*          m_pRecords;
+		const AnimPatternData*       m_pPatterns;
+		const char*                  m_pStrings;
+	public:
+		AnimV2View(void);
+
+		//ヘッダーと各テーブルの範囲を確認して参照を張る。データは4バイト境界に置かれている必要がある。
+		bool Open(const uint8_t* data, size_t size);
+
+		uint32_t AnimCount(void) const;
+		const AnimV2Record& Record(uint32_t index) const;
+		std::string_view Name(uint32_t index) const;
+		const AnimPatternData* Patterns(uint32_t index) const;
+		uint32_t PatternCount(uint32_t index) const;
+		bool IsLoop(uint32_t index) const;
+
+		std::string_view TextureName(void) const;
+		std::string_view TextName(void) const;
+	};
+
+	//v2形式のファイルをマップして、そのままAnimV2Viewで参照できるようにする。
+	class AnimV2File
+	{
+	private:
+		MappedFile                   m_File;
+		AnimV2View                   m_View;
+	public:
+		bool Open(const std::filesystem::path& path);
+		const AnimV2View& View(void) const;
+	};
+
+	namespace AnimV2
+	{
+		//先頭のマジックナンバーでv2形式か調べる。
+		bool IsFlat(const uint8_t* data, size_t size);
+
+		void Encode(const AnimDocument& doc, std::vector<uint8_t>& outBuffer);
+
+		//編集用にAnimDocumentへ展開する。
+		bool Decode(const uint8_t* data, size_t size, AnimDocument& outDoc);
+	}
+}
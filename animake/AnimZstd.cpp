@@ -0,0 +1,321 @@
+﻿#include "AnimZstd.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if ANIMAKE_ZSTD_SIV3D
+#	include <Siv3D/ByteArray.hpp>
+#	include <Siv3D/ByteArrayView.hpp>
+#	include <Siv3D/Compression.hpp>
+#elif ANIMAKE_ZSTD_ENABLED
+#	include <zstd.h>
+#endif
+
+namespace siapp
+{
+	namespace
+	{
+		constexpr char     animZstdMagic[4]  = { 'A', 'N', 'M', 'Z' };
+		constexpr uint32_t animZstdVersion   = 1;
+
+		//壊れたヘッダーで巨大な領域を確保しないようにするための上限。
+		constexpr uint64_t animZstdMaxRawSize = 1ull << 30;
+
+#if ANIMAKE_ZSTD_ENABLED
+		std::FILE* OpenFileForRead(const std::filesystem::path& path)
+		{
+#ifdef _WIN32
+			std::FILE* pFile = nullptr;
+			if (_wfopen_s(&pFile, path.c_str(), L"rb") != 0)
+			{
+				return nullptr;
+			}
+			return pFile;
+#else
+			return std::fopen(path.c_str(), "rb");
+#endif
+		}
+
+		bool IsValidHeader(const AnimZstdHeader& header)
+		{
+			return std::memcmp(header.magic, animZstdMagic, sizeof(animZstdMagic)) == 0 &&
+				header.version == animZstdVersion &&
+				header.rawSize <= animZstdMaxRawSize;
+		}
+#endif
+
+#if ANIMAKE_ZSTD_SIV3D
+		//s3d::Compressionで展開し、展開後のサイズがヘッダーと合う時だけ受け取る。
+		bool DecompressFrame(const uint8_t* data, size_t size, uint64_t rawSize, std::vector<uint8_t>& outBuffer)
+		{
+			s3d::ByteArray raw = s3d::Compression::Decompress(s3d::ByteArrayView(data, size));
+			if (static_cast<uint64_t>(raw.size()) != rawSize)
+			{
+				outBuffer.clear();
+				return false;
+			}
+
+			outBuffer.resize(static_cast<size_t>(raw.size()));
+			if (!outBuffer.empty())
+			{
+				std::memcpy(outBuffer.data(), raw.data(), outBuffer.size());
+			}
+			return true;
+		}
+#endif
+	}
+
+	AnimZstdStream::AnimZstdStream(void) :
+		m_pFile(nullptr),
+		m_pDStream(nullptr),
+		m_InBuffer(),
+		m_InPos(0),
+		m_InSize(0),
+		m_RawSize(0),
+		m_ReadSize(0)
+	{
+	}
+
+	AnimZstdStream::~AnimZstdStream(void)
+	{
+		Close();
+	}
+
+	bool AnimZstdStream::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+#if ANIMAKE_ZSTD_ENABLED
+		m_pFile = OpenFileForRead(path);
+		if (m_pFile == nullptr)
+		{
+			return false;
+		}
+
+		AnimZstdHeader header;
+		if (std::fread(&header, sizeof(AnimZstdHeader), 1, m_pFile) != 1 || !IsValidHeader(header))
+		{
+			Close();
+			return false;
+		}
+
+#if ANIMAKE_ZSTD_SIV3D
+		//残りを全て読んでから展開する。展開したものはm_InBufferに置き、Readではそこから写す。
+		std::vector<uint8_t> compressed;
+		uint8_t chunk[64 * 1024];
+		for (size_t readSize; (readSize = std::fread(chunk, 1, sizeof(chunk), m_pFile)) != 0; )
+		{
+			compressed.insert(compressed.end(), chunk, chunk + readSize);
+		}
+		std::fclose(m_pFile);
+		m_pFile = nullptr;
+
+		if (!DecompressFrame(compressed.data(), compressed.size(), header.rawSize, m_InBuffer))
+		{
+			Close();
+			return false;
+		}
+
+		m_InPos   = 0;
+		m_InSize  = m_InBuffer.size();
+		m_RawSize = header.rawSize;
+		return true;
+#else
+		ZSTD_DStream* pDStream = ZSTD_createDStream();
+		if (pDStream == nullptr || ZSTD_isError(ZSTD_initDStream(pDStream)))
+		{
+			ZSTD_freeDStream(pDStream);
+			Close();
+			return false;
+		}
+
+		m_pDStream = pDStream;
+		m_InBuffer.resize(ZSTD_DStreamInSize());
+		m_RawSize  = header.rawSize;
+		return true;
+#endif
+#else
+		(void)path;
+		return false;
+#endif
+	}
+
+	void AnimZstdStream::Close(void)
+	{
+#if ANIMAKE_ZSTD_ENABLED && !ANIMAKE_ZSTD_SIV3D
+		if (m_pDStream)
+		{
+			ZSTD_freeDStream(static_cast<ZSTD_DStream*>(m_pDStream));
+		}
+#endif
+		if (m_pFile)
+		{
+			std::fclose(m_pFile);
+		}
+		m_pFile    = nullptr;
+		m_pDStream = nullptr;
+		m_InPos    = 0;
+		m_InSize   = 0;
+		m_RawSize  = 0;
+		m_ReadSize = 0;
+	}
+
+	size_t AnimZstdStream::Read(void* dst, size_t size)
+	{
+#if ANIMAKE_ZSTD_SIV3D
+		size_t copySize = std::min(size, m_InSize - m_InPos);
+		if (copySize > 0)
+		{
+			std::memcpy(dst, m_InBuffer.data() + m_InPos, copySize);
+		}
+		m_InPos    += copySize;
+		m_ReadSize += copySize;
+		return copySize;
+#elif ANIMAKE_ZSTD_ENABLED
+		if (m_pDStream == nullptr)
+		{
+			return 0;
+		}
+
+		ZSTD_outBuffer output = { dst, size, 0 };
+
+		while (output.pos < output.size)
+		{
+			//入力が尽きたら次の塊をファイルから読む。
+			if (m_InPos == m_InSize)
+			{
+				m_InSize = std::fread(m_InBuffer.data(), 1, m_InBuffer.size(), m_pFile);
+				m_InPos  = 0;
+				if (m_InSize == 0)
+				{
+					break;
+				}
+			}
+
+			ZSTD_inBuffer input = { m_InBuffer.data(), m_InSize, m_InPos };
+			size_t ret = ZSTD_decompressStream(static_cast<ZSTD_DStream*>(m_pDStream), &output, &input);
+			m_InPos = input.pos;
+
+			if (ZSTD_isError(ret))
+			{
+				break;
+			}
+
+			//フレームの終わりまで展開した。
+			if (ret == 0)
+			{
+				break;
+			}
+		}
+
+		m_ReadSize += output.pos;
+		return output.pos;
+#else
+		(void)dst;
+		(void)size;
+		return 0;
+#endif
+	}
+
+	uint64_t AnimZstdStream::RawSize(void) const
+	{
+		return m_RawSize;
+	}
+
+	namespace AnimZstd
+	{
+		bool IsAvailable(void)
+		{
+			return ANIMAKE_ZSTD_ENABLED != 0;
+		}
+
+		bool IsCompressed(const uint8_t* data, size_t size)
+		{
+			return size >= sizeof(AnimZstdHeader) && std::memcmp(data, animZstdMagic, sizeof(animZstdMagic)) == 0;
+		}
+
+		bool Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& outBuffer, int level)
+		{
+#if ANIMAKE_ZSTD_ENABLED
+			AnimZstdHeader header = {};
+			std::memcpy(header.magic, animZstdMagic, sizeof(animZstdMagic));
+			header.version = animZstdVersion;
+			header.rawSize = size;
+
+#if ANIMAKE_ZSTD_SIV3D
+			s3d::ByteArray compressed = s3d::Compression::Compress(s3d::ByteArrayView(data, size), level);
+			if (compressed.size() == 0)
+			{
+				outBuffer.clear();
+				return false;
+			}
+
+			outBuffer.resize(sizeof(AnimZstdHeader) + static_cast<size_t>(compressed.size()));
+			std::memcpy(outBuffer.data(), &header, sizeof(AnimZstdHeader));
+			std::memcpy(outBuffer.data() + sizeof(AnimZstdHeader), compressed.data(), static_cast<size_t>(compressed.size()));
+			return true;
+#else
+			outBuffer.resize(sizeof(AnimZstdHeader) + ZSTD_compressBound(size));
+			std::memcpy(outBuffer.data(), &header, sizeof(AnimZstdHeader));
+
+			size_t compressedSize = ZSTD_compress(outBuffer.data() + sizeof(AnimZstdHeader), outBuffer.size() - sizeof(AnimZstdHeader), data, size, level);
+			if (ZSTD_isError(compressedSize))
+			{
+				outBuffer.clear();
+				return false;
+			}
+
+			outBuffer.resize(sizeof(AnimZstdHeader) + compressedSize);
+			return true;
+#endif
+#else
+			(void)data;
+			(void)size;
+			(void)level;
+			outBuffer.clear();
+			return false;
+#endif
+		}
+
+		bool Decompress(const uint8_t* data, size_t size, std::vector<uint8_t>& outBuffer)
+		{
+#if ANIMAKE_ZSTD_ENABLED
+			if (!IsCompressed(data, size))
+			{
+				return false;
+			}
+
+			AnimZstdHeader header;
+			std::memcpy(&header, data, sizeof(AnimZstdHeader));
+			if (!IsValidHeader(header))
+			{
+				return false;
+			}
+
+#if ANIMAKE_ZSTD_SIV3D
+			return DecompressFrame(data + sizeof(AnimZstdHeader), size - sizeof(AnimZstdHeader), header.rawSize, outBuffer);
+#else
+			outBuffer.resize(static_cast<size_t>(header.rawSize));
+			size_t rawSize = ZSTD_decompress(outBuffer.data(), outBuffer.size(), data + sizeof(AnimZstdHeader), size - sizeof(AnimZstdHeader));
+			return !ZSTD_isError(rawSize) && rawSize == header.rawSize;
+#endif
+#else
+			(void)data;
+			(void)size;
+			outBuffer.clear();
+			return false;
+#endif
+		}
+
+		bool DecompressFile(const std::filesystem::path& path, std::vector<uint8_t>& outBuffer)
+		{
+			AnimZstdStream stream;
+			if (!stream.Open(path))
+			{
+				return false;
+			}
+
+			outBuffer.resize(static_cast<size_t>(stream.RawSize()));
+			return stream.Read(outBuffer.data(), outBuffer.size()) == outBuffer.size();
+		}
+	}
+}
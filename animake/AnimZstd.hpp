@@ -0,0 +1,79 @@
+﻿#pragma once
+#include <cstdio>
+#include "AnimCodec.hpp"
+
+//zstdで圧縮した.animのコンテナ。中身は従来の形式かv2形式の.animそのまま。
+//エディタ(Siv3Dのインクルードパスがある時)はSiv3Dに組み込まれているzstd(s3d::Compression)を使うので、libzstdを別にリンクしなくてよい。
+//Siv3Dなしのツールはzstd.hがあればlibzstdを使う。
+//どちらも普通のzstdのフレームを書くので、ツールで書いたファイルとエディタで書いたファイルは互いに読める。
+//どちらも見つからない環境では圧縮ファイルの読み書きだけが無効になる。
+
+#if __has_include(<Siv3D/Compression.hpp>)
+#	define ANIMAKE_ZSTD_ENABLED 1
+#	define ANIMAKE_ZSTD_SIV3D   1
+#elif __has_include(<zstd.h>)
+#	define ANIMAKE_ZSTD_ENABLED 1
+#	define ANIMAKE_ZSTD_SIV3D   0
+#else
+#	define ANIMAKE_ZSTD_ENABLED 0
+#	define ANIMAKE_ZSTD_SIV3D   0
+#endif
+
+namespace siapp
+{
+	struct AnimZstdHeader
+	{
+		char                         magic[4];           //"ANMZ"
+		uint32_t                     version;
+		uint64_t                     rawSize;            //展開後のサイズ
+	};
+
+	static_assert(sizeof(AnimZstdHeader) == 16, "AnimZstdHeader must match the file layout");
+
+	//圧縮された.animファイルを少しずつ読みながら展開する。
+	//s3d::Compressionには少しずつ展開する関数がないので、Siv3Dのzstdを使う時はOpenでまとめて展開しておく。
+	class AnimZstdStream
+	{
+	private:
+		std::FILE*                   m_pFile;
+		void*                        m_pDStream;
+		std::vector<uint8_t>         m_InBuffer;         //Siv3Dのzstdを使う時は展開したもの
+		size_t                       m_InPos;
+		size_t                       m_InSize;
+		uint64_t                     m_RawSize;
+		uint64_t                     m_ReadSize;
+	public:
+		AnimZstdStream(void);
+		~AnimZstdStream(void);
+		AnimZstdStream(const AnimZstdStream&) = delete;
+		AnimZstdStream& operator= (const AnimZstdStream&) = delete;
+
+		//ファイルを開いてヘッダーを読む。圧縮ファイルでなければfalseを返す。
+		bool Open(const std::filesystem::path& path);
+		void Close(void);
+
+		//展開したデータを最大size分読み込む。読み込めたサイズを返す。
+		size_t Read(void* dst, size_t size);
+
+		uint64_t RawSize(void) const;
+	};
+
+	namespace AnimZstd
+	{
+		constexpr int                compressionLevel    = 9;
+
+		bool IsAvailable(void);
+
+		//先頭のマジックナンバーで圧縮ファイルか調べる。
+		bool IsCompressed(const uint8_t* data, size_t size);
+
+		//エンコード済みの.animデータを圧縮する。
+		bool Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& outBuffer, int level = compressionLevel);
+
+		//メモリ上の圧縮データを展開する。
+		bool Decompress(const uint8_t* data, size_t size, std::vector<uint8_t>& outBuffer);
+
+		//ファイル全体をメモリに置かずにAnimZstdStreamで展開する。
+		bool DecompressFile(const std::filesystem::path& path, std::vector<uint8_t>& outBuffer);
+	}
+}
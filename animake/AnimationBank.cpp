@@ -0,0 +1,154 @@
+﻿#include "AnimationBank.hpp"
+#include <algorithm>
+
+namespace siapp
+{
+	AnimationBank::AnimationBank(const AnimDocument& doc)
+	{
+		Assign(doc);
+	}
+
+	void AnimationBank::Assign(const AnimDocument& doc)
+	{
+		Clear();
+
+		size_t patternCount = 0;
+		for (const AnimInfoData& info : doc.animations)
+		{
+			patternCount += info.pattern.size();
+		}
+
+		Reserve(doc.animations.size(), patternCount);
+
+		for (const AnimInfoData& info : doc.animations)
+		{
+			Append(info);
+		}
+	}
+
+	void AnimationBank::Clear(void)
+	{
+		m_NameIndex.Clear();
+		m_OffsetX.clear();
+		m_OffsetY.clear();
+		m_Width.clear();
+		m_Height.clear();
+		m_Loop.clear();
+		m_PatternOffset.clear();
+		m_PatternCount.clear();
+		m_Patterns.clear();
+		m_FrameRects.clear();
+		m_bFrameRectsBaked = false;
+	}
+
+	void AnimationBank::Reserve(size_t animCount, size_t patternCount)
+	{
+		m_NameIndex.Reserve(animCount);
+		m_OffsetX.reserve(animCount);
+		m_OffsetY.reserve(animCount);
+		m_Width.reserve(animCount);
+		m_Height.reserve(animCount);
+		m_Loop.reserve(animCount);
+		m_PatternOffset.reserve(animCount);
+		m_PatternCount.reserve(animCount);
+		m_Patterns.reserve(patternCount);
+	}
+
+	size_t AnimationBank::Append(const AnimInfoData& info)
+	{
+		m_NameIndex.Add(info.name);
+		m_OffsetX.push_back(info.offsetX);
+		m_OffsetY.push_back(info.offsetY);
+		m_Width.push_back(info.width);
+		m_Height.push_back(info.height);
+		m_Loop.push_back(info.bLoop ? 1 : 0);
+		m_PatternOffset.push_back(static_cast<uint32_t>(m_Patterns.size()));
+		m_PatternCount.push_back(static_cast<uint32_t>(info.pattern.size()));
+		m_Patterns.insert(m_Patterns.end(), info.pattern.begin(), info.pattern.end());
+
+		//切り出し矩形を読み始めた後に足したものは、その分だけ計算して表を揃えておく。
+		size_t index = m_NameIndex.Count() - 1;
+		if (m_bFrameRectsBaked)
+		{
+			m_FrameRects.resize(m_Patterns.size());
+			BakeFrameRects(index);
+		}
+		return index;
+	}
+
+	void AnimationBank::BakeFrameRects(size_t index) const
+	{
+		size_t begin = m_PatternOffset[index];
+		size_t end   = begin + m_PatternCount[index];
+		for (size_t j = begin; j < end; ++j)
+		{
+			m_FrameRects[j] = BakeFrameRect(m_OffsetX[index], m_OffsetY[index], m_Width[index], m_Height[index], m_Patterns[j].no, m_Patterns[j].step, m_TextureWidth, m_TextureHeight);
+		}
+	}
+
+	void AnimationBank::BakeAllFrameRects(void) const
+	{
+		m_FrameRects.resize(m_Patterns.size());
+		for (size_t i = 0; i < AnimCount(); ++i)
+		{
+			BakeFrameRects(i);
+		}
+		m_bFrameRectsBaked = true;
+	}
+
+	void AnimationBank::SetTextureSize(float width, float height)
+	{
+		if (m_TextureWidth == width && m_TextureHeight == height)
+		{
+			return;
+		}
+
+		m_TextureWidth     = width;
+		m_TextureHeight    = height;
+		m_bFrameRectsBaked = false;
+	}
+
+	void AnimationBank::SetRect(size_t index, float offsetX, float offsetY, float width, float height)
+	{
+		m_OffsetX[index] = offsetX;
+		m_OffsetY[index] = offsetY;
+		m_Width[index]   = width;
+		m_Height[index]  = height;
+		if (m_bFrameRectsBaked)
+		{
+			BakeFrameRects(index);
+		}
+	}
+
+	void AnimationBank::SetPattern(size_t patternIndex, const AnimPatternData& pattern)
+	{
+		m_Patterns[patternIndex] = pattern;
+		if (!m_bFrameRectsBaked)
+		{
+			return;
+		}
+
+		size_t index = FindAnimationOfPattern(patternIndex);
+		m_FrameRects[patternIndex] = BakeFrameRect(m_OffsetX[index], m_OffsetY[index], m_Width[index], m_Height[index], pattern.no, pattern.step, m_TextureWidth, m_TextureHeight);
+	}
+
+	size_t AnimationBank::FindAnimationOfPattern(size_t patternIndex) const
+	{
+		//先頭番号は昇順に並んでいる。パターンが0個のアニメーションは同じ先頭番号を持つので、最後のものを選ぶ。
+		auto it = std::upper_bound(m_PatternOffset.begin(), m_PatternOffset.end(), static_cast<uint32_t>(patternIndex));
+		return static_cast<size_t>(it - m_PatternOffset.begin()) - 1;
+	}
+
+	void AnimationBank::GetAnimData(size_t index, AnimInfoData& outInfo) const
+	{
+		AnimPatternSpan span = Patterns(index);
+
+		outInfo.name    = m_NameIndex.Name(index);
+		outInfo.offsetX = m_OffsetX[index];
+		outInfo.offsetY = m_OffsetY[index];
+		outInfo.width   = m_Width[index];
+		outInfo.height  = m_Height[index];
+		outInfo.bLoop   = m_Loop[index] != 0;
+		outInfo.pattern.assign(span.begin(), span.end());
+	}
+}
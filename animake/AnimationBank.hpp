@@ -0,0 +1,131 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+#include "AnimFrameRect.hpp"
+#include "AnimNameIndex.hpp"
+
+//全てのアニメーションを項目ごとの配列(列)で持つ読み取り用の表。Siv3Dには依存しない。
+//パターンは全アニメーション分を1つの配列に詰め、各アニメーションはその中の先頭番号と個数だけを持つ。
+//書き出しや検証、再生のように全体を順番に辿る処理は、アニメーションごとの配列を辿らずに済む。
+//並びはv2形式のテーブル(AnimV2.hpp)と同じで、パターンの通し番号もそのまま一致する。
+//パターンごとの切り出し矩形とUVもパターン配列と同じ並びで持ち、書き出しや再生ではそれを読むだけにする。
+//切り出し矩形の表はパターン配列より大きいので、検証のように使わない処理では作らず、最初に読まれた時にまとめて計算する。
+
+namespace siapp
+{
+	//パターン配列や切り出し矩形の配列の一部分。元のAnimationBankに足すまで有効。
+	template<class T>
+	struct AnimSpan
+	{
+		const T*                     pData   = nullptr;
+		uint32_t                     count   = 0;
+
+		const T* begin(void) const { return pData; }
+		const T* end(void) const { return pData + count; }
+		size_t size(void) const { return count; }
+		bool empty(void) const { return count == 0; }
+		const T& operator[] (size_t index) const { return pData[index]; }
+	};
+
+	using AnimPatternSpan   = AnimSpan<AnimPatternData>;
+	using AnimFrameRectSpan = AnimSpan<AnimFrameRect>;
+
+	class AnimationBank
+	{
+	private:
+		AnimNameIndex                m_NameIndex;
+		std::vector<float>           m_OffsetX;
+		std::vector<float>           m_OffsetY;
+		std::vector<float>           m_Width;
+		std::vector<float>           m_Height;
+		std::vector<uint8_t>         m_Loop;
+		std::vector<uint32_t>        m_PatternOffset;    //m_Patterns内の先頭番号
+		std::vector<uint32_t>        m_PatternCount;
+		std::vector<AnimPatternData> m_Patterns;
+		mutable std::vector<AnimFrameRect> m_FrameRects; //m_Patternsと同じ並び。m_bFrameRectsBakedの間だけ使える
+		mutable bool                 m_bFrameRectsBaked = false;
+		float                        m_TextureWidth  = 0.0f;
+		float                        m_TextureHeight = 0.0f;
+
+		//アニメーション1つ分の切り出し矩形を計算し直す。
+		void BakeFrameRects(size_t index) const;
+
+		//全ての切り出し矩形を計算する。
+		void BakeAllFrameRects(void) const;
+	public:
+		AnimationBank(void) = default;
+		explicit AnimationBank(const AnimDocument& doc);
+
+		//AnimDocumentの中身で作り直す。各列とパターン配列は先に全体の数を数えて一度だけ確保する。
+		void Assign(const AnimDocument& doc);
+		void Clear(void);
+		void Reserve(size_t animCount, size_t patternCount);
+
+		//アニメーション1つ分を後ろに足して、その番号を返す。
+		size_t Append(const AnimInfoData& info);
+
+		//毎フレーム辿る処理から呼ぶので、読み取りはここで定義して呼び出しの分を省く。
+		size_t AnimCount(void) const { return m_NameIndex.Count(); }
+		size_t PatternCount(void) const { return m_Patterns.size(); }
+
+		const std::string& Name(size_t index) const { return m_NameIndex.Name(index); }
+		float OffsetX(size_t index) const { return m_OffsetX[index]; }
+		float OffsetY(size_t index) const { return m_OffsetY[index]; }
+		float Width(size_t index) const { return m_Width[index]; }
+		float Height(size_t index) const { return m_Height[index]; }
+		bool IsLoop(size_t index) const { return m_Loop[index] != 0; }
+		uint32_t PatternOffset(size_t index) const { return m_PatternOffset[index]; }
+
+		AnimPatternSpan Patterns(size_t index) const
+		{
+			return AnimPatternSpan{ m_Patterns.data() + m_PatternOffset[index], m_PatternCount[index] };
+		}
+
+		//パターンごとの切り出し矩形とUV。Patternsと同じ並び。
+		AnimFrameRectSpan FrameRects(size_t index) const
+		{
+			return AnimFrameRectSpan{ FrameRectPool().data() + m_PatternOffset[index], m_PatternCount[index] };
+		}
+
+		//列そのもの。全アニメーションの同じ項目を続けて調べる時に使う。
+		const std::vector<std::string>& NameColumn(void) const { return m_NameIndex.Names(); }
+		const std::vector<float>& OffsetXColumn(void) const { return m_OffsetX; }
+		const std::vector<float>& OffsetYColumn(void) const { return m_OffsetY; }
+		const std::vector<float>& WidthColumn(void) const { return m_Width; }
+		const std::vector<float>& HeightColumn(void) const { return m_Height; }
+		const std::vector<uint8_t>& LoopColumn(void) const { return m_Loop; }
+		const std::vector<uint32_t>& PatternOffsetColumn(void) const { return m_PatternOffset; }
+		const std::vector<uint32_t>& PatternCountColumn(void) const { return m_PatternCount; }
+
+		//全アニメーションのパターンを通し番号で並べたもの。
+		const std::vector<AnimPatternData>& PatternPool(void) const { return m_Patterns; }
+
+		//切り出し矩形は初めて読んだ時に計算するので、1つの表を複数のスレッドから読む時は先に1回呼んでおく。
+		const std::vector<AnimFrameRect>& FrameRectPool(void) const
+		{
+			if (!m_bFrameRectsBaked)
+			{
+				BakeAllFrameRects();
+			}
+			return m_FrameRects;
+		}
+
+		//UVを計算する画像の大きさ。変えると全ての切り出し矩形を次に読む時に計算し直す。大きさが0の間はUVも0になる。
+		void SetTextureSize(float width, float height);
+		float TextureWidth(void) const { return m_TextureWidth; }
+		float TextureHeight(void) const { return m_TextureHeight; }
+
+		//矩形やパターンを書き換える。切り出し矩形を計算済みなら、書き換えた分だけ計算し直す。
+		void SetRect(size_t index, float offsetX, float offsetY, float width, float height);
+		void SetPattern(size_t patternIndex, const AnimPatternData& pattern);
+
+		//名前からアニメーションの番号を引く。なければAnimNameIndex::nposを返す。同じ名前が並んでいれば一番前のもの。
+		size_t FindAnimation(std::string_view name) const { return m_NameIndex.Find(name); }
+		const AnimNameIndex& NameIndex(void) const { return m_NameIndex; }
+
+		//パターンの通し番号から、そのパターンを持つアニメーションの番号を引く。
+		size_t FindAnimationOfPattern(size_t patternIndex) const;
+
+		//アニメーション1つ分をAnimInfoDataに戻す。
+		void GetAnimData(size_t index, AnimInfoData& outInfo) const;
+	};
+}
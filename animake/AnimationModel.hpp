@@ -0,0 +1,182 @@
+﻿#pragma once
+#include "AnimFrameRect.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//エディタで編集するアニメーションのデータ。Siv3Dには依存しない。
+//どれもコピーとムーブはメンバーのものをそのまま使う。配列が伸びた時や要素を消した時はムーブで済む。
+
+namespace siapp
+{
+	//新しく作ったアニメーションが最初に持っているパターンの数。
+	constexpr size_t                 defaultPatternCount = 30;
+
+	struct AnimationPattern
+	{
+		double                       wait    = 1.0;
+		int                          no      = 0;
+		int                          step    = 0;
+	};
+
+	//アニメーションパターンの配列。同じ並びを持つアニメーション同士で中身を共有し、書き換える時だけ複製する。
+	//読むだけならそのまま参照し、書き換える時は必ずEditで受け取ること。
+	class AnimationPatternArray
+	{
+	private:
+		std::shared_ptr<std::vector<AnimationPattern>> m_pArray;
+		uint64_t                     m_Revision = 0;     //中身を受け取るかEditするたびに振り直す通し番号。0は空
+
+		static uint64_t NextRevision(void)
+		{
+			static std::atomic<uint64_t> revision(0);
+			return ++revision;
+		}
+	public:
+		AnimationPatternArray(void) = default;
+
+		explicit AnimationPatternArray(const std::shared_ptr<std::vector<AnimationPattern>>& pArray) :
+			m_pArray(pArray),
+			m_Revision(NextRevision())
+		{
+		}
+
+		explicit AnimationPatternArray(std::shared_ptr<std::vector<AnimationPattern>>&& pArray) :
+			m_pArray(std::move(pArray)),
+			m_Revision(NextRevision())
+		{
+		}
+
+		//新しく作ったアニメーション用の、初期状態のパターンがdefaultPatternCount個並んだ配列。
+		//全てのアニメーションで1つの配列を共有するので、作るたびに確保しない。
+		static AnimationPatternArray Default(void)
+		{
+			static const AnimationPatternArray defaultArray(std::make_shared<std::vector<AnimationPattern>>(defaultPatternCount));
+			return defaultArray;
+		}
+
+		size_t size(void) const
+		{
+			return m_pArray ? m_pArray->size() : 0;
+		}
+
+		bool empty(void) const
+		{
+			return size() == 0;
+		}
+
+		const AnimationPattern& operator[] (size_t index) const
+		{
+			return (*m_pArray)[index];
+		}
+
+		//中身を手放して空にする。共有していた相手には影響しない。
+		void clear(void)
+		{
+			m_pArray.reset();
+			m_Revision = 0;
+		}
+
+		//書き換え用の配列を返す。他と共有していれば先に複製する。
+		//中身が変わるものとして通し番号を振り直すので、計算済みの切り出し矩形(AnimationFrameTable)も作り直される。
+		std::vector<AnimationPattern>& Edit(void)
+		{
+			m_Revision = NextRevision();
+
+			if (!m_pArray)
+			{
+				m_pArray = std::make_shared<std::vector<AnimationPattern>>();
+			}
+			else if (m_pArray.use_count() > 1)
+			{
+				m_pArray = std::make_shared<std::vector<AnimationPattern>>(*m_pArray);
+			}
+			return *m_pArray;
+		}
+
+		//共有している中身そのもの。(GUIManager::InternPatternArray)
+		const std::shared_ptr<std::vector<AnimationPattern>>& Shared(void) const
+		{
+			return m_pArray;
+		}
+
+		//同じ通し番号なら中身も同じ。
+		uint64_t Revision(void) const
+		{
+			return m_Revision;
+		}
+	};
+
+	using AnimationFrameRect = BasicFrameRect<double>;
+
+	//パターンごとの切り出し矩形とUVを計算済みにした表。
+	//矩形、パターン、画像の大きさのどれかが変わった時だけ作り直す。表はコピーしたアニメーション同士で共有する。
+	//作り直す条件も表と一緒に持ち、アニメーション1つにつきポインタ1つ分で済むようにする。
+	class AnimationFrameTable
+	{
+	private:
+		struct Baked
+		{
+			double                       offsetX        = 0.0;
+			double                       offsetY        = 0.0;
+			double                       width          = 0.0;
+			double                       height         = 0.0;
+			double                       textureWidth   = 0.0;
+			double                       textureHeight  = 0.0;
+			uint64_t                     revision       = 0;
+			std::vector<AnimationFrameRect> rects;
+		};
+
+		std::shared_ptr<const Baked> m_pBaked;
+	public:
+		const std::vector<AnimationFrameRect>& Get(double offsetX, double offsetY, double width, double height, const AnimationPatternArray& pattern, double textureWidth, double textureHeight)
+		{
+			if (m_pBaked                                   &&
+				m_pBaked->revision      == pattern.Revision() &&
+				m_pBaked->offsetX       == offsetX       &&
+				m_pBaked->offsetY       == offsetY       &&
+				m_pBaked->width         == width         &&
+				m_pBaked->height        == height        &&
+				m_pBaked->textureWidth  == textureWidth  &&
+				m_pBaked->textureHeight == textureHeight)
+			{
+				return m_pBaked->rects;
+			}
+
+			auto pBaked = std::make_shared<Baked>();
+			pBaked->offsetX       = offsetX;
+			pBaked->offsetY       = offsetY;
+			pBaked->width         = width;
+			pBaked->height        = height;
+			pBaked->textureWidth  = textureWidth;
+			pBaked->textureHeight = textureHeight;
+			pBaked->revision      = pattern.Revision();
+			pBaked->rects.reserve(pattern.size());
+			for (size_t i = 0; i < pattern.size(); ++i)
+			{
+				pBaked->rects.push_back(BakeFrameRect(offsetX, offsetY, width, height, pattern[i].no, pattern[i].step, textureWidth, textureHeight));
+			}
+
+			m_pBaked = std::move(pBaked);
+			return m_pBaked->rects;
+		}
+	};
+
+	struct AnimationInfo
+	{
+		double                       offsetX = 0.0;
+		double                       offsetY = 0.0;
+		double                       width   = 0.0;
+		double                       height  = 0.0;
+		bool                         bLoop   = false;
+		AnimationPatternArray        pattern = AnimationPatternArray::Default();
+		mutable AnimationFrameTable  frameTable;
+
+		//パターンごとの切り出し矩形。描画のたびに呼んでよい。
+		const std::vector<AnimationFrameRect>& FrameRects(double textureWidth, double textureHeight) const
+		{
+			return frameTable.Get(offsetX, offsetY, width, height, pattern, textureWidth, textureHeight);
+		}
+	};
+}
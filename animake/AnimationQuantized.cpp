@@ -0,0 +1,200 @@
+﻿#include "AnimationQuantized.hpp"
+#include <cstring>
+
+namespace siapp
+{
+	namespace
+	{
+		//-0や非数も区別できるように、doubleはビット列で比べる。
+		bool SameBits(double a, double b)
+		{
+			uint64_t bitsA;
+			uint64_t bitsB;
+			std::memcpy(&bitsA, &a, sizeof(bitsA));
+			std::memcpy(&bitsB, &b, sizeof(bitsB));
+			return bitsA == bitsB;
+		}
+
+		//0～65535の整数で、戻した値が元と同じものだけ詰める。
+		bool QuantizeValue(double value, uint16_t& outValue)
+		{
+			if (!(value >= 0.0 && value <= static_cast<double>(UINT16_MAX)))
+			{
+				return false;
+			}
+
+			uint16_t quantized = static_cast<uint16_t>(value);
+			if (!SameBits(static_cast<double>(quantized), value))
+			{
+				return false;
+			}
+
+			outValue = quantized;
+			return true;
+		}
+
+		bool QuantizeValue(int value, uint16_t& outValue)
+		{
+			if (value < 0 || value > UINT16_MAX)
+			{
+				return false;
+			}
+
+			outValue = static_cast<uint16_t>(value);
+			return true;
+		}
+	}
+
+	bool QuantizePattern(const AnimationPattern& pattern, QuantizedPattern& outPattern)
+	{
+		QuantizedPattern quantized;
+
+		//waitScaleは2のべき乗なので、掛けても割っても丸めは起きない。戻した値を比べて確かめる。
+		if (!QuantizeValue(pattern.wait * QuantizedPattern::waitScale, quantized.wait) ||
+			!QuantizeValue(pattern.no, quantized.no) ||
+			!QuantizeValue(pattern.step, quantized.step) ||
+			!SameBits(DequantizePattern(quantized).wait, pattern.wait))
+		{
+			return false;
+		}
+
+		outPattern = quantized;
+		return true;
+	}
+
+	bool QuantizeRect(const AnimationInfo& info, QuantizedRect& outRect)
+	{
+		QuantizedRect quantized;
+		if (!QuantizeValue(info.offsetX, quantized.offsetX) ||
+			!QuantizeValue(info.offsetY, quantized.offsetY) ||
+			!QuantizeValue(info.width, quantized.width) ||
+			!QuantizeValue(info.height, quantized.height))
+		{
+			return false;
+		}
+
+		outRect = quantized;
+		return true;
+	}
+
+	void QuantizedAnimationSet::Clear(void)
+	{
+		m_Rects.clear();
+		m_Flags.clear();
+		m_PatternOffset.clear();
+		m_PatternCount.clear();
+		m_Patterns.clear();
+		m_Fallback.clear();
+	}
+
+	void QuantizedAnimationSet::Reserve(size_t animCount, size_t patternCount)
+	{
+		m_Rects.reserve(animCount);
+		m_Flags.reserve(animCount);
+		m_PatternOffset.reserve(animCount);
+		m_PatternCount.reserve(animCount);
+		m_Patterns.reserve(patternCount);
+	}
+
+	bool QuantizedAnimationSet::Append(const AnimationInfo& info)
+	{
+		uint8_t flags = info.bLoop ? flagLoop : 0;
+		size_t  patternCount = info.pattern.size();
+
+		//矩形とパターンが全て詰められる時だけ詰める。1つでも戻せなければ、途中まで詰めたパターンは取り消す。
+		QuantizedRect rect;
+		bool bQuantized = QuantizeRect(info, rect);
+
+		size_t patternBegin = m_Patterns.size();
+		if (bQuantized)
+		{
+			m_Patterns.resize(patternBegin + patternCount);
+			for (size_t j = 0; j < patternCount; ++j)
+			{
+				if (!QuantizePattern(info.pattern[j], m_Patterns[patternBegin + j]))
+				{
+					m_Patterns.resize(patternBegin);
+					bQuantized = false;
+					break;
+				}
+			}
+		}
+
+		if (bQuantized)
+		{
+			m_Rects.push_back(rect);
+			m_PatternOffset.push_back(static_cast<uint32_t>(patternBegin));
+		}
+		else
+		{
+			flags |= flagFallback;
+			m_Rects.push_back(QuantizedRect());
+			m_PatternOffset.push_back(static_cast<uint32_t>(m_Fallback.size()));
+			m_Fallback.push_back(info);
+		}
+
+		m_Flags.push_back(flags);
+		m_PatternCount.push_back(static_cast<uint32_t>(patternCount));
+		return bQuantized;
+	}
+
+	void QuantizedAnimationSet::Assign(const AnimationInfo* pInfos, size_t count)
+	{
+		Clear();
+
+		size_t patternCount = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			patternCount += pInfos[i].pattern.size();
+		}
+
+		Reserve(count, patternCount);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Append(pInfos[i]);
+		}
+	}
+
+	AnimationInfo QuantizedAnimationSet::Get(size_t index) const
+	{
+		if (!IsQuantized(index))
+		{
+			return FallbackInfo(index);
+		}
+
+		const QuantizedRect& rect = m_Rects[index];
+
+		AnimationInfo info;
+		info.offsetX = rect.offsetX;
+		info.offsetY = rect.offsetY;
+		info.width   = rect.width;
+		info.height  = rect.height;
+		info.bLoop   = Loop(index);
+
+		auto pArray = std::make_shared<std::vector<AnimationPattern>>();
+		pArray->reserve(m_PatternCount[index]);
+		for (size_t j = 0; j < m_PatternCount[index]; ++j)
+		{
+			pArray->push_back(DequantizePattern(m_Patterns[m_PatternOffset[index] + j]));
+		}
+		info.pattern = AnimationPatternArray(std::move(pArray));
+		return info;
+	}
+
+	size_t QuantizedAnimationSet::MemorySize(void) const
+	{
+		size_t size = sizeof(*this);
+		size += m_Rects.capacity() * sizeof(QuantizedRect);
+		size += m_Flags.capacity() * sizeof(uint8_t);
+		size += m_PatternOffset.capacity() * sizeof(uint32_t);
+		size += m_PatternCount.capacity() * sizeof(uint32_t);
+		size += m_Patterns.capacity() * sizeof(QuantizedPattern);
+		size += m_Fallback.capacity() * sizeof(AnimationInfo);
+		for (const AnimationInfo& info : m_Fallback)
+		{
+			size += info.pattern.size() * sizeof(AnimationPattern);
+		}
+		return size;
+	}
+}
@@ -0,0 +1,94 @@
+﻿#pragma once
+#include "AnimationModel.hpp"
+#include <cstdint>
+#include <vector>
+
+//たくさんのアニメーションを読むだけで持っておくための詰めた形。Siv3Dには依存しない。
+//エディタのAnimationInfo(矩形はdouble4つ、パターンは隙間込みで16バイト)を、矩形はuint16が4つ、パターンは6バイトに詰める。
+//waitは1/32フレーム単位の固定小数点にする。詰めて戻した値が元のdoubleとビット列まで同じ時だけ詰め、
+//戻せないアニメーション(0.1刻みで足したwaitや小数の矩形、範囲外の値など)はAnimationInfoのまま持つ。
+//どちらで持っていても、読み出す値は元のAnimationInfoと全く同じになる。
+
+namespace siapp
+{
+	struct QuantizedPattern
+	{
+		static constexpr double      waitScale = 32.0;   //waitの1単位は1/waitScaleフレーム
+
+		uint16_t                     wait    = 0;
+		uint16_t                     no      = 0;
+		uint16_t                     step    = 0;
+	};
+
+	struct QuantizedRect
+	{
+		uint16_t                     offsetX = 0;
+		uint16_t                     offsetY = 0;
+		uint16_t                     width   = 0;
+		uint16_t                     height  = 0;
+	};
+
+	//元の値に戻せる時だけoutPatternに詰めてtrueを返す。
+	bool QuantizePattern(const AnimationPattern& pattern, QuantizedPattern& outPattern);
+
+	inline AnimationPattern DequantizePattern(const QuantizedPattern& pattern)
+	{
+		return AnimationPattern{ pattern.wait / QuantizedPattern::waitScale, pattern.no, pattern.step };
+	}
+
+	//矩形の4つの値が全て0～65535の整数の時だけoutRectに詰めてtrueを返す。
+	bool QuantizeRect(const AnimationInfo& info, QuantizedRect& outRect);
+
+	class QuantizedAnimationSet
+	{
+	private:
+		static constexpr uint8_t     flagLoop     = 0x01;
+		static constexpr uint8_t     flagFallback = 0x02;    //詰められなかったのでm_Fallbackに持っている
+
+		std::vector<QuantizedRect>   m_Rects;            //m_Fallbackに持っているものは使わない
+		std::vector<uint8_t>         m_Flags;
+		std::vector<uint32_t>        m_PatternOffset;    //m_Patterns内の先頭番号。m_Fallbackに持っているものはm_Fallback内の番号
+		std::vector<uint32_t>        m_PatternCount;
+		std::vector<QuantizedPattern> m_Patterns;
+		std::vector<AnimationInfo>   m_Fallback;
+
+		const AnimationInfo& FallbackInfo(size_t index) const
+		{
+			return m_Fallback[m_PatternOffset[index]];
+		}
+	public:
+		void Clear(void);
+		void Reserve(size_t animCount, size_t patternCount);
+
+		//後ろに足す。詰められた時はtrue、AnimationInfoのまま持った時はfalseを返す。
+		bool Append(const AnimationInfo& info);
+		void Assign(const AnimationInfo* pInfos, size_t count);
+
+		size_t AnimCount(void) const { return m_Flags.size(); }
+		size_t QuantizedCount(void) const { return m_Flags.size() - m_Fallback.size(); }
+		bool IsQuantized(size_t index) const { return (m_Flags[index] & flagFallback) == 0; }
+
+		double OffsetX(size_t index) const { return IsQuantized(index) ? m_Rects[index].offsetX : FallbackInfo(index).offsetX; }
+		double OffsetY(size_t index) const { return IsQuantized(index) ? m_Rects[index].offsetY : FallbackInfo(index).offsetY; }
+		double Width(size_t index) const { return IsQuantized(index) ? m_Rects[index].width : FallbackInfo(index).width; }
+		double Height(size_t index) const { return IsQuantized(index) ? m_Rects[index].height : FallbackInfo(index).height; }
+		bool Loop(size_t index) const { return (m_Flags[index] & flagLoop) != 0; }
+
+		size_t PatternCount(size_t index) const { return m_PatternCount[index]; }
+
+		AnimationPattern Pattern(size_t index, size_t patternNo) const
+		{
+			if (IsQuantized(index))
+			{
+				return DequantizePattern(m_Patterns[m_PatternOffset[index] + patternNo]);
+			}
+			return FallbackInfo(index).pattern[patternNo];
+		}
+
+		//エディタで使う形に戻す。詰めたものはパターン配列を新しく作る。
+		AnimationInfo Get(size_t index) const;
+
+		//持っているメモリのおおよその大きさ(バイト)。AnimationInfoのまま持っているもののパターン配列も含める。
+		size_t MemorySize(void) const;
+	};
+}
@@ -0,0 +1,288 @@
+﻿#include "AtomicFile.hpp"
+
+#ifdef _WIN32
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <Windows.h>
+#else
+#	include <cerrno>
+#	include <cstdio>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+#include <atomic>
+#include <string>
+
+namespace siapp
+{
+	namespace
+	{
+#ifdef _WIN32
+		bool WriteTempFile(const std::filesystem::path& tempPath, const void* data, size_t size)
+		{
+			HANDLE hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (hFile == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			//WriteFileは一度に4GB未満しか書けないが.animはそこまで大きくならない。
+			DWORD written = 0;
+			bool  bResult = size <= MAXDWORD &&
+				WriteFile(hFile, data, static_cast<DWORD>(size), &written, nullptr) &&
+				written == size &&
+				FlushFileBuffers(hFile);
+
+			CloseHandle(hFile);
+			return bResult;
+		}
+
+		intptr_t CreateTempFile(const std::filesystem::path& tempPath)
+		{
+			HANDLE hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			return hFile == INVALID_HANDLE_VALUE ? -1 : reinterpret_cast<intptr_t>(hFile);
+		}
+
+		bool WriteTempData(intptr_t handle, const void* data, size_t size)
+		{
+			//呼び出し側で一定サイズごとに分けて書くので4GBを超えることはない。
+			DWORD written = 0;
+			return size <= MAXDWORD &&
+				WriteFile(reinterpret_cast<HANDLE>(handle), data, static_cast<DWORD>(size), &written, nullptr) &&
+				written == size;
+		}
+
+		bool CloseTempFile(intptr_t handle, bool bFlush)
+		{
+			HANDLE hFile = reinterpret_cast<HANDLE>(handle);
+			bool bResult = !bFlush || FlushFileBuffers(hFile);
+			return ::CloseHandle(hFile) && bResult;
+		}
+
+		bool MoveIntoPlace(const std::filesystem::path& tempPath, const std::filesystem::path& path)
+		{
+			return MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+		}
+
+		void RemoveFile(const std::filesystem::path& tempPath)
+		{
+			DeleteFileW(tempPath.c_str());
+		}
+
+		bool AppendFile(const std::filesystem::path& path, const void* data, size_t size)
+		{
+			HANDLE hFile = CreateFileW(path.c_str(), FILE_APPEND_DATA, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (hFile == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			DWORD written = 0;
+			bool  bResult = size <= MAXDWORD &&
+				WriteFile(hFile, data, static_cast<DWORD>(size), &written, nullptr) &&
+				written == size &&
+				FlushFileBuffers(hFile);
+
+			CloseHandle(hFile);
+			return bResult;
+		}
+#else
+		bool WriteAll(int fd, const void* data, size_t size)
+		{
+			//通常は一度で書き終わる。シグナルなどで途中までしか書けなかった場合だけ続きを書く。
+			const char* p = static_cast<const char*>(data);
+			size_t remain = size;
+			while (remain > 0)
+			{
+				ssize_t written = write(fd, p, remain);
+				if (written < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+					break;
+				}
+				p      += written;
+				remain -= static_cast<size_t>(written);
+			}
+			return remain == 0;
+		}
+
+		bool WriteTempFile(const std::filesystem::path& tempPath, const void* data, size_t size)
+		{
+			int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			bool bResult = WriteAll(fd, data, size) && fsync(fd) == 0;
+			return close(fd) == 0 && bResult;
+		}
+
+		intptr_t CreateTempFile(const std::filesystem::path& tempPath)
+		{
+			return open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		}
+
+		bool WriteTempData(intptr_t handle, const void* data, size_t size)
+		{
+			return WriteAll(static_cast<int>(handle), data, size);
+		}
+
+		bool CloseTempFile(intptr_t handle, bool bFlush)
+		{
+			int fd = static_cast<int>(handle);
+			bool bResult = !bFlush || fsync(fd) == 0;
+			return close(fd) == 0 && bResult;
+		}
+
+		bool MoveIntoPlace(const std::filesystem::path& tempPath, const std::filesystem::path& path)
+		{
+			if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+			{
+				return false;
+			}
+
+			//名前の変更もディスクに反映させるためフォルダをfsyncする。
+			std::filesystem::path dir = path.parent_path();
+			int dirFd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_CLOEXEC);
+			if (dirFd >= 0)
+			{
+				fsync(dirFd);
+				close(dirFd);
+			}
+			return true;
+		}
+
+		void RemoveFile(const std::filesystem::path& tempPath)
+		{
+			unlink(tempPath.c_str());
+		}
+
+		bool AppendFile(const std::filesystem::path& path, const void* data, size_t size)
+		{
+			int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			bool bResult = WriteAll(fd, data, size) && fsync(fd) == 0;
+			return close(fd) == 0 && bResult;
+		}
+#endif
+	}
+
+	AtomicFileStream::AtomicFileStream(void) :
+		m_Path(),
+		m_TempPath(),
+		m_Handle(-1),
+		m_bOpen(false),
+		m_bFailed(false)
+	{
+	}
+
+	AtomicFileStream::~AtomicFileStream(void)
+	{
+		Abort();
+	}
+
+	bool AtomicFileStream::Open(const std::filesystem::path& path)
+	{
+		Abort();
+
+		std::filesystem::path tempPath = AtomicFile::TempPath(path);
+		m_Handle = CreateTempFile(tempPath);
+		if (m_Handle == -1)
+		{
+			return false;
+		}
+
+		m_Path     = path;
+		m_TempPath = std::move(tempPath);
+		m_bOpen   = true;
+		m_bFailed = false;
+		return true;
+	}
+
+	bool AtomicFileStream::Write(const void* data, size_t size)
+	{
+		if (!m_bOpen || m_bFailed)
+		{
+			return false;
+		}
+
+		m_bFailed = !WriteTempData(m_Handle, data, size);
+		return !m_bFailed;
+	}
+
+	bool AtomicFileStream::Commit(void)
+	{
+		if (!m_bOpen)
+		{
+			return false;
+		}
+
+		m_bOpen = false;
+
+		if (!CloseTempFile(m_Handle, true) || m_bFailed || !MoveIntoPlace(m_TempPath, m_Path))
+		{
+			RemoveFile(m_TempPath);
+			return false;
+		}
+		return true;
+	}
+
+	void AtomicFileStream::Abort(void)
+	{
+		if (!m_bOpen)
+		{
+			return;
+		}
+
+		m_bOpen = false;
+		CloseTempFile(m_Handle, false);
+		RemoveFile(m_TempPath);
+	}
+
+	namespace AtomicFile
+	{
+		bool Write(const std::filesystem::path& path, const void* data, size_t size)
+		{
+			std::filesystem::path tempPath = TempPath(path);
+
+			if (!WriteTempFile(tempPath, data, size) || !MoveIntoPlace(tempPath, path))
+			{
+				RemoveFile(tempPath);
+				return false;
+			}
+			return true;
+		}
+
+		bool Append(const std::filesystem::path& path, const void* data, size_t size)
+		{
+			return AppendFile(path, data, size);
+		}
+
+		std::filesystem::path TempPath(const std::filesystem::path& path)
+		{
+			//名前の変更で置き換えられるように、一時ファイルは元のファイルと同じフォルダに作る。
+			static std::atomic<uint64_t> counter(0);
+#ifdef _WIN32
+			uint64_t processId = GetCurrentProcessId();
+#else
+			uint64_t processId = static_cast<uint64_t>(getpid());
+#endif
+			std::filesystem::path tempPath = path;
+			tempPath += "." + std::to_string(processId) + "." + std::to_string(++counter) + ".tmp";
+			return tempPath;
+		}
+	}
+}
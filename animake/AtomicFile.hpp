@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+//ファイルを途中まで書かれた状態で残さないための書き込み。Siv3Dには依存しない。
+
+namespace siapp
+{
+	//一度に書き切れない大きなファイルを少しずつ書き出す。AtomicFile::Writeと同じく一時ファイルに書き、Commitで置き換える。
+	//Commitせずに破棄した場合は一時ファイルを消して、元のファイルはそのまま残す。
+	class AtomicFileStream
+	{
+	private:
+		std::filesystem::path        m_Path;
+		std::filesystem::path        m_TempPath;
+		intptr_t                     m_Handle;           //WindowsならHANDLE、それ以外はファイルディスクリプタ
+		bool                         m_bOpen;
+		bool                         m_bFailed;
+	public:
+		AtomicFileStream(void);
+		~AtomicFileStream(void);
+		AtomicFileStream(const AtomicFileStream&) = delete;
+		AtomicFileStream& operator= (const AtomicFileStream&) = delete;
+
+		bool Open(const std::filesystem::path& path);
+
+		//一度でも失敗したら以降の書き込みは無視し、Commitでfalseを返す。
+		bool Write(const void* data, size_t size);
+
+		//ディスクに反映してから元のファイルと置き換える。
+		bool Commit(void);
+
+		//一時ファイルを消して書き込みをやめる。
+		void Abort(void);
+	};
+
+	namespace AtomicFile
+	{
+		//同じフォルダの一時ファイルに一度の書き込みで書き出し、ディスクに反映してから元のファイルと置き換える。
+		//書き込み中に落ちても元のファイルはそのまま残る。失敗した場合は一時ファイルを消してfalseを返す。
+		bool Write(const std::filesystem::path& path, const void* data, size_t size);
+
+		//ファイルの末尾に一度の書き込みで追加し、ディスクに反映する。ファイルがなければ作る。
+		//途中で落ちると末尾が途切れるので、読む側で途切れたデータを捨てられる形式にしておくこと。
+		bool Append(const std::filesystem::path& path, const void* data, size_t size);
+
+		//一時ファイルのパス。(path + ".プロセスID.通し番号.tmp")
+		//同じファイルに同時に書き込むスレッドやプロセスがあっても、一時ファイルは互いに別のものになる。呼ぶたびに違う名前を返す。
+		std::filesystem::path TempPath(const std::filesystem::path& path);
+	}
+}
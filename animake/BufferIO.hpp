@@ -0,0 +1,197 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//コーデック内部で使うバッファの読み書き。Siv3Dには依存しない。
+
+namespace siapp
+{
+	//バッファから順番に値を取り出す。範囲外を読もうとした時点で失敗扱いにする。
+	class BufferReader
+	{
+	private:
+		const uint8_t*               m_pData;
+		size_t                       m_Size;
+		size_t                       m_Pos;
+	public:
+		BufferReader(const uint8_t* data, size_t size, size_t pos = 0) :
+			m_pData(data),
+			m_Size(size),
+			m_Pos(pos <= size ? pos : size)
+		{
+		}
+
+		size_t Pos(void) const
+		{
+			return m_Pos;
+		}
+
+		size_t Remain(void) const
+		{
+			return m_Size - m_Pos;
+		}
+
+		const uint8_t* Current(void) const
+		{
+			return m_pData + m_Pos;
+		}
+
+		template<class T>
+		bool Read(T& out)
+		{
+			if (Remain() < sizeof(T))
+			{
+				return false;
+			}
+			std::memcpy(&out, m_pData + m_Pos, sizeof(T));
+			m_Pos += sizeof(T);
+			return true;
+		}
+
+		bool Skip(size_t size)
+		{
+			if (Remain() < size)
+			{
+				return false;
+			}
+			m_Pos += size;
+			return true;
+		}
+
+		//長さ(int)付きの文字列を読む。一時バッファを介さずに直接代入する。
+		bool ReadString(std::string& out)
+		{
+			int32_t length;
+			if (!Read(length) || length < 0 || Remain() < static_cast<size_t>(length))
+			{
+				return false;
+			}
+			out.assign(reinterpret_cast<const char*>(m_pData + m_Pos), static_cast<size_t>(length));
+			m_Pos += static_cast<size_t>(length);
+			return true;
+		}
+
+		//長さ(int)付きの文字列をコピーせずに参照する。バッファを手放すまで有効。
+		bool ReadStringView(std::string_view& out)
+		{
+			int32_t length;
+			if (!Read(length) || length < 0 || Remain() < static_cast<size_t>(length))
+			{
+				return false;
+			}
+			out = std::string_view(reinterpret_cast<const char*>(m_pData + m_Pos), static_cast<size_t>(length));
+			m_Pos += static_cast<size_t>(length);
+			return true;
+		}
+
+		//LEB128の可変長整数を読む。下位7bitずつ、続きがあれば最上位bitを立てて並べたもの。
+		bool ReadVarint(uint64_t& out)
+		{
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				if (m_Pos >= m_Size)
+				{
+					return false;
+				}
+
+				uint8_t byte = m_pData[m_Pos++];
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					out = value;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//長さ(可変長整数)付きの文字列を読む。
+		bool ReadVarintString(std::string& out)
+		{
+			uint64_t length;
+			if (!ReadVarint(length) || Remain() < length)
+			{
+				return false;
+			}
+			out.assign(reinterpret_cast<const char*>(m_pData + m_Pos), static_cast<size_t>(length));
+			m_Pos += static_cast<size_t>(length);
+			return true;
+		}
+
+		//長さ(可変長整数)付きの文字列をコピーせずに参照する。バッファを手放すまで有効。
+		bool ReadVarintStringView(std::string_view& out)
+		{
+			uint64_t length;
+			if (!ReadVarint(length) || Remain() < length)
+			{
+				return false;
+			}
+			out = std::string_view(reinterpret_cast<const char*>(m_pData + m_Pos), static_cast<size_t>(length));
+			m_Pos += static_cast<size_t>(length);
+			return true;
+		}
+	};
+
+	//バッファの後ろに値を書き足す。領域は呼び出し側で確保済みの前提。
+	class BufferWriter
+	{
+	private:
+		std::vector<uint8_t>*        m_pBuffer;
+	public:
+		explicit BufferWriter(std::vector<uint8_t>& buffer) :
+			m_pBuffer(&buffer)
+		{
+		}
+
+		void Write(const void* data, size_t size)
+		{
+			const uint8_t* p = static_cast<const uint8_t*>(data);
+			m_pBuffer->insert(m_pBuffer->end(), p, p + size);
+		}
+
+		template<class T>
+		void Write(const T& value)
+		{
+			Write(&value, sizeof(T));
+		}
+
+		void WriteString(const std::string& str)
+		{
+			int32_t length = static_cast<int32_t>(str.size());
+			Write(length);
+			Write(str.data(), str.size());
+		}
+
+		void WriteVarint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				m_pBuffer->push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			m_pBuffer->push_back(static_cast<uint8_t>(value));
+		}
+
+		void WriteVarintString(const std::string& str)
+		{
+			WriteVarint(str.size());
+			Write(str.data(), str.size());
+		}
+	};
+
+	//符号付きの差分を、絶対値の小さいものほど短い可変長整数になるように並べ替える。(0, -1, 1, -2, ... → 0, 1, 2, 3, ...)
+	inline uint64_t ZigZagEncode(int64_t value)
+	{
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	inline int64_t ZigZagDecode(uint64_t value)
+	{
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+}
@@ -1,4 +1,4 @@
-#pragma once
+﻿#pragma once
 constexpr  double      appVersion            = 1.22;
 
 typedef    int         BOOL;
@@ -24,3 +24,8 @@ constexpr  int         animListWindowHeight  = animDataWindowHeight;
 
 constexpr  int         animViewWindowWidth   = windowWidth - (animDataWindowWidth + animListWindowWidth);
 constexpr  int         animViewWindowHeight  = animDataWindowHeight;
+
+constexpr  double      autoSaveInterval      = 60.0;
+constexpr  int         journalCompactSize    = 64 * 1024;
+constexpr  int         textureCacheBudgetMB  = 512;
+constexpr  double      hotReloadDelay        = 0.3;
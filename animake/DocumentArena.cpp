@@ -0,0 +1,92 @@
+﻿#include "DocumentArena.hpp"
+#include <algorithm>
+
+namespace siapp
+{
+	DocumentArena::DocumentArena(size_t blockSize) :
+		m_Blocks(),
+		m_BlockSize(blockSize),
+		m_Used(0),
+		m_TotalUsed(0)
+	{
+	}
+
+	void DocumentArena::AddBlock(size_t size)
+	{
+		Block block;
+		block.pData.reset(new uint8_t[size]);
+		block.size = size;
+		m_Blocks.push_back(std::move(block));
+		m_Used = 0;
+	}
+
+	void* DocumentArena::Allocate(size_t size, size_t align)
+	{
+		if (!m_Blocks.empty())
+		{
+			const Block& block = m_Blocks.back();
+			uintptr_t current  = reinterpret_cast<uintptr_t>(block.pData.get()) + m_Used;
+			size_t padding     = static_cast<size_t>((align - current % align) % align);
+
+			if (padding + size <= block.size - m_Used)
+			{
+				m_Used      += padding + size;
+				m_TotalUsed += size;
+				return reinterpret_cast<void*>(current + padding);
+			}
+		}
+
+		//newで確保した先頭はmax_align_tに揃っているので、新しいブロックなら先頭から切り出せる。
+		AddBlock(std::max(m_BlockSize, size));
+		m_Used       = size;
+		m_TotalUsed += size;
+		return m_Blocks.back().pData.get();
+	}
+
+	void DocumentArena::Reserve(size_t size)
+	{
+		if (!m_Blocks.empty() && m_Blocks.back().size - m_Used >= size)
+		{
+			return;
+		}
+
+		//アラインメントで詰め物が入っても収まるように少し余分に取る。
+		AddBlock(std::max(m_BlockSize, size + alignof(std::max_align_t)));
+	}
+
+	void DocumentArena::Reset(void)
+	{
+		if (m_Blocks.empty())
+		{
+			return;
+		}
+
+		auto it = std::max_element(m_Blocks.begin(), m_Blocks.end(), [](const Block& a, const Block& b) { return a.size < b.size; });
+		Block largest = std::move(*it);
+
+		m_Blocks.clear();
+		m_Blocks.push_back(std::move(largest));
+		m_Used      = 0;
+		m_TotalUsed = 0;
+	}
+
+	size_t DocumentArena::UsedSize(void) const
+	{
+		return m_TotalUsed;
+	}
+
+	size_t DocumentArena::Capacity(void) const
+	{
+		size_t capacity = 0;
+		for (const Block& block : m_Blocks)
+		{
+			capacity += block.size;
+		}
+		return capacity;
+	}
+
+	size_t DocumentArena::BlockCount(void) const
+	{
+		return m_Blocks.size();
+	}
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+//ファイル1つ分のデータを詰めていく領域。Siv3Dには依存しない。
+//確保は前から順に切り出すだけで、個別には解放しない。次のファイルを開く時にResetでまとめて手放す。
+//デストラクタを呼ばないので、置けるのは後始末の要らない型だけ。
+
+namespace siapp
+{
+	class DocumentArena
+	{
+	private:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> pData;
+			size_t                     size;
+		};
+
+		std::vector<Block>           m_Blocks;           //最後のものから切り出す
+		size_t                       m_BlockSize;
+		size_t                       m_Used;             //最後のブロックで使った大きさ
+		size_t                       m_TotalUsed;
+
+		void AddBlock(size_t size);
+	public:
+		static constexpr size_t      defaultBlockSize = 64 * 1024;
+
+		explicit DocumentArena(size_t blockSize = defaultBlockSize);
+		DocumentArena(const DocumentArena&) = delete;
+		DocumentArena& operator= (const DocumentArena&) = delete;
+
+		//alignはmax_align_t以下の2のべき乗。今のブロックに収まらなければ新しいブロックを足す。
+		void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+		//count個を値初期化して返す。
+		template<class T>
+		T* AllocateArray(size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "DocumentArena does not call destructors");
+
+			T* pArray = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+			for (size_t i = 0; i < count; ++i)
+			{
+				new (pArray + i) T();
+			}
+			return pArray;
+		}
+
+		//この後sizeまでは新しいブロックを足さずに確保できるようにする。大きさが分かっている時に先に呼んでおく。
+		void Reserve(size_t size);
+
+		//確保したものを全て手放す。一番大きいブロックだけは次のファイルのために残す。
+		void Reset(void);
+
+		//切り出した大きさの合計と、持っているブロックの大きさの合計。
+		size_t UsedSize(void) const;
+		size_t Capacity(void) const;
+		size_t BlockCount(void) const;
+	};
+}
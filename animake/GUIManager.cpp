@@ -7,7 +7,7 @@ namespace siapp
 		m_pGui(nullptr),
 		m_SelectListNo(0),
 		m_AnimationArray(),
-		m_AnimNameArray(),
+		m_AnimNameIndex(),
 		m_AnimationName(U""),
 		m_SelectPattern(0),
 		m_AllFrame(1.0),
@@ -17,6 +17,10 @@ namespace siapp
 		m_TextFilePath(),
 		m_bDeleteAssert(false),
 		m_Texture(),
+		m_PlaceholderTexture(),
+		m_TextureStamp(),
+		m_bTextureMipped(false),
+		m_bMipRequested(false),
 		m_TexScale(1.0),
 		m_AnimScale(1.0),
 		m_EditScale(1.0),
@@ -31,27 +35,82 @@ namespace siapp
 		m_AnimationOffset(0.0, 0.0),
 		m_EditOffset(0.0, 0.0),
 		m_bGrid(false),
-		m_GridScale(16)
+		m_GridScale(16),
+		m_bSaveFlat(false),
+		m_bSaveCompact(false),
+		m_bSaveCompressed(false),
+		m_bSaveHeader(false),
+		m_pAnimIndex(nullptr),
+		m_LazyIndexArray(),
+		m_PatternTable(),
+		m_AutoSave(),
+		m_bAutoSave(true),
+		m_bSnapshotDirty(false),
+		m_AutoSaveTime(0.0),
+		m_SnapshotArray(),
+		m_bSaveJournal(false),
+		m_JournalSize(0),
+		m_JournalBaseSize(0),
+		m_JournalCount(0),
+		m_JournalTexturePath(),
+		m_JournalRemoveArray(),
+		m_JournalArray(),
+		m_pLoadPool(nullptr),
+		m_TextureQueue(),
+		m_TextureRequest(0),
+		m_TextureCache(static_cast<size_t>(textureCacheBudgetMB) * 1024 * 1024),
+		m_TextureCacheBudgetMB(textureCacheBudgetMB),
+		m_LoadQueue(),
+		m_LoadBatch(0),
+		m_FileArray(),
+		m_LoadDoneCount(0),
+		m_SelectFileNo(none),
+		m_bFileListWindow(true),
+		m_bHotReload(true),
+		m_DirectoryWatchers(),
+		m_WatchAnim(),
+		m_WatchTexture(),
+		m_WatchText()
 	{
 		m_CurrentDir = FileSystem::CurrentDirectory();
 	}
 
 	GUIManager::~GUIManager(void)
 	{
+		//読み込み待ちのファイルや画像は飛ばさせてから、読み込み中のものが終わるのを待つ。
+		++m_LoadBatch;
+		++m_TextureRequest;
+		SAFE_DELETE(m_pLoadPool);
+
 		SAFE_DELETE(m_pGui);
+		m_pAnimIndex.reset();
 	}
 
 	void GUIManager::Initialize(void)
 	{
 		m_pGui = new SasaGUI::GUIManager();
 
+		//画像を読み込んでいる間に表示する市松模様。
+		Image placeholder(64, 64);
+		for (int y : step(placeholder.height()))
+		{
+			for (int x : step(placeholder.width()))
+			{
+				placeholder[y][x] = ((x / 8 + y / 8) % 2 == 0) ? Color(96) : Color(160);
+			}
+		}
+		m_PlaceholderTexture = Texture(placeholder);
+
 		//初期化時にデータを一つ追加しておく
-		m_AnimNameArray << U"NewAnimation1";
+		m_AnimNameIndex.Add(U"NewAnimation1");
 		m_AnimationArray << AnimationInfo();
+		m_LazyIndexArray << -1;
+		m_SnapshotArray << AnimationSnapshotCache();
+		m_JournalArray << AnimationSnapshotCache();
 		
 		m_SelectListNo = 0;
 		
-		m_AnimationName = m_AnimNameArray[m_SelectListNo];
+		m_AnimationName = m_AnimNameIndex.Name(m_SelectListNo);
 	}
 
 	void GUIManager::Update(void)
@@ -59,10 +118,25 @@ namespace siapp
 		//アニメーションの時間をフレームに依存なく進める
 		AnimationAddTimer(Scene::DeltaTime());
 
+		//別スレッドでデコードし終わった画像を受け取る。
+		UpdateLoadTexture();
+
+		//まとめて開いたファイルのうち、読み込み終わったものを受け取る。
+		UpdateLoadFiles();
+
+		//開いているファイルが外から書き換えられていれば読み込み直す。
+		UpdateHotReload();
+
 		m_pGui->frameBegin();
 		{
 			//アニメーション描画ウィンドウの制御
 			AnimationViewWindow();
+
+			//まとめて開いたファイルの一覧
+			if (m_bFileListWindow && !m_FileArray.isEmpty())
+			{
+				AnimationFileListWindow();
+			}
 			
 			//アニメーションデータグループの制御
 			if (m_bDeleteAssert)
@@ -80,6 +154,9 @@ namespace siapp
 			AnimationBtnWindow();
 		}
 		m_pGui->frameEnd();
+
+		//一定時間ごとに別スレッドで自動保存する。
+		AutoSave();
 	}
 
 	void GUIManager::AnimationAddTimer(const double& s)
@@ -89,7 +166,7 @@ namespace siapp
 		
 		//アニメ―ションデータの参照
 		AnimationInfo* pAnim = &(m_AnimationArray[m_SelectListNo]);
-		Array<AnimationPattern>* ptn = &(pAnim->pattern);
+		const AnimationPatternArray* ptn = &(pAnim->pattern);
 
 		//アニメーションパターンの待機フレームからフレームに依存しない時間を計算
 		double sec = (*ptn)[m_Pattern].wait * s;
@@ -114,16 +191,160 @@ namespace siapp
 		//アニメーションの状態を最初に戻す。
 		m_Pattern = 0;
 		m_MotionTime = 0.0;
-		m_SelectPattern = Clamp(m_SelectPattern, 0, static_cast<int>(m_AnimationArray[m_SelectListNo].pattern.size()));
+		m_SelectPattern = Clamp(m_SelectPattern, 0, Max(static_cast<int>(m_AnimationArray[m_SelectListNo].pattern.size()) - 1, 0));
+	}
+
+	ThreadPool* GUIManager::LoadPool(void)
+	{
+		if (m_pLoadPool == nullptr)
+		{
+			m_pLoadPool = new ThreadPool();
+		}
+		return m_pLoadPool;
+	}
+
+	void GUIManager::DecodeTexture(const FilePath& path, bool bMipped, Image& outImage, Array<Image>& outMips)
+	{
+		//PNGのデコードとミップマップの作成は重いので、ワーカースレッドから呼ぶ。
+		outImage = Image(path);
+		outMips  = (bMipped && outImage) ? ImageProcessing::GenerateMips(outImage) : Array<Image>();
+	}
+
+	CachedTexture GUIManager::CreateCachedTexture(const FileStamp& stamp, const Image& image, const Array<Image>& mips)
+	{
+		if (!image)
+		{
+			return CachedTexture();
+		}
+
+		//ミップマップがなければ元の大きさだけのテクスチャにする。GPUのメモリはミップマップの分(約1/3)少なくて済む。
+		CachedTexture cached;
+		cached.bMipped = !mips.isEmpty();
+		cached.texture = cached.bMipped ? Texture(image, mips, TextureDesc::Mipped) : Texture(image, TextureDesc::Unmipped);
+
+		//キャッシュの大きさはミップマップも含めたピクセルデータのバイト数で数える。
+		//同じ画像のミップマップを後から作った場合は、ミップマップなしのものと置き換わる。
+		size_t cost = image.size_bytes();
+		for (const Image& mip : mips)
+		{
+			cost += mip.size_bytes();
+		}
+		m_TextureCache.Insert(stamp, cached, cost);
+		return cached;
+	}
+
+	void GUIManager::SetTexture(const CachedTexture& texture, const FileStamp& stamp)
+	{
+		//読み込み中の画像やミップマップがあればその結果は捨てる。
+		++m_TextureRequest;
+
+		m_Texture        = texture.texture;
+		m_TextureStamp   = stamp;
+		m_bTextureMipped = texture.bMipped;
+		m_bMipRequested  = false;
 	}
 
 	void GUIManager::LoadTexture(const FilePath& path)
 	{
-		//受け取ったファイルパスをミニマップありで作成する。
-		m_Texture = Texture(path, TextureDesc::Mipped);
+		//同じ画像を書き換えられていないまま読み込み直すなら、キャッシュにあるテクスチャをそのまま使う。
+		FileStamp stamp = FileStamp::Make(path.toWstr());
+		CachedTexture cached;
+		if (m_TextureCache.Find(stamp, cached))
+		{
+			SetTexture(cached, stamp);
+		}
+		else
+		{
+			//デコードは別スレッドで行い、終わるまでは仮の画像を表示しておく。ミップマップは縮小表示するまで作らない。
+			//読み込み中に別の画像が選ばれたら、古い方の結果は捨てる。(UpdateLoadTexture)
+			m_Texture        = m_PlaceholderTexture;
+			m_TextureStamp   = stamp;
+			m_bTextureMipped = false;
+			m_bMipRequested  = false;
+			uint32 request = ++m_TextureRequest;
+
+			LoadPool()->Push([this, request, stamp, path]()
+			{
+				if (m_TextureRequest != request)
+				{
+					return;
+				}
+
+				TextureLoadResult result;
+				result.request = request;
+				result.stamp   = stamp;
+				DecodeTexture(path, false, result.image, result.mips);
+				m_TextureQueue.Push(std::move(result));
+			});
+		}
 		
 		//相対パスに変換して保存しておく。
 		m_TextureFilePath = FileSystem::RelativePath(path);
+
+		//画像ファイル名も自動保存の対象にする。
+		m_bSnapshotDirty = true;
+	}
+
+	void GUIManager::UpdateLoadTexture(void)
+	{
+		TextureLoadResult result;
+		while (m_TextureQueue.TryPop(result))
+		{
+			if (result.request != m_TextureRequest)
+			{
+				continue;
+			}
+
+			//GPUへの転送だけをメインスレッドで行う。読み込めなかった場合は空のテクスチャになる。
+			SetTexture(CreateCachedTexture(result.stamp, result.image, result.mips), result.stamp);
+		}
+	}
+
+	void GUIManager::RequestTextureMips(void)
+	{
+		if (m_bTextureMipped || m_bMipRequested || !m_Texture || IsTextureLoading())
+		{
+			return;
+		}
+
+		//ミップマップを作るには元の画像が要るので、別スレッドでデコードし直してから作る。
+		//出来上がるまではミップマップなしのまま縮小して表示する。
+		m_bMipRequested = true;
+		uint32    request = m_TextureRequest;
+		FileStamp stamp   = m_TextureStamp;
+
+		LoadPool()->Push([this, request, stamp]()
+		{
+			if (m_TextureRequest != request)
+			{
+				return;
+			}
+
+			TextureLoadResult result;
+			result.request = request;
+			result.stamp   = stamp;
+			DecodeTexture(Unicode::FromWString(stamp.path), true, result.image, result.mips);
+			m_TextureQueue.Push(std::move(result));
+		});
+	}
+
+	bool GUIManager::IsTextureLoading(void) const
+	{
+		return m_Texture.id() == m_PlaceholderTexture.id();
+	}
+
+	void GUIManager::LoadAnimTexture(const FilePath& animPath, const std::string& textureName)
+	{
+		//.animに書かれた画像はツールやパックと同じ場所を探す。(AnimCodec::ResolveTexturePath)
+		//見つからなければ書かれているパスのまま読み込もうとする。
+		std::filesystem::path texturePath = AnimCodec::ResolveTexturePath(animPath.toWstr(), textureName);
+		if (texturePath.empty())
+		{
+			LoadTexture(Unicode::Widen(textureName));
+			return;
+		}
+
+		LoadTexture(Unicode::FromWString(texturePath.wstring()));
 	}
 
 	double GUIManager::RectScale(const Vec2& rectSize, const Vec2& drawSize)
@@ -140,319 +361,1129 @@ namespace siapp
 		double sx = rectSize.x / drawSize.x;
 		double sy = rectSize.y / drawSize.y;
 
-		//小さいほうを入れることで、枠内に収まるようにする。
-		scale = Min(sx, sy);
+		//小さいほうを入れることで、枠内に収まるようにする。
+		scale = Min(sx, sy);
+
+		//1を超えても、引き延ばしてきたなくなるだけなのでクリップしておく。
+		scale = Clamp(scale, 0.1, 1.0);
+
+		return scale;
+	}
+
+	void GUIManager::LoadData(const FilePath& path)
+	{
+		//ファイルパスを相対パスに変換する。
+		FilePath animPath = FileSystem::RelativePath(path);
+
+		//ファイルの拡張子がテキストファイルか調べる。
+		bool isText = FileSystem::Extension(path) == U"txt";
+
+		//テキストファイルならデータの一行目からファイル名を取得し、「以下コピペ用」のブロックも読み込む。
+		//ブロックは手で書き換えられていることがあるので、.animより新しければ.txtの中身を使う。
+		if (isText)
+		{
+			FilePath txtPath = animPath;
+
+			AnimDocument doc;
+			std::string textAnimPath;
+			bool bParsed = AnimText::Load(txtPath.toWstr(), doc, textAnimPath) && !doc.animations.empty();
+			if (textAnimPath.empty())
+			{
+				return;
+			}
+			animPath = Unicode::Widen(textAnimPath);
+
+			if (bParsed && IsTextNewer(txtPath, animPath))
+			{
+				LoadTextDocument(txtPath, animPath, doc);
+				return;
+			}
+		}
+
+		//アニメーションファイルを開いて名前と位置の索引だけを作る。中身はリストで選ばれた時に読み込む。
+		//形式は先頭のマジックナンバーで判別する。従来の形式の読み込み順はAnimCodec::Encode関数を参照。
+		//開いている間も他のツールで書き換えたり置き換えたりできるように、ファイルはマップせずに読み込んだものを持つ。
+		std::shared_ptr<AnimIndex> pIndex = std::make_shared<AnimIndex>();
+		if (!pIndex->Open(animPath.toWstr(), AnimIndexSource::Owned) || pIndex->AnimCount() == 0)
+		{
+			return;
+		}
+
+		m_pAnimIndex = pIndex;
+
+		m_AnimFilePath = animPath;
+		m_SelectFileNo = none;
+
+		//上書き保存した時に読み込んだ形式のままになるようにしておく。
+		m_bSaveFlat       = m_pAnimIndex->Format() == AnimFormat::Flat;
+		m_bSaveCompact    = m_pAnimIndex->Format() == AnimFormat::Compact;
+		m_bSaveCompressed = m_pAnimIndex->IsCompressed();
+
+		//読み込む前にデータを一度消しておく。
+		m_AnimationArray.clear();
+		m_AnimNameIndex.Clear();
+		m_LazyIndexArray.clear();
+		m_SnapshotArray.clear();
+		m_JournalArray.clear();
+		m_PatternTable.clear();
+
+		LoadAnimTexture(animPath, m_pAnimIndex->TextureName());
+
+		size_t animCount = m_pAnimIndex->AnimCount();
+		m_AnimationArray.reserve(animCount);
+		m_AnimNameIndex.Reserve(animCount);
+		m_LazyIndexArray.reserve(animCount);
+		m_SnapshotArray.reserve(animCount);
+		m_JournalArray.reserve(animCount);
+
+		for (size_t i : step(animCount))
+		{
+			//中身は読み込むまで空にしておく。
+			m_AnimationArray << AnimationInfo();
+			m_AnimationArray.back().pattern.clear();
+
+			m_AnimNameIndex.Add(Unicode::Widen(m_pAnimIndex->Name(i)));
+			m_LazyIndexArray << static_cast<int>(i);
+			m_SnapshotArray << AnimationSnapshotCache();
+			m_JournalArray << AnimationSnapshotCache();
+		}
+
+		m_TextFilePath = Unicode::Widen(m_pAnimIndex->TextName());
+
+		//ジャーナルがあれば前回の上書き保存までの変更を反映する。
+		LoadJournal();
+
+		//ファイルを読み込んだ時はいつもリストの先頭を見るようにしておく。(初代ポケモンのミュウバグを防ぐため)
+		m_SelectListNo = 0;
+		LoadLazyAnimation(m_SelectListNo);
+
+		//アニメーションパターン参照でエラーを回避するためリセットしておく。
+		ResetAnimTimer();
+
+		//テキストボックスのアニメーション名が変更されていないので強制的に変更させる。
+		m_AnimationName = m_AnimNameIndex.Name(0);
+
+		//読み込んだばかりなので自動保存はしない。
+		m_bSnapshotDirty = false;
+		m_AutoSaveTime   = 0.0;
+	}
+
+	bool GUIManager::IsTextNewer(const FilePath& txtPath, const FilePath& animPath)
+	{
+		Optional<DateTime> txtTime  = FileSystem::WriteTime(txtPath);
+		Optional<DateTime> animTime = FileSystem::WriteTime(animPath);
+
+		//.animがなければ.txtしかない。
+		if (!animTime)
+		{
+			return true;
+		}
+		if (!txtTime || *txtTime < *animTime)
+		{
+			return false;
+		}
+
+		//ジャーナルに追記した変更は.txtには入っていない。
+		Optional<DateTime> journalTime = FileSystem::WriteTime(animPath + U".journal");
+		return !journalTime || !(*txtTime < *journalTime);
+	}
+
+	void GUIManager::LoadTextDocument(const FilePath& txtPath, const FilePath& animPath, AnimDocument& doc)
+	{
+		LoadAnimTexture(animPath, doc.textureName);
+
+		ApplyDocument(txtPath, animPath, doc);
+		m_SelectFileNo = none;
+	}
+
+	void GUIManager::ApplyDocument(const FilePath& txtPath, const FilePath& animPath, AnimDocument& doc)
+	{
+		//.animの索引とジャーナルは使わない。次の上書き保存で.animごと書き直す。
+		//画像は呼び出し側で先に読み込んでおくこと。
+		m_pAnimIndex.reset();
+
+		m_AnimFilePath = animPath;
+		m_TextFilePath = txtPath;
+
+		m_AnimationArray.clear();
+		m_AnimNameIndex.Clear();
+		m_LazyIndexArray.clear();
+		m_SnapshotArray.clear();
+		m_JournalArray.clear();
+		m_PatternTable.clear();
+
+		size_t animCount = doc.animations.size();
+		m_AnimationArray.reserve(animCount);
+		m_AnimNameIndex.Reserve(animCount);
+		m_LazyIndexArray.reserve(animCount);
+		m_SnapshotArray.reserve(animCount);
+		m_JournalArray.reserve(animCount);
+
+		for (size_t i : step(animCount))
+		{
+			AnimInfoData* pInfo = &(doc.animations[i]);
+
+			m_AnimationArray << AnimationInfo();
+			m_AnimNameIndex.Add(Unicode::Widen(pInfo->name));
+			m_LazyIndexArray << -1;
+			m_SnapshotArray << AnimationSnapshotCache();
+			m_JournalArray << AnimationSnapshotCache();
+
+			//パターンが空ならパターン参照でエラーにならないように初期状態のままにしておく。
+			if (pInfo->pattern.empty())
+			{
+				continue;
+			}
+
+			ApplyAnimData(i, *pInfo);
+
+			//読み込んだデータはそのまま自動保存の写しとして使う。
+			std::shared_ptr<const AnimInfoData> pData = std::make_shared<const AnimInfoData>(std::move(*pInfo));
+			m_SnapshotArray[i] = AnimationSnapshotCache{ m_AnimNameIndex.Name(i), pData };
+			m_JournalArray[i]  = AnimationSnapshotCache{ m_AnimNameIndex.Name(i), pData };
+		}
+
+		m_bSaveJournal       = false;
+		m_JournalSize        = 0;
+		m_JournalBaseSize    = 0;
+		m_JournalCount       = animCount;
+		m_JournalTexturePath = m_TextureFilePath;
+		m_JournalRemoveArray.clear();
+
+		//ファイルを読み込んだ時はいつもリストの先頭を見るようにしておく。
+		m_SelectListNo = 0;
+
+		//アニメーションパターン参照でエラーを回避するためリセットしておく。
+		ResetAnimTimer();
+
+		//テキストボックスのアニメーション名が変更されていないので強制的に変更させる。
+		m_AnimationName = m_AnimNameIndex.Name(0);
+
+		m_bSnapshotDirty = false;
+		m_AutoSaveTime   = 0.0;
+	}
+
+	void GUIManager::LoadFiles(const Array<FilePath>& paths)
+	{
+		if (paths.isEmpty())
+		{
+			return;
+		}
+
+		//番号を変えておくと、前にまとめて開いた分の読み込み待ちは飛ばされ、届いた結果も捨てられる。
+		uint32 batch = ++m_LoadBatch;
+
+		m_FileArray.clear();
+		m_FileArray.reserve(paths.size());
+		m_LoadDoneCount   = 0;
+		m_SelectFileNo    = none;
+		m_bFileListWindow = true;
+
+		for (size_t i : step(paths.size()))
+		{
+			AnimationFileEntry entry;
+			entry.animPath = FileSystem::RelativePath(paths[i]);
+			m_FileArray << std::move(entry);
+
+			//.animとジャーナルの読み込み、画像のデコードまでをワーカースレッドで行う。
+			std::filesystem::path animPath = paths[i].toWstr();
+			LoadPool()->Push([this, batch, i, animPath]()
+			{
+				if (m_LoadBatch != batch)
+				{
+					return;
+				}
+
+				AnimationFileLoadResult result;
+				result.batch    = batch;
+				result.index    = i;
+				result.bSuccess = AnimJournal::Load(animPath, result.doc, result.format, result.compression) && !result.doc.animations.empty();
+				if (result.bSuccess)
+				{
+					//画像の場所はLoadAnimTextureと同じ決め方にする。
+					std::filesystem::path texturePath = AnimCodec::ResolveTexturePath(animPath, result.doc.textureName);
+					result.texturePath  = texturePath.empty() ? Unicode::Widen(result.doc.textureName) : Unicode::FromWString(texturePath.wstring());
+					result.textureStamp = FileStamp::Make(result.texturePath.toWstr());
+
+					//キャッシュにある画像はデコードしない。同じ画像を使うファイルが多いので効く。
+					if (!m_TextureCache.Contains(result.textureStamp))
+					{
+						Array<Image> mips;
+						DecodeTexture(result.texturePath, false, result.image, mips);
+					}
+				}
+				m_LoadQueue.Push(std::move(result));
+			});
+		}
+	}
+
+	void GUIManager::UpdateLoadFiles(void)
+	{
+		//テクスチャの作成はメインスレッドでしかできず重いので、画面が止まらないように1フレームに1つずつ受け取る。
+		AnimationFileLoadResult result;
+		while (m_LoadQueue.TryPop(result))
+		{
+			//まとめて開き直す前の結果は捨てる。
+			if (result.batch != m_LoadBatch)
+			{
+				continue;
+			}
+
+			AnimationFileEntry* pEntry = &(m_FileArray[result.index]);
+			++m_LoadDoneCount;
+
+			if (!result.bSuccess)
+			{
+				pEntry->state = AnimationFileState::Failed;
+				continue;
+			}
+
+			pEntry->doc         = std::move(result.doc);
+			pEntry->format      = result.format;
+			pEntry->compression = result.compression;
+			pEntry->texturePath  = FileSystem::RelativePath(result.texturePath);
+			pEntry->textureStamp = result.textureStamp;
+
+			//同じ画像を使うファイルが先に届いていればキャッシュから受け取り、転送しない。
+			//デコードを飛ばした後でキャッシュから追い出されていた場合は、開く時に読み込み直す。(OpenFileEntry)
+			if (!m_TextureCache.Find(result.textureStamp, pEntry->texture))
+			{
+				pEntry->texture = CreateCachedTexture(result.textureStamp, result.image, Array<Image>());
+			}
+			pEntry->state       = AnimationFileState::Loaded;
+
+			//最初に読み込めたファイルは残りを待たずに開いておく。
+			if (!m_SelectFileNo)
+			{
+				OpenFileEntry(result.index);
+			}
+			break;
+		}
+	}
+
+	void GUIManager::OpenFileEntry(size_t index)
+	{
+		AnimationFileEntry* pEntry = &(m_FileArray[index]);
+		if (pEntry->state != AnimationFileState::Loaded)
+		{
+			return;
+		}
+
+		//画像はデコードとテクスチャの作成まで済んでいるものを使う。
+		//後からミップマップを作っていればキャッシュの方が新しいので、キャッシュにあればそちらを使う。
+		CachedTexture cached = pEntry->texture;
+		m_TextureCache.Find(pEntry->textureStamp, cached);
+		if (cached.texture)
+		{
+			SetTexture(cached, pEntry->textureStamp);
+			m_TextureFilePath = pEntry->texturePath;
+		}
+		else
+		{
+			LoadTexture(pEntry->texturePath);
+		}
+
+		//上書き保存した時に読み込んだ形式のままになるようにしておく。
+		m_bSaveFlat       = pEntry->format == AnimFormat::Flat;
+		m_bSaveCompact    = pEntry->format == AnimFormat::Compact;
+		m_bSaveCompressed = pEntry->compression == AnimCompression::Zstd;
+
+		//編集しても一覧の中身は読み込んだ時のままにして、選び直せば元に戻せるようにする。
+		AnimDocument doc = pEntry->doc;
+		ApplyDocument(Unicode::Widen(doc.textName), pEntry->animPath, doc);
+
+		m_SelectFileNo = index;
+	}
+
+	void GUIManager::UpdateHotReload(void)
+	{
+		//止めている間の変更は拾わない。再開した時点の更新日時から監視し直す。
+		if (!m_bHotReload)
+		{
+			if (!m_DirectoryWatchers.empty())
+			{
+				m_DirectoryWatchers.clear();
+				m_WatchAnim    = WatchedFile();
+				m_WatchTexture = WatchedFile();
+				m_WatchText    = WatchedFile();
+			}
+			return;
+		}
+
+		//開いているファイルが変わったら、入っているフォルダを監視し直す。
+		bool bChanged = SyncWatchedFile(m_WatchAnim, m_AnimFilePath);
+		bChanged = SyncWatchedFile(m_WatchTexture, m_TextureFilePath) || bChanged;
+		bChanged = SyncWatchedFile(m_WatchText, m_TextFilePath) || bChanged;
+
+		WatchedFile* files[] = { &m_WatchAnim, &m_WatchTexture, &m_WatchText };
+
+		if (bChanged)
+		{
+			HashTable<FilePath, DirectoryWatcher> watchers;
+			for (const WatchedFile* pFile : files)
+			{
+				if (pFile->path.isEmpty())
+				{
+					continue;
+				}
+
+				FilePath directory = FileSystem::ParentPath(pFile->path);
+				if (watchers.contains(directory))
+				{
+					continue;
+				}
+
+				//同じフォルダを監視していたものはそのまま使う。
+				auto it = m_DirectoryWatchers.find(directory);
+				watchers.emplace(directory, it != m_DirectoryWatchers.end() ? it->second : DirectoryWatcher(directory));
+			}
+			m_DirectoryWatchers = std::move(watchers);
+		}
+
+		//通知を受け取った時間を覚えておき、書き込みが続いている間は読み込まない。
+		double time = Scene::Time();
+		for (auto& watcher : m_DirectoryWatchers)
+		{
+			for (const auto& change : watcher.second.retrieveChanges())
+			{
+				//一時ファイルから置き換える保存では、消えた直後に作られるので消えた通知は無視する。
+				if (change.second == FileAction::Removed)
+				{
+					continue;
+				}
+
+				FilePath changedPath = FileSystem::FullPath(change.first);
+				for (WatchedFile* pFile : files)
+				{
+					if (pFile->path == changedPath)
+					{
+						pFile->changedTime = time;
+					}
+				}
+			}
+		}
+
+		bool bAnimChanged    = IsWatchedFileChanged(m_WatchAnim, time);
+		bool bTextChanged    = IsWatchedFileChanged(m_WatchText, time);
+		bool bTextureChanged = IsWatchedFileChanged(m_WatchTexture, time);
+
+		//.animか.txtが変わったらドキュメントごと読み込み直す。画像も一緒に読み込まれる。
+		//.txtの方が新しければ.txtの中身が使われる。(LoadData)
+		if (bAnimChanged || bTextChanged)
+		{
+			ReloadDocument(bTextChanged ? m_TextFilePath : m_AnimFilePath);
+			return;
+		}
+
+		//画像だけが変わった場合は画像だけを読み込み直す。パスは変わらないので自動保存の対象にはしない。
+		if (bTextureChanged)
+		{
+			bool bSnapshotDirty = m_bSnapshotDirty;
+			LoadTexture(m_TextureFilePath);
+			m_bSnapshotDirty = bSnapshotDirty;
+		}
+	}
+
+	bool GUIManager::SyncWatchedFile(WatchedFile& file, const FilePath& path)
+	{
+		FilePath fullPath = path.isEmpty() ? FilePath() : FileSystem::FullPath(path);
+		if (file.path == fullPath)
+		{
+			return false;
+		}
+
+		//開いた時点の更新日時を基準にする。
+		file.path        = fullPath;
+		file.stamp       = fullPath.isEmpty() ? FileStamp() : FileStamp::Make(fullPath.toWstr());
+		file.changedTime = -1.0;
+		return true;
+	}
+
+	bool GUIManager::IsWatchedFileChanged(WatchedFile& file, double time)
+	{
+		if (file.changedTime < 0.0 || time - file.changedTime < hotReloadDelay)
+		{
+			return false;
+		}
+		file.changedTime = -1.0;
+
+		//自分で書き出した時や、中身を変えずに閉じただけの通知は更新日時が変わっていない。
+		FileStamp stamp = FileStamp::Make(file.path.toWstr());
+		if (stamp == file.stamp)
+		{
+			return false;
+		}
+		file.stamp = stamp;
+		return true;
+	}
+
+	void GUIManager::RefreshWatchStamps(void)
+	{
+		WatchedFile* files[] = { &m_WatchAnim, &m_WatchTexture, &m_WatchText };
+		for (WatchedFile* pFile : files)
+		{
+			if (!pFile->path.isEmpty())
+			{
+				pFile->stamp = FileStamp::Make(pFile->path.toWstr());
+			}
+		}
+	}
+
+	void GUIManager::ReloadDocument(const FilePath& path)
+	{
+		//読み込み直しても同じアニメーションの同じパターンを見続けられるようにしておく。
+		String selectName    = m_AnimNameIndex.Name(m_SelectListNo);
+		int    pattern       = m_Pattern;
+		double motionTime    = m_MotionTime;
+		int    selectPattern = m_SelectPattern;
+
+		LoadData(path);
+		RefreshWatchStamps();
+
+		size_t index = m_AnimNameIndex.Find(selectName);
+		if (index != m_AnimNameIndex.npos)
+		{
+			LoadLazyAnimation(index);
+
+			m_SelectListNo  = static_cast<uint16>(index);
+			m_AnimationName = m_AnimNameIndex.Name(m_SelectListNo);
+		}
+
+		//パターンが減っていてもはみ出さないようにする。
+		int patternCount = static_cast<int>(m_AnimationArray[m_SelectListNo].pattern.size());
+		m_Pattern       = Clamp(pattern, 0, Max(patternCount - 1, 0));
+		m_MotionTime    = motionTime;
+		m_SelectPattern = Clamp(selectPattern, 0, Max(patternCount - 1, 0));
+	}
+
+	void GUIManager::SaveData(const FilePath& path)
+	{
+		//ファイルパスを相対パスに変換する。
+		FilePath animPath = FileSystem::RelativePath(path);
+
+		//ファイルの拡張子がテキストファイルか調べる。
+		bool isText = FileSystem::Extension(animPath) == U"txt";
+
+		//テキストファイルなら同じファイル名でアニメーションデータを作成する。
+		if (isText)
+		{
+			size_t pathLength = animPath.length();
+			animPath = animPath.substr(0, pathLength - 4);
+			animPath += U".anim";
+		}
+
+		m_AnimFilePath = animPath;
+
+		size_t animPathLength = animPath.length();
+		FilePath txtPath = animPath.substr(0, animPathLength - 5);
+		txtPath += U".txt";
+
+		//未読み込みのアニメーションを全て読み込んでおく。(マップしているファイルに上書きするため閉じておく)
+		LoadAllAnimations();
+
+		//書き込むデータの順番はAnimCodec::Encode関数を参照。
+		AnimDocument doc;
+		MakeDocument(txtPath, doc);
+
+		//.animと.txtの両方をメモリ上に作ってから書き出す。作れなかった場合は何も書き込まずに終了。
+		AnimFormat format           = SaveFormat();
+		AnimCompression compression = m_bSaveCompressed ? AnimCompression::Zstd : AnimCompression::None;
+
+		std::vector<uint8_t> animBuffer;
+		if (!AnimCodec::Encode(doc, animBuffer, format, compression))
+		{
+			return;
+		}
+
+		/// ###          .txtファイルを別に出力                    ###
+		/// ###          中身はAnimText::Export関数を参照          ###
+		std::string text;
+		AnimText::Export(doc, animPath.narrow(), text);
+
+		//それぞれ一時ファイルに一度で書き込んでから置き換えるので、途中で落ちても元のファイルは壊れない。
+		bool bAnimSaved = AtomicFile::Write(m_AnimFilePath.toWstr(), animBuffer.data(), animBuffer.size());
+		bool bTextSaved = bAnimSaved && AtomicFile::Write(txtPath.toWstr(), text.data(), text.size());
+
+		//自分で書き出した変更を外からの変更として読み込み直さないようにする。
+		RefreshWatchStamps();
+
+		if (!bTextSaved)
+		{
+			return;
+		}
+
+		m_TextFilePath = txtPath;
+
+		//C++ヘッダーは.txtと同じ名前で書き出す。中身はAnimHeader::Export関数を参照。
+		if (m_bSaveHeader)
+		{
+			FilePath headerPath = txtPath.substr(0, txtPath.length() - 4) + U".hpp";
+			AnimHeader::Save(headerPath.toWstr(), doc);
+		}
+
+		//全体を書き直したので、ジャーナルは空にするか消しておく。
+		ResetJournal(animBuffer, doc);
+	}
+
+	void GUIManager::ExportData(const FilePath& path, AnimExportFormat format)
+	{
+		//中身の構造はAnimExport.hppを参照。
+		AnimExportWriter writer;
+		if (!writer.Open(path.toWstr(), format))
+		{
+			return;
+		}
+
+		writer.BeginDocument(m_TextureFilePath.narrow(), m_AnimationArray.size());
+
+		//アニメーション1つ分のデータを使い回して順番に書き出す。
+		//未読み込みのアニメーションはGUIには読み込まず、索引から直接デコードする。
+		AnimInfoData data;
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			MakeAnimDataFromIndex(i, data);
+			writer.WriteAnimation(data);
+		}
+
+		writer.Close();
+	}
+
+	void GUIManager::SaveHeader(void)
+	{
+		//SaveDataと同じく.animと同じ名前で書き出す。未読み込みのアニメーションはGUIには読み込まず、索引から直接デコードする。
+		FilePath basePath = m_AnimFilePath.substr(0, m_AnimFilePath.length() - 5);
+
+		AnimDocument doc;
+		doc.textureName = m_TextureFilePath.narrow();
+		doc.textName    = (basePath + U".txt").narrow();
+		doc.animations.resize(m_AnimationArray.size());
+
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			MakeAnimDataFromIndex(i, doc.animations[i]);
+		}
+
+		AnimHeader::Save((basePath + U".hpp").toWstr(), doc);
+	}
+
+	void GUIManager::LoadLazyAnimation(size_t index)
+	{
+		//読み込み済みか、新しく追加したアニメーションなら何もしない。
+		int lazyIndex = m_LazyIndexArray[index];
+		if (lazyIndex < 0 || m_pAnimIndex == nullptr)
+		{
+			return;
+		}
+
+		m_LazyIndexArray[index] = -1;
+
+		AnimationInfo* pAnimInfo = &(m_AnimationArray[index]);
+
+		AnimInfoData data;
+		if (!m_pAnimIndex->DecodeAnimation(static_cast<size_t>(lazyIndex), data) || data.pattern.empty())
+		{
+			//読めなかった場合はパターン参照でエラーにならないように初期状態にしておく。
+			*pAnimInfo = AnimationInfo();
+			return;
+		}
+
+		ApplyAnimData(index, data);
+
+		//デコードしたデータはそのまま自動保存の写しとジャーナルの比較元として使う。
+		std::shared_ptr<const AnimInfoData> pData = std::make_shared<const AnimInfoData>(std::move(data));
+		m_SnapshotArray[index].name  = m_AnimNameIndex.Name(index);
+		m_SnapshotArray[index].pData = pData;
+		m_JournalArray[index].name   = m_AnimNameIndex.Name(index);
+		m_JournalArray[index].pData  = pData;
+	}
+
+	void GUIManager::ApplyAnimData(size_t index, const AnimInfoData& data)
+	{
+		AnimationInfo* pAnimInfo = &(m_AnimationArray[index]);
+
+		pAnimInfo->offsetX = static_cast<double>(data.offsetX);
+		pAnimInfo->offsetY = static_cast<double>(data.offsetY);
+		pAnimInfo->width   = static_cast<double>(data.width  );
+		pAnimInfo->height  = static_cast<double>(data.height );
+		pAnimInfo->bLoop   = data.bLoop;
+
+		//同じ並びのパターンを読み込み済みなら、新しく作らずに共有する。
+		pAnimInfo->pattern = InternPatternArray(data.pattern);
+	}
+
+	AnimationPatternArray GUIManager::InternPatternArray(const std::vector<AnimPatternData>& pattern)
+	{
+		if (pattern.empty())
+		{
+			return AnimationPatternArray();
+		}
+
+		//AnimPatternDataは隙間のない12バイトなので、そのままジャーナルと同じハッシュにかける。
+		uint64 hash = AnimJournal::Hash(reinterpret_cast<const uint8*>(pattern.data()), sizeof(AnimPatternData) * pattern.size());
+
+		//ハッシュが同じでも中身が違えば共有しない。共有していた配列が書き換えられている場合もここで弾かれる。
+		auto it = m_PatternTable.find(hash);
+		if (it != m_PatternTable.end())
+		{
+			std::shared_ptr<std::vector<AnimationPattern>> pShared = it->second.lock();
+			if (pShared && pShared->size() == pattern.size())
+			{
+				bool bSame = true;
+				for (size_t j : step(pattern.size()))
+				{
+					const AnimationPattern* pPattern = &((*pShared)[j]);
+					if (pPattern->wait != static_cast<double>(pattern[j].wait) || pPattern->no != pattern[j].no || pPattern->step != pattern[j].step)
+					{
+						bSame = false;
+						break;
+					}
+				}
+
+				if (bSame)
+				{
+					return AnimationPatternArray(pShared);
+				}
+			}
+		}
+
+		std::shared_ptr<std::vector<AnimationPattern>> pArray = std::make_shared<std::vector<AnimationPattern>>();
+		pArray->reserve(pattern.size());
+
+		for (const AnimPatternData& ptn : pattern)
+		{
+			pArray->push_back(AnimationPattern{ static_cast<double>(ptn.wait), ptn.no, ptn.step });
+		}
+
+		m_PatternTable[hash] = pArray;
+		return AnimationPatternArray(pArray);
+	}
+
+	void GUIManager::LoadAllAnimations(void)
+	{
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			LoadLazyAnimation(i);
+		}
+
+		//全て読み込んだので索引はもう使わない。(書き出し中の自動保存の写しが持っていれば、それが終わった時に手放される)
+		m_pAnimIndex.reset();
+	}
+
+	void GUIManager::MakeDocument(const FilePath& txtPath, AnimDocument& outDoc)
+	{
+		outDoc.textureName = m_TextureFilePath.narrow();
+		outDoc.textName    = txtPath.narrow();
+		outDoc.animations.resize(m_AnimationArray.size());
+
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			MakeAnimData(i, outDoc.animations[i]);
+		}
+	}
+
+	void GUIManager::MakeAnimDataFromIndex(size_t index, AnimInfoData& outData)
+	{
+		//未読み込みのものは索引からデコードし、名前だけは変更後のものにする。
+		int lazyIndex = m_LazyIndexArray[index];
+		if (lazyIndex >= 0 && m_pAnimIndex != nullptr && m_pAnimIndex->DecodeAnimation(static_cast<size_t>(lazyIndex), outData))
+		{
+			outData.name = m_AnimNameIndex.Name(index).narrow();
+			return;
+		}
+		MakeAnimData(index, outData);
+	}
+
+	void GUIManager::MakeAnimData(size_t index, AnimInfoData& outData)
+	{
+		const AnimationInfo* pAnimInfo = &(m_AnimationArray[index]);
+
+		outData.name    = m_AnimNameIndex.Name(index).narrow();
+		outData.offsetX = static_cast<float>(pAnimInfo->offsetX);
+		outData.offsetY = static_cast<float>(pAnimInfo->offsetY);
+		outData.width   = static_cast<float>(pAnimInfo->width  );
+		outData.height  = static_cast<float>(pAnimInfo->height );
+		outData.bLoop   = pAnimInfo->bLoop;
+		outData.pattern.resize(pAnimInfo->pattern.size());
 
-		//1を超えても、引き延ばしてきたなくなるだけなのでクリップしておく。
-		scale = Clamp(scale, 0.1, 1.0);
+		for (size_t j : step(pAnimInfo->pattern.size()))
+		{
+			const AnimationPattern* pPattern = &(pAnimInfo->pattern[j]);
+			AnimPatternData* pPtnData        = &(outData.pattern[j]);
 
-		return scale;
+			pPtnData->wait = static_cast<float>(pPattern->wait);
+			pPtnData->no   = pPattern->no;
+			pPtnData->step = pPattern->step;
+		}
 	}
 
-	void GUIManager::LoadData(const FilePath& path)
+	bool GUIManager::IsSameAnimData(size_t index, const AnimInfoData& data)
 	{
-		//ファイルパスを相対パスに変換する。
-		FilePath animPath = FileSystem::RelativePath(path);
-
-		//ファイルの拡張子がテキストファイルか調べる。
-		bool isText = FileSystem::Extension(path) == U"txt";
+		//保存した時と同じ値になるかをfloatにしてから比べる。
+		const AnimationInfo* pAnimInfo = &(m_AnimationArray[index]);
+
+		if (static_cast<float>(pAnimInfo->offsetX) != data.offsetX ||
+			static_cast<float>(pAnimInfo->offsetY) != data.offsetY ||
+			static_cast<float>(pAnimInfo->width  ) != data.width   ||
+			static_cast<float>(pAnimInfo->height ) != data.height  ||
+			pAnimInfo->bLoop != data.bLoop ||
+			pAnimInfo->pattern.size() != data.pattern.size())
+		{
+			return false;
+		}
 
-		//テキストファイルならデータの一行目からファイル名を取得する。
-		if (isText)
+		for (size_t j : step(pAnimInfo->pattern.size()))
 		{
-			TextReader tr;
-			if (!tr.open(animPath))
+			const AnimationPattern* pPattern = &(pAnimInfo->pattern[j]);
+			const AnimPatternData* pPtnData  = &(data.pattern[j]);
+
+			if (static_cast<float>(pPattern->wait) != pPtnData->wait ||
+				pPattern->no   != pPtnData->no ||
+				pPattern->step != pPtnData->step)
 			{
-				return;
+				return false;
 			}
-			tr.readLine(animPath);
-			tr.close();
 		}
+		return true;
+	}
 
+	AnimFormat GUIManager::SaveFormat(void) const
+	{
+		if (m_bSaveCompact)
+		{
+			return AnimFormat::Compact;
+		}
+		return m_bSaveFlat ? AnimFormat::Flat : AnimFormat::Legacy;
+	}
 
-		//アニメーションファイルを開く。失敗した場合読み込みせず終了。
-		BinaryReader br;
-		if (!br.open(animPath))
+	void GUIManager::AutoSave(void)
+	{
+		if (!m_bAutoSave)
 		{
 			return;
 		}
 
-		m_AnimFilePath = animPath;
-		
-		//読み込む前にデータを一度消しておく。
-		m_AnimationArray.clear();
-		m_AnimNameArray.clear();
-
-		//書き出した順に読み込む。書き出し順はSaveData関数を参照。
-		
-		int textureNameLength;
-		
-		br.read(&textureNameLength, sizeof(int));
-		
-		char* textureName = new char[textureNameLength + 1];
-		
-		br.read(textureName, sizeof(char) * textureNameLength);
-		
-		textureName[textureNameLength] = '\0';
-
-		LoadTexture(Unicode::Widen(textureName));
-
-		SAFE_DELETEARRAY(textureName);
-
-		int animCount;
-		
-		br.read(&animCount, sizeof(int));
-
-		for (int i : step(animCount))
+		//前回の書き出しが終わっていなければ次のフレームでもう一度試す。
+		m_AutoSaveTime += Scene::DeltaTime();
+		if (m_AutoSaveTime < autoSaveInterval || m_AutoSave.IsBusy())
 		{
-			m_AnimationArray << AnimationInfo();
-			m_AnimNameArray << String();
-			
-			AnimationInfo* pAnimInfo = &(m_AnimationArray[i]);
-			
-			int animNameLength;
-
-			br.read(&animNameLength, sizeof(int));
-			
-			char* animName = new char[animNameLength + 1];
+			return;
+		}
+		m_AutoSaveTime = 0.0;
 
-			br.read(animName, sizeof(char) * animNameLength);
-			
-			animName[animNameLength] = '\0';
-			
-			m_AnimNameArray[i] = Unicode::Widen(animName);
+		//写しを作るのは変更されたアニメーションのコピーだけなので、エンコードと書き出しは全てワーカースレッドで行う。
+		std::unique_ptr<AnimSnapshot> pSnapshot = std::make_unique<AnimSnapshot>();
+		if (!MakeSnapshot(*pSnapshot))
+		{
+			return;
+		}
+		m_AutoSave.Request(std::move(pSnapshot));
+	}
 
-			SAFE_DELETEARRAY(animName);
+	bool GUIManager::MakeSnapshot(AnimSnapshot& outSnapshot)
+	{
+		bool bChanged = m_bSnapshotDirty;
+		m_bSnapshotDirty = false;
 
-			float offsetX;
-			float offsetY;
-			float width;
-			float height;
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			AnimationSnapshotCache* pCache = &(m_SnapshotArray[i]);
 
-			br.read(&offsetX, sizeof(float));
-			br.read(&offsetY, sizeof(float));
-			br.read(&width  , sizeof(float));
-			br.read(&height , sizeof(float));
+			//未読み込みのものはファイルの中身から変わっていないので比べない。
+			if (m_LazyIndexArray[i] >= 0 && m_pAnimIndex != nullptr)
+			{
+				continue;
+			}
 
-			pAnimInfo->offsetX = static_cast<double>(offsetX);
-			pAnimInfo->offsetY = static_cast<double>(offsetY);
-			pAnimInfo->width   = static_cast<double>(width  );
-			pAnimInfo->height  = static_cast<double>(height );
+			//変更されたものだけ新しくコピーする。
+			if (pCache->pData == nullptr || pCache->name != m_AnimNameIndex.Name(i) || !IsSameAnimData(i, *pCache->pData))
+			{
+				std::shared_ptr<AnimInfoData> pData = std::make_shared<AnimInfoData>();
+				MakeAnimData(i, *pData);
+				pCache->name  = m_AnimNameIndex.Name(i);
+				pCache->pData = pData;
+				bChanged      = true;
+			}
+		}
 
-			char loop;
-			br.read(&loop, sizeof(char));
-			pAnimInfo->bLoop = loop;
+		if (!bChanged)
+		{
+			return false;
+		}
 
-			int patternCount;
+		//保存先は元のファイルの横に作る。まだ保存していなければ作業フォルダに作る。
+		FilePath basePath = m_AnimFilePath;
+		if (basePath.ends_with(U".anim"))
+		{
+			basePath = basePath.substr(0, basePath.length() - 5);
+		}
+		if (basePath.isEmpty())
+		{
+			basePath = U"animake";
+		}
 
-			br.read(&patternCount, sizeof(int));
+		FilePath animPath = basePath + U".autosave.anim";
+		FilePath txtPath  = basePath + U".autosave.txt";
 
-			//パターンデータもクリアしておく。
-			pAnimInfo->pattern.clear();
+		outSnapshot.animFilePath = animPath.toWstr();
+		outSnapshot.textFilePath = txtPath.toWstr();
+		outSnapshot.animPath     = animPath.narrow();
+		outSnapshot.textureName  = m_TextureFilePath.narrow();
+		outSnapshot.textName     = txtPath.narrow();
+		outSnapshot.format       = SaveFormat();
+		outSnapshot.compression  = m_bSaveCompressed ? AnimCompression::Zstd : AnimCompression::None;
 
-			for (int j : step(patternCount))
+		//未読み込みのものはここではデコードせず、索引を共有してワーカースレッドでデコードさせる。
+		outSnapshot.animations.reserve(m_SnapshotArray.size());
+		for (size_t i : step(m_SnapshotArray.size()))
+		{
+			if (m_LazyIndexArray[i] >= 0 && m_pAnimIndex != nullptr)
 			{
-				pAnimInfo->pattern << AnimationPattern();
+				outSnapshot.animations.push_back(nullptr);
+				outSnapshot.lazyAnimations.push_back(AnimSnapshotLazy{ i, static_cast<size_t>(m_LazyIndexArray[i]), m_AnimNameIndex.Name(i).narrow() });
+				continue;
+			}
+			outSnapshot.animations.push_back(m_SnapshotArray[i].pData);
+		}
+		outSnapshot.pIndex = m_pAnimIndex;
+		return true;
+	}
 
-				AnimationPattern* pPattern = &(pAnimInfo->pattern[j]);
+	void GUIManager::LoadJournal(void)
+	{
+		m_JournalSize        = 0;
+		m_JournalBaseSize    = 0;
+		m_JournalCount       = m_AnimationArray.size();
+		m_JournalTexturePath = m_TextureFilePath;
+		m_JournalRemoveArray.clear();
+
+		std::vector<AnimJournalRecord> records;
+		uint64 validSize;
+		if (!AnimJournal::Read(m_AnimFilePath.toWstr(), records, validSize))
+		{
+			return;
+		}
 
-				float wait;
+		//変更を順番に反映する。範囲外を指しているものは飛ばす。
+		for (const AnimJournalRecord& record : records)
+		{
+			size_t animIndex = record.animIndex;
 
-				br.read(&wait, sizeof(float));
+			switch (record.op)
+			{
+			case AnimJournalOp::SetAnimation:
+				//パターンがないものはApplyDocumentと同じく反映しない。(パターン配列が空のままになるため)
+				if (animIndex > m_AnimationArray.size() || record.info.pattern.empty())
+				{
+					break;
+				}
+				if (animIndex == m_AnimationArray.size())
+				{
+					m_AnimationArray << AnimationInfo();
+					m_AnimNameIndex.Add(String());
+					m_LazyIndexArray << -1;
+					m_SnapshotArray << AnimationSnapshotCache();
+					m_JournalArray << AnimationSnapshotCache();
+				}
+				m_LazyIndexArray[animIndex] = -1;
+				m_AnimNameIndex.Rename(animIndex, Unicode::Widen(record.info.name));
+				ApplyAnimData(animIndex, record.info);
+				m_SnapshotArray[animIndex]  = AnimationSnapshotCache();
+				m_JournalArray[animIndex]   = AnimationSnapshotCache();
+				break;
+			case AnimJournalOp::RemoveAnimation:
+				if (animIndex >= m_AnimationArray.size() || m_AnimationArray.size() <= 1)
+				{
+					break;
+				}
+				m_AnimationArray.remove_at(animIndex);
+				m_AnimNameIndex.RemoveAt(animIndex);
+				m_LazyIndexArray.remove_at(animIndex);
+				m_SnapshotArray.remove_at(animIndex);
+				m_JournalArray.remove_at(animIndex);
+				break;
+			case AnimJournalOp::SetPattern:
+				if (animIndex >= m_AnimationArray.size())
+				{
+					break;
+				}
+				LoadLazyAnimation(animIndex);
+				if (record.patternIndex < m_AnimationArray[animIndex].pattern.size())
+				{
+					AnimationPattern* pPattern = &(m_AnimationArray[animIndex].pattern.Edit()[record.patternIndex]);
 
-				pPattern->wait = static_cast<double>(wait);
+					pPattern->wait = static_cast<double>(record.pattern.wait);
+					pPattern->no   = record.pattern.no;
+					pPattern->step = record.pattern.step;
+				}
+				m_SnapshotArray[animIndex]  = AnimationSnapshotCache();
+				m_JournalArray[animIndex]   = AnimationSnapshotCache();
+				break;
+			case AnimJournalOp::SetTexture:
+				LoadAnimTexture(m_AnimFilePath, record.textureName);
+				break;
+			}
+		}
 
-				br.read(&(pPattern->no)  , sizeof(int));
-				br.read(&(pPattern->step), sizeof(int));
+		//反映した後の状態を比較元にしておく。未読み込みのものはファイルのままなので読み込んだ時に作る。
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			if (m_LazyIndexArray[i] < 0 && m_JournalArray[i].pData == nullptr)
+			{
+				std::shared_ptr<AnimInfoData> pData = std::make_shared<AnimInfoData>();
+				MakeAnimData(i, *pData);
+				m_SnapshotArray[i] = AnimationSnapshotCache{ m_AnimNameIndex.Name(i), pData };
+				m_JournalArray[i]  = AnimationSnapshotCache{ m_AnimNameIndex.Name(i), pData };
 			}
 		}
 
-		int textNameLength;
+		//上書き保存した時にジャーナルを使い続けるようにしておく。
+		m_bSaveJournal       = true;
+		m_JournalSize        = validSize;
+		m_JournalBaseSize    = static_cast<uint64>(FileSystem::FileSize(m_AnimFilePath));
+		m_JournalCount       = m_AnimationArray.size();
+		m_JournalTexturePath = m_TextureFilePath;
+	}
 
-		br.read(&textNameLength, sizeof(int));
+	bool GUIManager::SaveJournal(void)
+	{
+		//ジャーナルがまだなければ全体を保存してもらう。
+		if (m_JournalSize == 0)
+		{
+			return false;
+		}
 
-		char* textName = new char[textNameLength + 1];
+		//並びの変更を先に書き、その後で今の番号で変更したアニメーションを書く。
+		std::vector<uint8_t> records;
 
-		br.read(textName, sizeof(char) * textNameLength);
+		for (uint32 removeIndex : m_JournalRemoveArray)
+		{
+			AnimJournalRecord record;
+			record.op        = AnimJournalOp::RemoveAnimation;
+			record.animIndex = removeIndex;
+			AnimJournal::EncodeRecord(record, records);
+		}
 
-		textName[textNameLength] = '\0';
+		if (m_TextureFilePath != m_JournalTexturePath)
+		{
+			AnimJournalRecord record;
+			record.op          = AnimJournalOp::SetTexture;
+			record.textureName = m_TextureFilePath.narrow();
+			AnimJournal::EncodeRecord(record, records);
+		}
 
-		m_TextFilePath = Unicode::Widen(textName);
+		Array<std::pair<size_t, std::shared_ptr<const AnimInfoData>>> changedArray;
 
-		SAFE_DELETEARRAY(textName);
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			//未読み込みのものは変更されていない。
+			if (m_LazyIndexArray[i] >= 0)
+			{
+				continue;
+			}
 
-		br.close();
+			const AnimationSnapshotCache* pCache = &(m_JournalArray[i]);
+			if (pCache->pData != nullptr && pCache->name == m_AnimNameIndex.Name(i) && IsSameAnimData(i, *pCache->pData))
+			{
+				continue;
+			}
 
-		//アニメーションパターン参照でエラーを回避するためリセットしておく。
-		ResetAnimTimer();
+			std::shared_ptr<AnimInfoData> pData = std::make_shared<AnimInfoData>();
+			MakeAnimData(i, *pData);
 
-		//テキストボックスのアニメーション名が変更されていないので強制的に変更させる。
-		m_AnimationName = m_AnimNameArray[0];
+			const AnimInfoData* pBase = pCache->pData.get();
+			bool bPatternOnly = pBase != nullptr &&
+				pCache->name == m_AnimNameIndex.Name(i) &&
+				pBase->offsetX == pData->offsetX &&
+				pBase->offsetY == pData->offsetY &&
+				pBase->width   == pData->width   &&
+				pBase->height  == pData->height  &&
+				pBase->bLoop   == pData->bLoop   &&
+				pBase->pattern.size() == pData->pattern.size();
 
-		//ファイルを読み込んだ時はいつもリストの先頭を見るようにしておく。(初代ポケモンのミュウバグを防ぐため)
-		m_SelectListNo = 0;
-	}
+			if (bPatternOnly)
+			{
+				//パターンだけが変わったなら変わったパターンだけを書く。
+				for (size_t j : step(pData->pattern.size()))
+				{
+					const AnimPatternData* pOld = &(pBase->pattern[j]);
+					const AnimPatternData* pNew = &(pData->pattern[j]);
+					if (pOld->wait == pNew->wait && pOld->no == pNew->no && pOld->step == pNew->step)
+					{
+						continue;
+					}
 
-	void GUIManager::SaveData(const FilePath& path)
-	{
-		//ファイルパスを相対パスに変換する。
-		FilePath animPath = FileSystem::RelativePath(path);
+					AnimJournalRecord record;
+					record.op           = AnimJournalOp::SetPattern;
+					record.animIndex    = static_cast<uint32>(i);
+					record.patternIndex = static_cast<uint32>(j);
+					record.pattern      = *pNew;
+					AnimJournal::EncodeRecord(record, records);
+				}
+			}
+			else
+			{
+				AnimJournalRecord record;
+				record.op        = AnimJournalOp::SetAnimation;
+				record.animIndex = static_cast<uint32>(i);
+				record.info      = *pData;
+				AnimJournal::EncodeRecord(record, records);
+			}
 
-		//ファイルの拡張子がテキストファイルか調べる。
-		bool isText = FileSystem::Extension(animPath) == U"txt";
+			changedArray.emplace_back(i, pData);
+		}
 
-		//テキストファイルなら同じファイル名でアニメーションデータを作成する。
-		if (isText)
+		//何も変わっていなければ保存済み。
+		if (records.empty())
 		{
-			size_t pathLength = animPath.length();
-			animPath = animPath.substr(0, pathLength - 4);
-			animPath += U".anim";
+			return true;
 		}
 
-		m_AnimFilePath = animPath;
-
-		//アニメーションファイルを開く。失敗した場合書き込みせず終了。
-		BinaryWriter bw;
-		if (!bw.open(m_AnimFilePath))
+		//ジャーナルが元のファイルより大きくなるなら全体を書き直して整理してもらう。
+		uint64 compactSize = Max<uint64>(m_JournalBaseSize, journalCompactSize);
+		if (m_JournalSize + records.size() > compactSize)
 		{
-			return;
+			return false;
 		}
 
-		/// ###          書き込むデータの順番は以下の通り          ###
-		//     ・テクスチャのファイル名の長さ( int   )
-		//     ・テクスチャのファイル名      ( char  )
-		//     ・アニメーションの数          ( int   )
-		/// ##ここからアニメーションの数だけループ
-		//     ・アニメーション名の長さ      ( int   )
-		//     ・アニメーション名            ( char  )
-		//     ・オフセットX                 ( float )
-		//     ・オフセットY                 ( float )
-		//     ・横幅                        ( float )
-		//     ・高さ                        ( float )
-		//     ・ループフラグ                ( char  )
-		//     ・アニメーションパターン数    ( int   )
-		///  #ここからパターンの数だけループ
-		//     ・待機フレーム                ( float ) 
-		//     ・No                          ( int   )
-		//     ・Step                        ( int   )
-		///  #ここまでパターンの数だけループ
-		/// ##ここまでアニメーションの数だけループ
-		//     ・テキストファイル名の長さ    ( int   )
-		//     ・テキストファイル名          ( char  )
-		//     ・EOF
-		/// ###          ここまで.animファイル                     ###
-		/// ###          .txtファイルを別に出力                    ###
-		/// ###          .txtファイルなので読めばわかる            ###
-		
-		std::string textureName = m_TextureFilePath.narrow();
-		int textureNameLength   = static_cast<int>(m_TextureFilePath.length());
-		int animCount           = static_cast<int>(m_AnimationArray.size());
-
-		bw.write(&textureNameLength , sizeof(int) );
-		bw.write(textureName.c_str(), sizeof(char) * textureNameLength);
-		bw.write(&animCount         , sizeof(int) );
-		
-		for (int i : step(animCount))
+		if (!AnimJournal::Append(m_AnimFilePath.toWstr(), records, m_JournalSize))
 		{
-			AnimationInfo* pAnimInfo = &(m_AnimationArray[i]);
-			std::string animName     = m_AnimNameArray[i].narrow();
-			int animNameLength       = static_cast<int>  (animName.size());
-			float offsetX            = static_cast<float>(pAnimInfo->offsetX);
-			float offsetY            = static_cast<float>(pAnimInfo->offsetY);
-			float width              = static_cast<float>(pAnimInfo->width  );
-			float height             = static_cast<float>(pAnimInfo->height );
-			int   patternCount       = static_cast<int>  (pAnimInfo->pattern.size());
+			return false;
+		}
 
-			char loop = pAnimInfo->bLoop ? 1 : 0;
-			bw.write(&animNameLength    , sizeof(int)  );
-			bw.write(animName.c_str()   , sizeof(char) * animNameLength);
-			bw.write(&offsetX           , sizeof(float));
-			bw.write(&offsetY           , sizeof(float));
-			bw.write(&width             , sizeof(float));
-			bw.write(&height            , sizeof(float));
-			bw.write(&loop              , sizeof(char) );
-			bw.write(&patternCount      , sizeof(int)  );
+		m_JournalSize       += records.size();
+		m_JournalCount       = m_AnimationArray.size();
+		m_JournalTexturePath = m_TextureFilePath;
+		m_JournalRemoveArray.clear();
 
-			for (int j : step(patternCount))
-			{
-				AnimationPattern* pPattern = &(pAnimInfo->pattern[j]);
-				float wait = static_cast<float>(pPattern->wait);
-				bw.write(&wait            , sizeof(float));
-				bw.write(&(pPattern->no)  , sizeof(int)  );
-				bw.write(&(pPattern->step), sizeof(int)  );
-			}
+		for (const auto& changed : changedArray)
+		{
+			m_JournalArray[changed.first] = AnimationSnapshotCache{ m_AnimNameIndex.Name(changed.first), changed.second };
 		}
+		return true;
+	}
 
-		size_t animPathLength = animPath.length();
-		FilePath txtPath = animPath.substr(0, animPathLength - 5);
-		txtPath += U".txt";
-		int txtPathLength = static_cast<int>(txtPath.length());
-		std::string textName = txtPath.narrow();
-		bw.write(&txtPathLength  , sizeof(int) );
-		bw.write(textName.c_str(), sizeof(char) * txtPathLength);
-
-		bw.close();
+	void GUIManager::ResetJournal(const std::vector<uint8_t>& animBuffer, AnimDocument& doc)
+	{
+		m_JournalSize = 0;
+		m_JournalRemoveArray.clear();
 
-		TextWriter tw;
-		if (!tw.open(txtPath))
+		//ジャーナルを使わないなら古いジャーナルが残らないように消しておく。
+		if (!m_bSaveJournal || !AnimJournal::Create(m_AnimFilePath.toWstr(), animBuffer.data(), animBuffer.size()))
 		{
+			AnimJournal::Remove(m_AnimFilePath.toWstr());
 			return;
 		}
 
-		m_TextFilePath = txtPath;
+		m_JournalSize        = sizeof(AnimJournalHeader);
+		m_JournalBaseSize    = animBuffer.size();
+		m_JournalCount       = m_AnimationArray.size();
+		m_JournalTexturePath = m_TextureFilePath;
 
-		tw.write(animPath + U'\n');
-		tw.write(U"上記データファイル名を消すとツールで読み込めなくなります。\n");
-		tw.write(U"対応画像ファイル名：" + m_TextureFilePath + U"\n");
-		tw.write(U"以下コピペ用\n");
-		//例：
-		//    {
-		//        {
-		//                "NewAnimaiton1",
-		//                0,0,
-		//                60,70,
-		//                TRUE,{{5,0,0},{5,1,0},{5,2,0},{5,3,0}}
-		//        },
-		//    };
-		tw.write(U"{\n");
-		for (int i : step(animCount))
-		{
-			tw.write(U"\t{\n");
-			{
-				AnimationInfo* pAnimInfo = &(m_AnimationArray[i]);
-				
-				//アニメーション名の書き出し
-				tw.write(U"\t\t\"" + m_AnimNameArray[i]         + U"\",\n");
-				
-				//オフセット位置の書き出し
-				tw.write(U"\t\t"   + Format(pAnimInfo->offsetX) + U"," + Format(pAnimInfo->offsetY) + U"," + U"\n");
-				
-				//幅、高さの書き出し
-				tw.write(U"\t\t"   + Format(pAnimInfo->width)   + U"," + Format(pAnimInfo->height)  + U"," + U"\n");
-				
-				//ループフラグの書き出し
-				String sLoop = pAnimInfo->bLoop ? U"TRUE" : U"FALSE";
-				tw.write(U"\t\t"   + sLoop + U",{");
-				
-				size_t patternCount = pAnimInfo->pattern.size();
-				for (auto j : step(patternCount))
-				{
-					AnimationPattern* pPattern = &(pAnimInfo->pattern[j]);
-					
-					//アニメーションパターンの書き出し
-					tw.write(U"{" + Format(pPattern->wait) + U"," + Format(pPattern->no) + U"," + Format(pPattern->step) + U"}");
-					
-					//最後のパターン以外はカンマで区切る。
-					if (j != patternCount - 1)
-					{
-						tw.write(U",");
-					}
-				}
-				tw.write(U"}\n\t},\n");
-			}
+		//書き出したデータをそのまま比較元にする。
+		for (size_t i : step(m_AnimationArray.size()))
+		{
+			m_JournalArray[i] = AnimationSnapshotCache{ m_AnimNameIndex.Name(i), std::make_shared<const AnimInfoData>(std::move(doc.animations[i])) };
 		}
-		tw.write(U"};");
-		tw.close();
 	}
 
 	void GUIManager::AnimationViewWindow(void)
@@ -651,6 +1682,21 @@ namespace siapp
 			
 			break;
 		}
+
+		//表示しているタブで縮小表示になっていれば、その時に初めてミップマップを作る。
+		//等倍や整数倍で見ている間は作らない。
+		double minScale = 1.0;
+		switch (tabNo)
+		{
+		case 0: minScale = Min(m_TexScale, Min(m_AnimScale, m_EditScale)); break;
+		case 1: minScale = m_AnimScale; break;
+		case 2: minScale = m_EditScale; break;
+		case 3: minScale = m_TexScale;  break;
+		}
+		if (minScale < 1.0)
+		{
+			RequestTextureMips();
+		}
 	}
 
 	void GUIManager::TextureScaleWindow(const RectF& rect, const double& def, bool& outOver)
@@ -685,7 +1731,7 @@ namespace siapp
 			}
 			
 			m_pGui->newLine();
-			m_pGui->label(U"画像サイズ：" + Format(m_Texture.width()) + U"x" + Format(m_Texture.height()) + U"(pix)");
+			m_pGui->label(IsTextureLoading() ? String(U"画像を読み込み中…") : U"画像サイズ：" + Format(m_Texture.width()) + U"x" + Format(m_Texture.height()) + U"(pix)");
 
 			outOver = m_pGui->windowHovered();
 		}
@@ -837,10 +1883,10 @@ namespace siapp
 		m_pGui->label(U"アニメーション名");
 		m_pGui->newLine();
 
-		//テキストボックスに変更があった場合リスト内の文字列を更新する。
+		//テキストボックスに変更があった場合リスト内の文字列を更新する。索引もこの名前の分だけ書き換わる。
 		if (m_pGui->textBox(m_AnimationName, U"", SasaGUI::TextInputFlag::All, 265.0))
 		{
-			m_AnimNameArray[m_SelectListNo] = m_AnimationName;
+			m_AnimNameIndex.Rename(m_SelectListNo, m_AnimationName);
 		}
 	}
 
@@ -883,7 +1929,7 @@ namespace siapp
 		m_pGui->groupBegin(U"", /*frame = */ true, /*enable = */ true);
 		{
 			//パターン配列の参照
-			Array<AnimationPattern>* pSelectPatternArray = &(m_AnimationArray[m_SelectListNo].pattern);
+			const AnimationPatternArray* pSelectPatternArray = &(m_AnimationArray[m_SelectListNo].pattern);
 
 			//      label(      表示テキスト,      表示色, 有効フラグ, 表示座標)
 			m_pGui->label(U"パターン番号 : ", unspecified,       true, Vec2(15.0, 320.0));
@@ -897,13 +1943,21 @@ namespace siapp
 			//      spinBox(     扱うデータ, 最小値,     最大値, 加算値,  横幅, 有効フラグ, 表示座標)
 			m_pGui->spinBox(m_SelectPattern,      0, patternMax,      1, 150.0,       true, Vec2(130.0, 320.0));
 
-			//編集中のパターンを参照
-			AnimationPattern* pSelectPattern = (&(*pSelectPatternArray)[m_SelectPattern]);
+			//編集中のパターンを写しで受け取る。(共有している配列を表示しただけで複製しないように)
+			AnimationPattern selectPattern = (*pSelectPatternArray)[m_SelectPattern];
+			AnimationPattern* pSelectPattern = &selectPattern;
 		
 			//      spinBox(          扱うデータ, 最小値, 最大値, 加算値,  横幅, 有効フラグ, 表示座標)
 			m_pGui->spinBox(pSelectPattern->wait,    0.0, 1024.0,    0.1, 150.0,       true, Vec2(130.0, 360.0));
 			m_pGui->spinBox(pSelectPattern->no  ,      0,   1024,      1, 150.0,       true, Vec2(130.0, 400.0));
 			m_pGui->spinBox(pSelectPattern->step,      0,   1024,      1, 150.0,       true, Vec2(130.0, 440.0));
+
+			//値が変わった時だけ書き戻す。
+			const AnimationPattern* pOldPattern = &((*pSelectPatternArray)[m_SelectPattern]);
+			if (pSelectPattern->wait != pOldPattern->wait || pSelectPattern->no != pOldPattern->no || pSelectPattern->step != pOldPattern->step)
+			{
+				m_AnimationArray[m_SelectListNo].pattern.Edit()[m_SelectPattern] = selectPattern;
+			}
 		}
 		m_pGui->groupEnd();
 	}
@@ -916,15 +1970,18 @@ namespace siapp
 			{
 				//アニメーションデータと名前を追加する。名前にはリストの数を添える。
 				m_AnimationArray << AnimationInfo();
+				m_LazyIndexArray << -1;
+				m_SnapshotArray << AnimationSnapshotCache();
+				m_JournalArray << AnimationSnapshotCache();
 				int size = static_cast<int>(m_AnimationArray.size());
 
 				//同じ名前があると表示がおかしくなるので後ろに付け足す。(ライブラリ側の仕様のため)
 				String addName = U"NewAnimation" + Format(size);
-				while (m_AnimNameArray.count(addName) != 0)
+				while (m_AnimNameIndex.Contains(addName))
 				{
 					addName += U"+";
 				}
-				m_AnimNameArray << addName;
+				m_AnimNameIndex.Add(std::move(addName));
 			}
 
 			//アニメーション数が2以上で削除できるようにする。(0になるのを防ぐ)
@@ -950,18 +2007,36 @@ namespace siapp
 			{
 				m_bDeleteAssert = false;
 				
+				//ジャーナルに書いたことのあるアニメーションなら、消したことを次の上書き保存で書けるように覚えておく。
+				if (m_SelectListNo < m_JournalCount)
+				{
+					m_JournalRemoveArray << m_SelectListNo;
+					m_JournalCount--;
+				}
+
 				//選択中のデータを消してリサイズする。
-				m_AnimNameArray.remove_at(m_SelectListNo);
+				m_AnimNameIndex.RemoveAt(m_SelectListNo);
 				m_AnimationArray.remove_at(m_SelectListNo);
+				m_LazyIndexArray.remove_at(m_SelectListNo);
+				m_SnapshotArray.remove_at(m_SelectListNo);
+				m_JournalArray.remove_at(m_SelectListNo);
 				uint16 size = (uint16)m_AnimationArray.size();
 				m_AnimationArray.resize(size);
-				m_AnimNameArray.resize(size);
+				m_LazyIndexArray.resize(size);
+				m_SnapshotArray.resize(size);
+				m_JournalArray.resize(size);
+
+				//アニメーションが減ったことは写しの比較では分からないので印を付けておく。
+				m_bSnapshotDirty = true;
 				
 				//消したときに配列の境界外を参照しないようにクリップしておく。
 				m_SelectListNo = Clamp(m_SelectListNo, uint16(0), uint16(size - 1));
 
+				//選択先が未読み込みなら読み込んでおく。
+				LoadLazyAnimation(m_SelectListNo);
+
 				//アニメーション名テキストが反映されていないので書き換えておく。
-				m_AnimationName = m_AnimNameArray[m_SelectListNo];
+				m_AnimationName = m_AnimNameIndex.Name(m_SelectListNo);
 
 				//アニメーションが変更されるのでアニメーションをリセットしておく。
 				m_SelectPattern = 0;
@@ -1028,6 +2103,7 @@ namespace siapp
 				m_pGui->checkBox(m_bTextureScaleWindow  , U"画像スケールウィンドウ表示");           m_pGui->newLine();
 				m_pGui->checkBox(m_bAnimationScaleWindow, U"アニメーションスケールウィンドウ表示");	m_pGui->newLine();
 				m_pGui->checkBox(m_bEditScaleWindow     , U"編集スケールウィンドウ表示");           m_pGui->newLine();
+				m_pGui->checkBox(m_bFileListWindow      , U"開いたファイル一覧ウィンドウ表示");     m_pGui->newLine();
 				break;
 			}
 			case 3:
@@ -1046,6 +2122,9 @@ namespace siapp
 			{
 				m_pGui->label(U"Release Ver. " + Format(appVersion));
 				m_pGui->newLine();
+
+				//テクスチャキャッシュの使用量とヒット率
+				TextureCacheGroup();
 				break;
 			}
 			}
@@ -1074,6 +2153,15 @@ namespace siapp
 			}
 		}
 
+		//複数の.animを別スレッドで読み込み、開いたファイルの一覧から切り替えられるようにする。
+		if (m_pGui->button(U"まとめて開く"))
+		{
+			Array<FileFilter> filter;
+			filter << FileFilter({ U"アニメーションデータ(*.anim)", { U"anim" } });
+			filter << FileFilter::AllFiles();
+			LoadFiles(Dialog::OpenFiles(filter, m_CurrentDir, U"アニメーションデータをまとめて開く"));
+		}
+
 		if (m_pGui->button(U"保存"))
 		{
 			Array<FileFilter> filter;
@@ -1102,11 +2190,71 @@ namespace siapp
 					SaveData(path.value());
 				}
 			}
-			else
+			else if (!m_bSaveJournal || !SaveJournal())
 			{
+				//ジャーナルに追記できなかったか、整理が必要な場合は全体を書き直す。
 				SaveData(m_AnimFilePath);
 			}
+			else if (m_bSaveHeader)
+			{
+				//ジャーナルへの追記ではC++ヘッダーが古いままになるので、メモリ上のデータから作り直す。
+				SaveHeader();
+			}
+		}
+
+		//UnityやGodotのツールで読み込むためのファイルを書き出す。.animはそのまま。
+		if (m_pGui->button(U"JSON出力"))
+		{
+			Array<FileFilter> filter;
+			filter << FileFilter({ U"JSON(*.json)", { U"json" } });
+			Optional<FilePath> path = Dialog::SaveFile(filter, m_CurrentDir, U"JSONで出力");
+			if (path != none)
+			{
+				ExportData(path.value(), AnimExportFormat::Json);
+			}
+		}
+
+		if (m_pGui->button(U"MessagePack出力"))
+		{
+			Array<FileFilter> filter;
+			filter << FileFilter({ U"MessagePack(*.msgpack)", { U"msgpack" } });
+			Optional<FilePath> path = Dialog::SaveFile(filter, m_CurrentDir, U"MessagePackで出力");
+			if (path != none)
+			{
+				ExportData(path.value(), AnimExportFormat::MessagePack);
+			}
+		}
+
+		//チェックを入れるとv2形式で保存する。従来の形式のファイルもそのまま読み込める。
+		//v2形式とコンパクト形式は片方しか選べないので、押した方に合わせてもう片方を外す。
+		if (m_pGui->checkBox(m_bSaveFlat, U"v2形式で保存"))
+		{
+			m_bSaveCompact = false;
+		}
+
+		//チェックを入れるとパターンを差分で詰めたコンパクト形式で保存する。ファイルが一番小さくなる。
+		if (m_pGui->checkBox(m_bSaveCompact, U"コンパクト形式で保存"))
+		{
+			m_bSaveFlat = false;
 		}
+
+		//チェックを入れるとzstdで圧縮して保存する。読み込み時は自動で判別する。
+		//zstdなしでビルドした時は押せなくなるので、理由が分かるように表示にも出しておく。
+		m_pGui->checkBox(m_bSaveCompressed, AnimZstd::IsAvailable() ? U"圧縮して保存" : U"圧縮して保存(zstdなしのビルドのため無効)", AnimZstd::IsAvailable());
+
+		//チェックを入れると.txtと一緒にconstexprの配列にしたC++ヘッダー(*.hpp)も書き出す。
+		m_pGui->checkBox(m_bSaveHeader, U"C++ヘッダーも出力");
+
+		//チェックを入れると一定時間ごとに元のファイルの横へ*.autosave.animを書き出す。
+		m_pGui->checkBox(m_bAutoSave, U"自動保存");
+
+		//チェックを入れると開いている.anim、.txt、画像が外から書き換えられた時に読み込み直す。
+		//.animか.txtを読み込み直すと、保存していない変更は消える。
+		m_pGui->checkBox(m_bHotReload, U"変更を自動で読み込み直す");
+
+		//チェックを入れると上書き保存では変更分だけを*.anim.journalに追記する。.txtはジャーナルを整理した時に書き出す。
+		//C++ヘッダーはジャーナルから読めないので、出力する設定なら上書きのたびに全体を書き出す。
+		m_pGui->checkBox(m_bSaveJournal, U"上書きは変更分だけ保存(.txtは整理した時に出力)");
 	}
 
 	void GUIManager::AnimationFileDataGroup(void)
@@ -1134,6 +2282,29 @@ namespace siapp
 		m_pGui->textBox(m_TextFilePath, U"", SasaGUI::WindowFlag::NoResize, 300.0, 3, false);
 	}
 
+	void GUIManager::TextureCacheGroup(void)
+	{
+		double usedMB = static_cast<double>(m_TextureCache.TotalCost()) / (1024.0 * 1024.0);
+		uint64 hitCount  = m_TextureCache.HitCount();
+		uint64 missCount = m_TextureCache.MissCount();
+
+		m_pGui->label(U"テクスチャキャッシュ：{} 枚 {:.1f} MB"_fmt(m_TextureCache.Count(), usedMB));
+		m_pGui->newLine();
+		m_pGui->label(U"ヒット率：{:.1f}% (ヒット {} / ミス {})"_fmt(m_TextureCache.HitRate() * 100.0, hitCount, missCount));
+		m_pGui->newLine();
+
+		//予算を変えると、超えた分は使われていない順に捨てる。
+		m_pGui->label(U"予算(MB)");
+		if (m_pGui->spinBox(m_TextureCacheBudgetMB, 0, 8192, 64, 100))
+		{
+			m_TextureCache.SetBudget(static_cast<size_t>(m_TextureCacheBudgetMB) * 1024 * 1024);
+		}
+		if (m_pGui->button(U"クリア"))
+		{
+			m_TextureCache.Clear();
+		}
+	}
+
 	void GUIManager::AnimationAllFrameGroup(void)
 	{
 		m_pGui->groupBegin(U"", /*frame = */ true, /*enable = */ true);
@@ -1142,17 +2313,9 @@ namespace siapp
 			m_pGui->spinBox(m_PatternCount, 1, 30, 1, 120);
 			if (m_pGui->button(U"パターン数変更"))
 			{
-				Array<AnimationPattern> tmp = m_AnimationArray[m_SelectListNo].pattern;
-				int oldSize = static_cast<int>(tmp.size());
-				m_AnimationArray[m_SelectListNo].pattern.clear();
-				for (int i : step(m_PatternCount))
-				{
-					m_AnimationArray[m_SelectListNo].pattern << AnimationPattern();
-					if (i < oldSize)
-					{
-						m_AnimationArray[m_SelectListNo].pattern[i] = tmp[i];
-					}
-				}
+				//残るパターンはそのままにして、増えた分だけ初期状態のパターンを足す。
+				std::vector<AnimationPattern>* pPatternArray = &(m_AnimationArray[m_SelectListNo].pattern.Edit());
+				pPatternArray->resize(static_cast<size_t>(m_PatternCount));
 				m_SelectPattern = Clamp(m_SelectPattern, 0, m_PatternCount - 1);
 				m_Pattern = Clamp(m_Pattern, 0, m_PatternCount - 1);
 			}
@@ -1165,7 +2328,7 @@ namespace siapp
 			if (m_pGui->button(U"フレーム一括変更"))
 			{
 				//編集中のアニメーションパターン配列を参照
-				Array<AnimationPattern>* pSelectPatternArray = &(m_AnimationArray[m_SelectListNo].pattern);
+				std::vector<AnimationPattern>* pSelectPatternArray = &(m_AnimationArray[m_SelectListNo].pattern.Edit());
 				for (auto i : step(pSelectPatternArray->size()))
 				{
 					(*pSelectPatternArray)[i].wait = m_AllFrame;
@@ -1178,7 +2341,7 @@ namespace siapp
 			{
 				for (size_t i : step(m_AnimationArray[m_SelectListNo].pattern.size()))
 				{
-					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern[i]);
+					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern.Edit()[i]);
 					pPattern->no = i;
 				}
 			}
@@ -1187,7 +2350,7 @@ namespace siapp
 			{
 				for (size_t i : step(m_AnimationArray[m_SelectListNo].pattern.size()))
 				{
-					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern[i]);
+					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern.Edit()[i]);
 					pPattern->no = 0;
 				}
 			}
@@ -1198,7 +2361,7 @@ namespace siapp
 			{
 				for (size_t i : step(m_AnimationArray[m_SelectListNo].pattern.size()))
 				{
-					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern[i]);
+					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern.Edit()[i]);
 					pPattern->step = i;
 				}
 			}
@@ -1207,7 +2370,7 @@ namespace siapp
 			{
 				for (size_t i : step(m_AnimationArray[m_SelectListNo].pattern.size()))
 				{
-					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern[i]);
+					AnimationPattern* pPattern = &(m_AnimationArray[m_SelectListNo].pattern.Edit()[i]);
 					pPattern->step = 0;
 				}
 			}
@@ -1219,12 +2382,15 @@ namespace siapp
 	{
 		m_pGui->windowBegin(U"アニメーションリスト", SasaGUI::WindowFlag::NoMove | SasaGUI::WindowFlag::NoResize, Size(animListWindowWidth, animListWindowHeight), Vec2(windowWidth - animListWindowWidth, 0));
 		{
-			for (auto i : step(m_AnimNameArray.size()))
+			for (auto i : step(m_AnimNameIndex.Count()))
 			{
-				if (m_pGui->button(m_AnimNameArray[i]))
+				if (m_pGui->button(m_AnimNameIndex.Name(i)))
 				{
+					//選ばれた時に初めてアニメーションの中身を読み込む。
+					LoadLazyAnimation(i);
+
 					m_SelectListNo = static_cast<uint16>(i);
-					m_AnimationName = m_AnimNameArray[m_SelectListNo];
+					m_AnimationName = m_AnimNameIndex.Name(m_SelectListNo);
 					
 					//アニメーションパターン参照でエラーを回避するためリセットしておく。
 					ResetAnimTimer();
@@ -1234,28 +2400,66 @@ namespace siapp
 		}
 		m_pGui->windowEnd();
 	}
+	void GUIManager::AnimationFileListWindow(void)
+	{
+		m_pGui->windowBegin(U"開いたファイル", SasaGUI::WindowFlag::AlwaysForeground, Size(240, 320), Vec2(animDataWindowWidth + 10, 10));
+		{
+			//読み込みが終わるまでは進み具合を表示する。
+			if (m_LoadDoneCount < m_FileArray.size())
+			{
+				m_pGui->label(Format(m_LoadDoneCount) + U" / " + Format(m_FileArray.size()) + U" 読み込み中");
+				m_pGui->newLine();
+				m_pGui->progressBar(m_LoadDoneCount, static_cast<size_t>(0), m_FileArray.size(), 200.0);
+				m_pGui->newLine();
+			}
+
+			for (auto i : step(m_FileArray.size()))
+			{
+				const AnimationFileEntry* pEntry = &(m_FileArray[i]);
+				String name = FileSystem::FileName(pEntry->animPath);
+
+				switch (pEntry->state)
+				{
+				case AnimationFileState::Loading:
+					m_pGui->label(U"… " + name);
+					break;
+				case AnimationFileState::Failed:
+					m_pGui->label(U"× " + name);
+					break;
+				case AnimationFileState::Loaded:
+					if (m_pGui->button((m_SelectFileNo == i ? U"▶ " : U"") + name))
+					{
+						OpenFileEntry(i);
+					}
+					break;
+				}
+				m_pGui->newLine();
+			}
+		}
+		m_pGui->windowEnd();
+	}
+
 	RectF GUIManager::GetSrcRect(void)
 	{
-		AnimationInfo* pAnim = &(m_AnimationArray[m_SelectListNo]);
-		AnimationPattern* pPattern = &(pAnim->pattern[m_Pattern]);
-		RectF animSrcRect(
-			pAnim->offsetX + pPattern->no * pAnim->width,
-			pAnim->offsetY + pPattern->step * pAnim->height,
-			pAnim->width,
-			pAnim->height
-		);
-		return animSrcRect;
+		return GetFrameRect(m_Pattern);
 	}
 	RectF GUIManager::GetPtnRect(void)
 	{
-		AnimationInfo* pAnim = &(m_AnimationArray[m_SelectListNo]);
-		AnimationPattern* pPattern = &(pAnim->pattern[m_SelectPattern]);
-		RectF animSrcRect(
-			pAnim->offsetX + pPattern->no * pAnim->width,
-			pAnim->offsetY + pPattern->step * pAnim->height,
-			pAnim->width,
-			pAnim->height
-		);
-		return animSrcRect;
+		return GetFrameRect(m_SelectPattern);
+	}
+	RectF GUIManager::GetFrameRect(int pattern)
+	{
+		//切り出し矩形は矩形かパターンか画像が変わった時だけ計算し直す。(AnimationFrameTable)
+		const AnimationInfo* pAnim = &(m_AnimationArray[m_SelectListNo]);
+		const std::vector<AnimationFrameRect>& rects = pAnim->FrameRects(m_Texture.width(), m_Texture.height());
+
+		//パターンがない時や範囲外の番号は、最初のコマ(no=0,step=0)の位置を返す。
+		if (pattern < 0 || static_cast<size_t>(pattern) >= rects.size())
+		{
+			return RectF(pAnim->offsetX, pAnim->offsetY, pAnim->width, pAnim->height);
+		}
+
+		const AnimationFrameRect* pFrame = &rects[static_cast<size_t>(pattern)];
+		return RectF(pFrame->srcX, pFrame->srcY, pFrame->srcW, pFrame->srcH);
 	}
 }
\ No newline at end of file
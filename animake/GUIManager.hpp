@@ -1,6 +1,18 @@
-#pragma once
+﻿#pragma once
 #include <Siv3D.hpp>
 #include "Define.hpp"
+#include "AnimAutoSave.hpp"
+#include "AnimationModel.hpp"
+#include "AnimExport.hpp"
+#include "AnimHeader.hpp"
+#include "AnimIndex.hpp"
+#include "AnimJournal.hpp"
+#include "AnimNameIndex.hpp"
+#include "AnimText.hpp"
+#include "AtomicFile.hpp"
+#include "AnimZstd.hpp"
+#include "LruCache.hpp"
+#include "ThreadPool.hpp"
 
 namespace s3d
 {
@@ -12,85 +24,70 @@ namespace s3d
 
 namespace siapp 
 {
-	struct AnimationPattern
+	//自動保存の写しに使うアニメーション1つ分のデータ。変更がなければ前回の写しと共有する。
+	struct AnimationSnapshotCache
 	{
-		double                       wait    = 1.0;
-		int                          no      = 0;
-		int                          step    = 0;
-
-		AnimationPattern(void) :
-			wait(1.0),
-			no(0),
-			step(0)
-		{
-		}
-
-		AnimationPattern(const AnimationPattern& obj)
-		{
-			wait = obj.wait;
-			no   = obj.no;
-			step = obj.step;
-		}
-
-		void operator= (const AnimationPattern& obj)
-		{
-			wait = obj.wait;
-			no   = obj.no;
-			step = obj.step;
-		}
+		String                       name;
+		std::shared_ptr<const AnimInfoData> pData;
 	};
 
-	struct AnimationInfo
+	//キャッシュに入れるテクスチャ。ミップマップは縮小して表示した時に初めて作る。(GUIManager::RequestTextureMips)
+	struct CachedTexture
 	{
-		double                       offsetX = 0.0;
-		double                       offsetY = 0.0;
-		double                       width   = 0.0;
-		double                       height  = 0.0;
-		bool                         bLoop   = false;
-		Array<AnimationPattern>      pattern;
-
-		AnimationInfo(void) :
-			offsetX(0.0),
-			offsetY(0.0),
-			width(0.0),
-			height(0.0),
-			bLoop(false)
-		{
-			for (int i : step(30))
-			{
-				pattern << AnimationPattern();
-			}
-		}
-		
-		AnimationInfo(const AnimationInfo& obj)
-		{
-			offsetX = obj.offsetX;
-			offsetY = obj.offsetY;
-			width   = obj.width;
-			height  = obj.height;
-			bLoop   = obj.bLoop;
-			pattern.clear();
-			for (size_t i : step(obj.pattern.size()))
-			{
-				pattern << AnimationPattern();
-				pattern[i] = obj.pattern[i];
-			}
-		}
-
-		void operator= (const AnimationInfo& obj)
-		{
-			offsetX = obj.offsetX;
-			offsetY = obj.offsetY;
-			width   = obj.width;
-			height  = obj.height;
-			bLoop   = obj.bLoop;
-			pattern.clear();
-			for (size_t i : step(obj.pattern.size()))
-			{
-				pattern << AnimationPattern();
-				pattern[i] = obj.pattern[i];
-			}
-		}
+		Texture                      texture;
+		bool                         bMipped     = false;
+	};
+
+	//まとめて開いたファイルの状態。
+	enum class AnimationFileState
+	{
+		Loading,
+		Loaded,
+		Failed,
+	};
+
+	//まとめて開いたファイル1つ分。選ばれた時にここから編集中のデータを作り直す。
+	struct AnimationFileEntry
+	{
+		FilePath                     animPath;
+		AnimationFileState           state       = AnimationFileState::Loading;
+		AnimDocument                 doc;
+		AnimFormat                   format      = AnimFormat::Legacy;
+		AnimCompression              compression = AnimCompression::None;
+		FilePath                     texturePath;
+		FileStamp                    textureStamp;
+		CachedTexture                texture;
+	};
+
+	//ワーカースレッドで読み込んだ結果。画像はデコードまで済ませ、テクスチャはメインスレッドで作る。
+	struct AnimationFileLoadResult
+	{
+		uint32                       batch       = 0;
+		size_t                       index       = 0;
+		bool                         bSuccess    = false;
+		AnimDocument                 doc;
+		AnimFormat                   format      = AnimFormat::Legacy;
+		AnimCompression              compression = AnimCompression::None;
+		FilePath                     texturePath;
+		FileStamp                    textureStamp;
+		Image                        image;        //キャッシュに入っていた場合はデコードしないので空になる
+	};
+
+	//ワーカースレッドでデコードした画像。ミップマップが要る場合は作ってあるので、メインスレッドでは転送するだけでよい。
+	struct TextureLoadResult
+	{
+		uint32                       request     = 0;
+		FileStamp                    stamp;
+		Image                        image;
+		Array<Image>                 mips;         //ミップマップを作らない場合は空
+	};
+
+	//外から書き換えられたら読み込み直すファイル。
+	struct WatchedFile
+	{
+		FilePath                     path;                 //フルパス。空なら監視しない
+		FileStamp                    stamp;                //最後に読み込んだか書き出した時の更新日時
+		double                       changedTime = -1.0;   //最後に変更の通知を受け取った時間。負なら通知なし
 	};
 
 	class GUIManager
@@ -99,7 +96,7 @@ namespace siapp
 		SasaGUI::GUIManager*         m_pGui;
 		uint16                       m_SelectListNo;
 		Array<AnimationInfo>         m_AnimationArray;
-		Array<String>                m_AnimNameArray;
+		BasicAnimNameIndex<String>   m_AnimNameIndex;    //m_AnimationArrayと同じ並びの名前と、名前からの索引
 		String                       m_AnimationName;
 		int                          m_SelectPattern;
 		double                       m_AllFrame;
@@ -109,6 +106,10 @@ namespace siapp
 		FilePath                     m_TextFilePath;
 		bool                         m_bDeleteAssert;
 		Texture                      m_Texture;
+		Texture                      m_PlaceholderTexture;
+		FileStamp                    m_TextureStamp;
+		bool                         m_bTextureMipped;
+		bool                         m_bMipRequested;
 		double                       m_TexScale;
 		double                       m_AnimScale;
 		double                       m_EditScale;
@@ -128,6 +129,52 @@ namespace siapp
 		bool                         m_bGrid;
 		int                          m_GridScale;
 
+		bool                         m_bSaveFlat;
+		bool                         m_bSaveCompact;
+		bool                         m_bSaveCompressed;
+		bool                         m_bSaveHeader;
+
+		std::shared_ptr<AnimIndex>   m_pAnimIndex;       //自動保存の写しと共有する
+		Array<int>                   m_LazyIndexArray;
+
+		//読み込んだパターンの並びをハッシュから引く表。同じ並びのアニメーションで配列を共有する。
+		HashTable<uint64, std::weak_ptr<std::vector<AnimationPattern>>> m_PatternTable;
+
+		AnimAutoSave                 m_AutoSave;
+		bool                         m_bAutoSave;
+		bool                         m_bSnapshotDirty;
+		double                       m_AutoSaveTime;
+		Array<AnimationSnapshotCache> m_SnapshotArray;
+
+		bool                         m_bSaveJournal;
+		uint64                       m_JournalSize;
+		uint64                       m_JournalBaseSize;
+		size_t                       m_JournalCount;
+		String                       m_JournalTexturePath;
+		Array<uint32>                m_JournalRemoveArray;
+		Array<AnimationSnapshotCache> m_JournalArray;
+
+		//ファイルや画像の読み込みに使うスレッドプール。初めて使う時に作る。(LoadPool)
+		ThreadPool*                  m_pLoadPool;
+		ResultQueue<TextureLoadResult> m_TextureQueue;
+		std::atomic<uint32>          m_TextureRequest;
+
+		//パスと更新日時が同じ画像はデコードし直さずに使い回す。ファイルを開き直した時や切り替えた時に効く。
+		LruCache<FileStamp, CachedTexture, FileStampHash> m_TextureCache;
+		int                          m_TextureCacheBudgetMB;
+		ResultQueue<AnimationFileLoadResult> m_LoadQueue;
+		std::atomic<uint32>          m_LoadBatch;
+		Array<AnimationFileEntry>    m_FileArray;
+		size_t                       m_LoadDoneCount;
+		Optional<size_t>             m_SelectFileNo;
+		bool                         m_bFileListWindow;
+
+		bool                         m_bHotReload;
+		HashTable<FilePath, DirectoryWatcher> m_DirectoryWatchers;
+		WatchedFile                  m_WatchAnim;
+		WatchedFile                  m_WatchTexture;
+		WatchedFile                  m_WatchText;
+
 		HSV                          m_Color;
 	public:
 		GUIManager(void);
@@ -137,11 +184,49 @@ namespace siapp
 	private:
 		void AnimationAddTimer(const double& s);
 		void ResetAnimTimer(void);
+		ThreadPool* LoadPool(void);
+		static void DecodeTexture(const FilePath& path, bool bMipped, Image& outImage, Array<Image>& outMips);
+		CachedTexture CreateCachedTexture(const FileStamp& stamp, const Image& image, const Array<Image>& mips);
+		void SetTexture(const CachedTexture& texture, const FileStamp& stamp);
 		void LoadTexture(const FilePath& path);
+		void RequestTextureMips(void);
+		void UpdateLoadTexture(void);
+		bool IsTextureLoading(void) const;
+		void LoadAnimTexture(const FilePath& animPath, const std::string& textureName);
 		double RectScale(const Vec2& rectSize, const Vec2& drawSize);
 
 		void LoadData(const FilePath& path);
 		void SaveData(const FilePath& path);
+		void ExportData(const FilePath& path, AnimExportFormat format);
+		void SaveHeader(void);
+		bool IsTextNewer(const FilePath& txtPath, const FilePath& animPath);
+		void LoadTextDocument(const FilePath& txtPath, const FilePath& animPath, AnimDocument& doc);
+		void ApplyDocument(const FilePath& txtPath, const FilePath& animPath, AnimDocument& doc);
+		void LoadFiles(const Array<FilePath>& paths);
+		void UpdateLoadFiles(void);
+		void OpenFileEntry(size_t index);
+
+		void UpdateHotReload(void);
+		bool SyncWatchedFile(WatchedFile& file, const FilePath& path);
+		bool IsWatchedFileChanged(WatchedFile& file, double time);
+		void RefreshWatchStamps(void);
+		void ReloadDocument(const FilePath& path);
+		void LoadLazyAnimation(size_t index);
+		void ApplyAnimData(size_t index, const AnimInfoData& data);
+		AnimationPatternArray InternPatternArray(const std::vector<AnimPatternData>& pattern);
+		void LoadAllAnimations(void);
+		void MakeDocument(const FilePath& txtPath, AnimDocument& outDoc);
+		void MakeAnimDataFromIndex(size_t index, AnimInfoData& outData);
+		void MakeAnimData(size_t index, AnimInfoData& outData);
+		bool IsSameAnimData(size_t index, const AnimInfoData& data);
+		AnimFormat SaveFormat(void) const;
+
+		void AutoSave(void);
+		bool MakeSnapshot(AnimSnapshot& outSnapshot);
+
+		void LoadJournal(void);
+		bool SaveJournal(void);
+		void ResetJournal(const std::vector<uint8_t>& animBuffer, AnimDocument& doc);
 
 		void AnimationViewWindow(void);
 
@@ -164,12 +249,15 @@ namespace siapp
 		void AnimationFileGroup(void);
 		void AnimationSaveBtnGroup(void);
 		void AnimationFileDataGroup(void);
+		void TextureCacheGroup(void);
 		void AnimationAllFrameGroup(void);
 
 		void AnimationListWindow(void);
+		void AnimationFileListWindow(void);
 
 		RectF GetSrcRect(void);
 		RectF GetPtnRect(void);
+		RectF GetFrameRect(int pattern);
 	};
 }
 
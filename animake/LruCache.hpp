@@ -0,0 +1,192 @@
+﻿#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//使った順に並べ、合計の大きさが予算を超えたら一番古いものから捨てるキャッシュ。Siv3Dには依存しない。
+
+namespace siapp
+{
+	//ファイルのパスと更新日時の組。ファイルが書き換えられると別のキーになる。
+	struct FileStamp
+	{
+		std::wstring                 path;
+		int64_t                      writeTime  = 0;
+
+		//絶対パスに直し、更新日時を調べて作る。ファイルがなければwriteTimeは0になる。
+		static FileStamp Make(const std::filesystem::path& path)
+		{
+			std::error_code ec;
+			FileStamp stamp;
+			stamp.path = std::filesystem::absolute(path, ec).lexically_normal().wstring();
+
+			std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, ec);
+			stamp.writeTime = ec ? 0 : static_cast<int64_t>(writeTime.time_since_epoch().count());
+			return stamp;
+		}
+
+		bool operator== (const FileStamp& obj) const
+		{
+			return writeTime == obj.writeTime && path == obj.path;
+		}
+	};
+
+	struct FileStampHash
+	{
+		size_t operator() (const FileStamp& stamp) const
+		{
+			return std::hash<std::wstring>()(stamp.path) ^ (std::hash<int64_t>()(stamp.writeTime) * 0x9e3779b97f4a7c15ull);
+		}
+	};
+
+	//値ごとに呼び出し側で決めた大きさ(バイト数など)を持ち、合計がbudgetを超えないようにする。
+	//ワーカースレッドからも調べられるように、操作は全てロックして行う。
+	template<class Key, class Value, class Hash = std::hash<Key>>
+	class LruCache
+	{
+	private:
+		struct Node
+		{
+			Key                      key;
+			Value                    value;
+			size_t                   cost;
+		};
+
+		std::list<Node>                                                m_List;   //先頭が一番最近使ったもの
+		std::unordered_map<Key, typename std::list<Node>::iterator, Hash> m_Map;
+		size_t                                                         m_Budget;
+		size_t                                                         m_TotalCost;
+		uint64_t                                                       m_HitCount;
+		uint64_t                                                       m_MissCount;
+		mutable std::mutex                                             m_Mutex;
+	public:
+		explicit LruCache(size_t budget) :
+			m_List(),
+			m_Map(),
+			m_Budget(budget),
+			m_TotalCost(0),
+			m_HitCount(0),
+			m_MissCount(0),
+			m_Mutex()
+		{
+		}
+
+		LruCache(const LruCache&) = delete;
+		LruCache& operator= (const LruCache&) = delete;
+
+		//見つかれば一番最近使ったものにしてtrueを返す。ヒット率に数える。
+		bool Find(const Key& key, Value& outValue)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto it = m_Map.find(key);
+			if (it == m_Map.end())
+			{
+				++m_MissCount;
+				return false;
+			}
+
+			m_List.splice(m_List.begin(), m_List, it->second);
+			outValue = it->second->value;
+			++m_HitCount;
+			return true;
+		}
+
+		//入っているかだけを調べる。並び順もヒット率も変えない。
+		bool Contains(const Key& key) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Map.find(key) != m_Map.end();
+		}
+
+		//値を入れて一番最近使ったものにする。予算に収まるまで古いものから捨てる。
+		//1つで予算を超えるものは入れない。
+		void Insert(const Key& key, const Value& value, size_t cost)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto it = m_Map.find(key);
+			if (it != m_Map.end())
+			{
+				m_TotalCost -= it->second->cost;
+				m_List.erase(it->second);
+				m_Map.erase(it);
+			}
+
+			if (cost > m_Budget)
+			{
+				return;
+			}
+
+			m_List.push_front(Node{ key, value, cost });
+			m_Map.emplace(key, m_List.begin());
+			m_TotalCost += cost;
+			Evict();
+		}
+
+		void SetBudget(size_t budget)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Budget = budget;
+			Evict();
+		}
+
+		void Clear(void)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_List.clear();
+			m_Map.clear();
+			m_TotalCost = 0;
+		}
+
+		size_t Budget(void) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Budget;
+		}
+
+		size_t TotalCost(void) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_TotalCost;
+		}
+
+		size_t Count(void) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Map.size();
+		}
+
+		uint64_t HitCount(void) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_HitCount;
+		}
+
+		uint64_t MissCount(void) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_MissCount;
+		}
+
+		//Findが見つけた割合。まだ一度も探していなければ0を返す。
+		double HitRate(void) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			uint64_t total = m_HitCount + m_MissCount;
+			return total == 0 ? 0.0 : static_cast<double>(m_HitCount) / static_cast<double>(total);
+		}
+	private:
+		void Evict(void)
+		{
+			while (m_TotalCost > m_Budget && !m_List.empty())
+			{
+				Node& node = m_List.back();
+				m_TotalCost -= node.cost;
+				m_Map.erase(node.key);
+				m_List.pop_back();
+			}
+		}
+	};
+}
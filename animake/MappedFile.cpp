@@ -0,0 +1,147 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace siapp
+{
+	MappedFile::MappedFile(void) :
+		m_pData(nullptr),
+		m_Size(0),
+#ifdef _WIN32
+		m_hFile(INVALID_HANDLE_VALUE),
+		m_hMapping(nullptr)
+#else
+		m_Fd(-1)
+#endif
+	{
+	}
+
+	MappedFile::~MappedFile(void)
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		m_hFile = hFile;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0)
+		{
+			Close();
+			return false;
+		}
+
+		HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (hMapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+		m_hMapping = hMapping;
+
+		void* p = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (p == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		m_pData = static_cast<const uint8_t*>(p);
+		m_Size  = static_cast<size_t>(size.QuadPart);
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		m_Fd = fd;
+
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			Close();
+			return false;
+		}
+
+		void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+
+		m_pData = static_cast<const uint8_t*>(p);
+		m_Size  = static_cast<size_t>(st.st_size);
+#endif
+		return true;
+	}
+
+	void MappedFile::Close(void)
+	{
+#ifdef _WIN32
+		if (m_pData)
+		{
+			UnmapViewOfFile(m_pData);
+		}
+		if (m_hMapping)
+		{
+			CloseHandle(m_hMapping);
+		}
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+		}
+		m_hMapping = nullptr;
+		m_hFile    = INVALID_HANDLE_VALUE;
+#else
+		if (m_pData)
+		{
+			::munmap(const_cast<uint8_t*>(m_pData), m_Size);
+		}
+		if (m_Fd >= 0)
+		{
+			::close(m_Fd);
+		}
+		m_Fd = -1;
+#endif
+		m_pData = nullptr;
+		m_Size  = 0;
+	}
+
+	bool MappedFile::IsOpen(void) const
+	{
+		return m_pData != nullptr;
+	}
+
+	const uint8_t* MappedFile::Data(void) const
+	{
+		return m_pData;
+	}
+
+	size_t MappedFile::Size(void) const
+	{
+		return m_Size;
+	}
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace siapp
+{
+	//ファイルを読み込み専用でメモリにマップする。Siv3Dには依存しない。
+	class MappedFile
+	{
+	private:
+		const uint8_t*               m_pData;
+		size_t                       m_Size;
+#ifdef _WIN32
+		void*                        m_hFile;
+		void*                        m_hMapping;
+#else
+		int                          m_Fd;
+#endif
+	public:
+		MappedFile(void);
+		~MappedFile(void);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator= (const MappedFile&) = delete;
+
+		//ファイルをマップする。空のファイルや開けないファイルはfalseを返す。
+		bool Open(const std::filesystem::path& path);
+		void Close(void);
+
+		bool IsOpen(void) const;
+		const uint8_t* Data(void) const;
+		size_t Size(void) const;
+	};
+}
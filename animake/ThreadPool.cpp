@@ -0,0 +1,101 @@
+﻿#include "ThreadPool.hpp"
+
+namespace siapp
+{
+	ThreadPool::ThreadPool(size_t threadCount) :
+		m_Threads(),
+		m_Queue(),
+		m_Mutex(),
+		m_WorkCondition(),
+		m_DoneCondition(),
+		m_RunningCount(0),
+		m_bQuit(false)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = HardwareThreadCount();
+		}
+
+		m_Threads.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			m_Threads.emplace_back([this]() { Run(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool(void)
+	{
+		//積まれている作業は全て終わらせてから止める。
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_bQuit = true;
+		}
+		m_WorkCondition.notify_all();
+
+		for (std::thread& thread : m_Threads)
+		{
+			thread.join();
+		}
+	}
+
+	void ThreadPool::Push(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.push_back(std::move(task));
+		}
+		m_WorkCondition.notify_one();
+	}
+
+	void ThreadPool::Wait(void)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_DoneCondition.wait(lock, [this]() { return m_Queue.empty() && m_RunningCount == 0; });
+	}
+
+	size_t ThreadPool::PendingCount(void)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Queue.size() + m_RunningCount;
+	}
+
+	size_t ThreadPool::ThreadCount(void) const
+	{
+		return m_Threads.size();
+	}
+
+	size_t ThreadPool::HardwareThreadCount(void)
+	{
+		unsigned int count = std::thread::hardware_concurrency();
+		return count != 0 ? count : 1;
+	}
+
+	void ThreadPool::Run(void)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		for (;;)
+		{
+			m_WorkCondition.wait(lock, [this]() { return m_bQuit || !m_Queue.empty(); });
+
+			if (m_Queue.empty())
+			{
+				break;
+			}
+
+			std::function<void()> task = std::move(m_Queue.front());
+			m_Queue.pop_front();
+			m_RunningCount++;
+
+			lock.unlock();
+			task();
+			lock.lock();
+
+			m_RunningCount--;
+			if (m_Queue.empty() && m_RunningCount == 0)
+			{
+				m_DoneCondition.notify_all();
+			}
+		}
+	}
+}
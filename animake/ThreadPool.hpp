@@ -0,0 +1,89 @@
+﻿#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//作業キューを共有するスレッドプール。Siv3Dには依存しない。
+
+namespace siapp
+{
+	//積んだ作業を空いているスレッドが順番に取り出して実行する。
+	//作業の中で例外を投げないこと。
+	class ThreadPool
+	{
+	private:
+		std::vector<std::thread>             m_Threads;
+		std::deque<std::function<void()>>    m_Queue;
+		std::mutex                           m_Mutex;
+		std::condition_variable              m_WorkCondition;
+		std::condition_variable              m_DoneCondition;
+		size_t                               m_RunningCount;
+		bool                                 m_bQuit;
+	public:
+		//threadCountが0ならCPUのコア数だけスレッドを作る。
+		explicit ThreadPool(size_t threadCount = 0);
+		~ThreadPool(void);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator= (const ThreadPool&) = delete;
+
+		//作業を積む。すぐに戻る。
+		void Push(std::function<void()> task);
+
+		//積んだ作業が全て終わるまで待つ。
+		void Wait(void);
+
+		//実行中か待っている作業の数。
+		size_t PendingCount(void);
+
+		size_t ThreadCount(void) const;
+
+		//CPUのコア数。取得できなければ1を返す。
+		static size_t HardwareThreadCount(void);
+	private:
+		void Run(void);
+	};
+
+	//ワーカースレッドで作った結果を、メインスレッドが好きな時に取り出せるように溜めておくキュー。
+	//結果は終わった順に並ぶ。
+	template<class T>
+	class ResultQueue
+	{
+	private:
+		std::deque<T>                        m_Queue;
+		std::mutex                           m_Mutex;
+	public:
+		ResultQueue(void) = default;
+		ResultQueue(const ResultQueue&) = delete;
+		ResultQueue& operator= (const ResultQueue&) = delete;
+
+		//結果を積む。ワーカースレッドから呼ぶ。
+		void Push(T&& result)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.push_back(std::move(result));
+		}
+
+		//一番古い結果を取り出す。なければfalseを返してすぐに戻る。
+		bool TryPop(T& outResult)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Queue.empty())
+			{
+				return false;
+			}
+			outResult = std::move(m_Queue.front());
+			m_Queue.pop_front();
+			return true;
+		}
+
+		void Clear(void)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.clear();
+		}
+	};
+}
@@ -0,0 +1,252 @@
+﻿//AnimCodecの読み込み速度を測るベンチマーク。Siv3Dなしでビルドできる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimCodecBench.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AtomicFile.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/MappedFile.cpp -o AnimCodecBench
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimCodecBench [.animファイル or ディレクトリ ...] [-n 繰り返し回数]
+//    引数がなければ ../animake/App/Resource と生成した大きめのデータで計測する。
+
+#include "AnimCodec.hpp"
+#include "AnimV2.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	using bench::Clock;
+
+	struct BenchInput
+	{
+		std::filesystem::path        path;
+		std::vector<uint8_t>         bytes;
+	};
+
+	//以前のGUIManager::LoadDataと同じく、項目ごとにreadしてnew char[]で名前を受け取る読み込み。比較用。
+	bool LoadFieldByField(const std::filesystem::path& path, AnimDocument& outDoc)
+	{
+		std::ifstream ifs(path, std::ios::binary);
+		if (!ifs)
+		{
+			return false;
+		}
+
+		auto readString = [&ifs](std::string& out)
+		{
+			int32_t length = 0;
+			ifs.read(reinterpret_cast<char*>(&length), sizeof(int32_t));
+			if (!ifs || length < 0)
+			{
+				return false;
+			}
+			char* str = new char[length + 1];
+			ifs.read(str, length);
+			str[length] = '\0';
+			out = str;
+			delete[] str;
+			return static_cast<bool>(ifs);
+		};
+
+		outDoc.animations.clear();
+		if (!readString(outDoc.textureName))
+		{
+			return false;
+		}
+
+		int32_t animCount = 0;
+		ifs.read(reinterpret_cast<char*>(&animCount), sizeof(int32_t));
+		if (!ifs || animCount < 0)
+		{
+			return false;
+		}
+
+		for (int32_t i = 0; i < animCount; ++i)
+		{
+			outDoc.animations.emplace_back();
+			AnimInfoData& info = outDoc.animations.back();
+			if (!readString(info.name))
+			{
+				return false;
+			}
+			char loop = 0;
+			int32_t patternCount = 0;
+			ifs.read(reinterpret_cast<char*>(&info.offsetX), sizeof(float));
+			ifs.read(reinterpret_cast<char*>(&info.offsetY), sizeof(float));
+			ifs.read(reinterpret_cast<char*>(&info.width)  , sizeof(float));
+			ifs.read(reinterpret_cast<char*>(&info.height) , sizeof(float));
+			ifs.read(&loop, sizeof(char));
+			ifs.read(reinterpret_cast<char*>(&patternCount), sizeof(int32_t));
+			if (!ifs || patternCount < 0)
+			{
+				return false;
+			}
+			info.bLoop = loop != 0;
+			for (int32_t j = 0; j < patternCount; ++j)
+			{
+				info.pattern.emplace_back();
+				AnimPatternData& ptn = info.pattern.back();
+				ifs.read(reinterpret_cast<char*>(&ptn.wait), sizeof(float));
+				ifs.read(reinterpret_cast<char*>(&ptn.no)  , sizeof(int32_t));
+				ifs.read(reinterpret_cast<char*>(&ptn.step), sizeof(int32_t));
+			}
+		}
+		return readString(outDoc.textName);
+	}
+
+	void PrintResult(const char* label, size_t fileCount, size_t totalBytes, double seconds)
+	{
+		double mb = static_cast<double>(totalBytes) / (1024.0 * 1024.0);
+		std::printf("%-28s %8zu files %10.2f MB %9.3f s %10.1f MB/s %12.0f files/s\n",
+			label, fileCount, mb, seconds, seconds > 0.0 ? mb / seconds : 0.0, seconds > 0.0 ? fileCount / seconds : 0.0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 200;
+	std::vector<std::filesystem::path> files;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			bench::CollectFiles(argv[i], files);
+		}
+	}
+
+	std::filesystem::path tempDir = std::filesystem::temp_directory_path();
+
+	if (files.empty())
+	{
+		bench::CollectFiles("../animake/App/Resource", files);
+
+		//大きなファイルも生成して計測対象に入れる。
+		std::filesystem::path largePath = tempDir / "AnimCodecBench_large.anim";
+		if (AnimCodec::Save(largePath, bench::MakeSyntheticDocument(500, 30)))
+		{
+			files.push_back(largePath);
+		}
+	}
+
+	//デコードできないファイルは除外しておく。
+	std::vector<BenchInput> inputs;
+	for (const auto& path : files)
+	{
+		BenchInput input;
+		AnimDocument doc;
+		if (AnimCodec::ReadFile(path, input.bytes) && AnimCodec::Decode(input.bytes.data(), input.bytes.size(), doc))
+		{
+			input.path = path;
+			inputs.push_back(std::move(input));
+		}
+	}
+
+	if (inputs.empty())
+	{
+		std::fprintf(stderr, "no decodable .anim files\n");
+		return 1;
+	}
+
+	std::vector<std::filesystem::path> validFiles;
+	size_t totalBytes = 0;
+	for (const BenchInput& input : inputs)
+	{
+		validFiles.push_back(input.path);
+		totalBytes += input.bytes.size();
+	}
+
+	std::printf("%zu files, %zu bytes per pass, %d passes\n", inputs.size(), totalBytes, iterations);
+
+	AnimDocument doc;
+	size_t checksum = 0;
+
+	//メモリ上のバッファからのデコードのみ。
+	{
+		auto begin = Clock::now();
+		for (int n = 0; n < iterations; ++n)
+		{
+			for (const BenchInput& input : inputs)
+			{
+				AnimCodec::Decode(input.bytes.data(), input.bytes.size(), doc);
+				checksum += doc.animations.size();
+			}
+		}
+		double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+		PrintResult("Decode (in memory)", inputs.size() * iterations, totalBytes * iterations, sec);
+	}
+
+	//ファイルを一度に読み込んでデコード。
+	{
+		auto begin = Clock::now();
+		for (int n = 0; n < iterations; ++n)
+		{
+			for (const auto& path : validFiles)
+			{
+				AnimCodec::Load(path, doc);
+				checksum += doc.animations.size();
+			}
+		}
+		double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+		PrintResult("Load (bulk read)", validFiles.size() * iterations, totalBytes * iterations, sec);
+	}
+
+	//以前の項目ごとの読み込み。
+	{
+		auto begin = Clock::now();
+		for (int n = 0; n < iterations; ++n)
+		{
+			for (const auto& path : validFiles)
+			{
+				LoadFieldByField(path, doc);
+				checksum += doc.animations.size();
+			}
+		}
+		double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+		PrintResult("Load (field by field)", validFiles.size() * iterations, totalBytes * iterations, sec);
+	}
+
+	//v2形式に変換したものをコピーせずに参照する。
+	{
+		std::vector<std::vector<uint8_t>> flatInputs(inputs.size());
+		size_t flatBytes = 0;
+		for (size_t i = 0; i < inputs.size(); ++i)
+		{
+			AnimCodec::Decode(inputs[i].bytes.data(), inputs[i].bytes.size(), doc);
+			AnimCodec::Encode(doc, flatInputs[i], AnimFormat::Flat);
+			flatBytes += flatInputs[i].size();
+		}
+
+		auto begin = Clock::now();
+		for (int n = 0; n < iterations; ++n)
+		{
+			for (const std::vector<uint8_t>& bytes : flatInputs)
+			{
+				AnimV2View view;
+				view.Open(bytes.data(), bytes.size());
+				for (uint32_t i = 0; i < view.AnimCount(); ++i)
+				{
+					checksum += view.PatternCount(i) + view.Name(i).size();
+				}
+			}
+		}
+		double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+		PrintResult("V2 view (in place)", flatInputs.size() * iterations, flatBytes * iterations, sec);
+	}
+
+	std::printf("checksum %zu\n", checksum);
+	return 0;
+}
@@ -0,0 +1,183 @@
+﻿//コンパクト形式と従来の形式・v2形式のサイズとデコード速度を比べるベンチマーク。Siv3Dなしでビルドできる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimCompactBench.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AtomicFile.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/MappedFile.cpp -o AnimCompactBench
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimCompactBench [.animファイル or ディレクトリ ...] [-n 繰り返し回数]
+//    引数がなければ ../animake/App/Resource のサンプルと生成した大きめのデータで計測する。
+//    形式ごとにエンコードしたサイズ、従来の形式に対する割合、メモリ上からのデコード時間を表示し、
+//    デコードした結果が元のデータと一致しなければ終了コード1を返す。
+
+#include "AnimCodec.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	struct Variant
+	{
+		const char*                  label;
+		AnimFormat                   format;
+	};
+
+	constexpr Variant variants[] =
+	{
+		{ "legacy" , AnimFormat::Legacy  },
+		{ "v2"     , AnimFormat::Flat    },
+		{ "compact", AnimFormat::Compact },
+	};
+
+	//よくあるキャラクターのデータ。noは連番で、waitとstepはほとんど変わらない。最後のフレームだけ長めに止める。
+	AnimDocument MakeSyntheticDocument(int animCount, int patternCount)
+	{
+		AnimDocument doc = bench::MakeSyntheticDocument(animCount, patternCount);
+		for (AnimInfoData& info : doc.animations)
+		{
+			if (!info.pattern.empty())
+			{
+				info.pattern.back().wait = 20.0f;
+			}
+		}
+		return doc;
+	}
+
+	//差分がほとんど効かない最悪に近いデータ。noとwaitとstepを毎回ばらばらにする。
+	AnimDocument MakeScatteredDocument(int animCount, int patternCount)
+	{
+		AnimDocument doc = MakeSyntheticDocument(animCount, patternCount);
+		uint32_t seed = 12345;
+		auto next = [&seed]()
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return seed >> 8;
+		};
+		for (AnimInfoData& info : doc.animations)
+		{
+			for (AnimPatternData& ptn : info.pattern)
+			{
+				ptn.wait = static_cast<float>(next() % 1000) * 0.1f;
+				ptn.no   = static_cast<int32_t>(next() % 4096);
+				ptn.step = static_cast<int32_t>(next() % 64);
+			}
+		}
+		return doc;
+	}
+
+	//floatはビット単位で比べる。
+	bool IsSameFloat(float a, float b)
+	{
+		return std::memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	bool IsSameDocument(const AnimDocument& a, const AnimDocument& b)
+	{
+		if (a.textureName != b.textureName || a.textName != b.textName || a.animations.size() != b.animations.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < a.animations.size(); ++i)
+		{
+			const AnimInfoData& infoA = a.animations[i];
+			const AnimInfoData& infoB = b.animations[i];
+			if (infoA.name != infoB.name || infoA.bLoop != infoB.bLoop ||
+				!IsSameFloat(infoA.offsetX, infoB.offsetX) || !IsSameFloat(infoA.offsetY, infoB.offsetY) ||
+				!IsSameFloat(infoA.width, infoB.width) || !IsSameFloat(infoA.height, infoB.height) ||
+				infoA.pattern.size() != infoB.pattern.size())
+			{
+				return false;
+			}
+
+			for (size_t j = 0; j < infoA.pattern.size(); ++j)
+			{
+				const AnimPatternData& ptnA = infoA.pattern[j];
+				const AnimPatternData& ptnB = infoB.pattern[j];
+				if (!IsSameFloat(ptnA.wait, ptnB.wait) || ptnA.no != ptnB.no || ptnA.step != ptnB.step)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 200;
+	std::vector<std::filesystem::path> files;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			bench::CollectFiles(argv[i], files);
+		}
+	}
+
+	std::vector<std::pair<std::string, AnimDocument>> docs;
+	if (files.empty())
+	{
+		bench::CollectFiles("../animake/App/Resource", files);
+		docs.emplace_back("synthetic 500x30", MakeSyntheticDocument(500, 30));
+		docs.emplace_back("scattered 500x30", MakeScatteredDocument(500, 30));
+	}
+
+	for (const auto& path : files)
+	{
+		AnimDocument doc;
+		if (AnimCodec::Load(path, doc))
+		{
+			docs.emplace_back(path.filename().string(), std::move(doc));
+		}
+	}
+
+	std::sort(docs.begin(), docs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::printf("%-24s %-8s %10s %8s %14s %12s\n", "file", "format", "bytes", "ratio", "decode (us)", "MB/s");
+
+	bool bAllSame = true;
+	for (const auto& [name, doc] : docs)
+	{
+		size_t legacySize = AnimCodec::EncodedSize(doc);
+
+		for (const Variant& variant : variants)
+		{
+			std::vector<uint8_t> buffer;
+			if (!AnimCodec::Encode(doc, buffer, variant.format))
+			{
+				continue;
+			}
+
+			AnimDocument decoded;
+			double decodeSec = bench::Measure(iterations, [&]()
+			{
+				AnimCodec::Decode(buffer.data(), buffer.size(), decoded);
+			});
+
+			bool bSame = IsSameDocument(doc, decoded);
+			bAllSame = bAllSame && bSame;
+
+			//MB/sはデコード後の大きさが同じになるよう従来の形式のサイズで割る。
+			double mb = static_cast<double>(legacySize) / (1024.0 * 1024.0);
+			std::printf("%-24s %-8s %10zu %7.1f%% %14.2f %12.1f%s\n",
+				name.c_str(), variant.label, buffer.size(), 100.0 * buffer.size() / legacySize,
+				decodeSec * 1e6, decodeSec > 0.0 ? mb / decodeSec : 0.0, bSame ? "" : "  MISMATCH");
+		}
+	}
+
+	return bAllSame ? 0 : 1;
+}
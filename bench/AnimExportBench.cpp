@@ -0,0 +1,145 @@
+﻿//JSONとMessagePackの書き出し速度を測るベンチマーク。Siv3Dなしでビルドできる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimExportBench.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AnimExport.cpp ../animake/AnimText.cpp ../animake/AtomicFile.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/MappedFile.cpp -o AnimExportBench
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimExportBench [.animファイル ...] [-n 繰り返し回数]
+//    引数がなければ生成したデータ(パターン数15万個と150万個)で計測する。
+//    書き出し中に溜まったバッファの最大サイズも表示するので、データが大きくなっても使うメモリが増えないことを確かめられる。
+
+#include "AnimCodec.hpp"
+#include "AnimExport.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	using bench::Clock;
+
+	struct Variant
+	{
+		const char*                  label;
+		AnimExportFormat             format;
+	};
+
+	constexpr Variant variants[] =
+	{
+		{ "json"   , AnimExportFormat::Json        },
+		{ "msgpack", AnimExportFormat::MessagePack },
+	};
+
+	//手で調整したような端数のある待ち時間も混ぜたデータを作る。
+	AnimDocument MakeSyntheticDocument(int animCount, int patternCount)
+	{
+		AnimDocument doc = bench::MakeSyntheticDocument(animCount, patternCount);
+		for (AnimInfoData& info : doc.animations)
+		{
+			for (size_t j = 0; j < info.pattern.size(); ++j)
+			{
+				info.pattern[j].wait += static_cast<float>(j % 4) * 0.25f;
+			}
+		}
+		return doc;
+	}
+
+	size_t PatternCount(const AnimDocument& doc)
+	{
+		size_t count = 0;
+		for (const AnimInfoData& info : doc.animations)
+		{
+			count += info.pattern.size();
+		}
+		return count;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 5;
+	std::vector<std::pair<std::string, AnimDocument>> docs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			AnimDocument doc;
+			if (AnimCodec::Load(argv[i], doc))
+			{
+				docs.emplace_back(argv[i], std::move(doc));
+			}
+		}
+	}
+
+	if (docs.empty())
+	{
+		docs.emplace_back("synthetic 5000x30", MakeSyntheticDocument(5000, 30));
+		docs.emplace_back("synthetic 50000x30", MakeSyntheticDocument(50000, 30));
+	}
+
+	std::filesystem::path tempDir = std::filesystem::temp_directory_path();
+
+	std::printf("%-20s %-8s %10s %12s %10s %14s %12s\n", "file", "format", "patterns", "bytes", "time (ms)", "patterns/s", "buffer max");
+
+	for (const auto& [name, doc] : docs)
+	{
+		size_t patternCount = PatternCount(doc);
+
+		for (const Variant& variant : variants)
+		{
+			std::filesystem::path path = tempDir / (std::string("AnimExportBench") + AnimExport::Extension(variant.format));
+
+			uint64_t writtenSize   = 0;
+			size_t   maxBufferSize = 0;
+			bool     bSuccess      = true;
+
+			auto begin = Clock::now();
+			for (int n = 0; n < iterations; ++n)
+			{
+				AnimExportWriter writer;
+				bSuccess = writer.Open(path, variant.format);
+				if (!bSuccess)
+				{
+					break;
+				}
+
+				writer.BeginDocument(doc.textureName, doc.animations.size());
+				for (const AnimInfoData& info : doc.animations)
+				{
+					writer.WriteAnimation(info);
+				}
+				bSuccess = writer.Close();
+
+				writtenSize   = writer.WrittenSize();
+				maxBufferSize = writer.MaxBufferSize();
+			}
+			double seconds = std::chrono::duration<double>(Clock::now() - begin).count() / iterations;
+
+			if (!bSuccess)
+			{
+				std::printf("%-20s %-8s failed to write %s\n", name.c_str(), variant.label, path.string().c_str());
+				continue;
+			}
+
+			std::printf("%-20s %-8s %10zu %12llu %10.2f %14.0f %12zu\n",
+				name.c_str(), variant.label, patternCount, static_cast<unsigned long long>(writtenSize),
+				seconds * 1e3, patternCount / seconds, maxBufferSize);
+
+			std::filesystem::remove(path);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,193 @@
+﻿//GUIManager::LoadDataと同じ手順で.animを開いた時のメモリ確保の回数と時間を測るベンチマーク。Siv3Dなしでビルドできる。
+//索引を作り、全ての名前をリスト表示用のUTF-32の文字列に直すところまでを1回の読み込みとして数える。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimLoadBench.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AnimIndex.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/AtomicFile.cpp ../animake/DocumentArena.cpp ../animake/MappedFile.cpp -o AnimLoadBench
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimLoadBench [アニメーション数] [-n 繰り返し回数]
+//    名前はゲームでよく使う "player_walk_front_0001" のような長さにする。
+
+#include "AnimCodec.hpp"
+#include "AnimIndex.hpp"
+#include "AnimZstd.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::atomic<size_t> allocCount(0);
+}
+
+void* operator new(size_t size)
+{
+	allocCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+using namespace siapp;
+
+namespace
+{
+	using bench::Clock;
+
+	struct Variant
+	{
+		const char*                  label;
+		AnimFormat                   format;
+		AnimCompression              compression;
+	};
+
+	constexpr Variant variants[] =
+	{
+		{ "legacy"      , AnimFormat::Legacy , AnimCompression::None },
+		{ "v2"          , AnimFormat::Flat   , AnimCompression::None },
+		{ "compact"     , AnimFormat::Compact, AnimCompression::None },
+		{ "compact+zstd", AnimFormat::Compact, AnimCompression::Zstd },
+	};
+
+	//実際のキャラクターのように、動作と向きの付いた長めの名前にする。
+	AnimDocument MakeSyntheticDocument(int animCount)
+	{
+		static const char* const actions[]    = { "idle", "walk", "run", "attack", "damage" };
+		static const char* const directions[] = { "front", "back", "left", "right" };
+
+		AnimDocument doc = bench::MakeSyntheticDocument(animCount, [](int i) { return 4 + i % 12; });
+		for (int i = 0; i < animCount; ++i)
+		{
+			char name[64];
+			std::snprintf(name, sizeof(name), "player_%s_%s_%04d", actions[i % 5], directions[(i / 5) % 4], i);
+			doc.animations[static_cast<size_t>(i)].name = name;
+		}
+		return doc;
+	}
+
+	//LoadDataと同じく、前のファイルの索引は新しいファイルを開けてから手放す。
+	//名前はUnicode::Widenと同じくUTF-32の文字列にする。(ASCIIのみなのでそのまま広げる)
+	void Load(const std::filesystem::path& path, AnimIndex*& inoutIndex, std::vector<std::u32string>& outNames)
+	{
+		AnimIndex* pIndex = new AnimIndex();
+		if (!pIndex->Open(path))
+		{
+			delete pIndex;
+			return;
+		}
+
+		delete inoutIndex;
+		inoutIndex = pIndex;
+
+		outNames.clear();
+		outNames.reserve(pIndex->AnimCount());
+		for (size_t i = 0; i < pIndex->AnimCount(); ++i)
+		{
+			std::string_view name = pIndex->Name(i);
+			outNames.emplace_back(name.begin(), name.end());
+		}
+	}
+
+	struct Result
+	{
+		double                       seconds = 0.0;
+		size_t                       allocs  = 0;
+	};
+
+	template<class Func>
+	Result Measure(int iterations, Func func)
+	{
+		Result result;
+		for (int n = 0; n < iterations; ++n)
+		{
+			size_t allocBegin = allocCount.load();
+			auto begin = Clock::now();
+			func();
+			result.seconds += std::chrono::duration<double>(Clock::now() - begin).count();
+			result.allocs  += allocCount.load() - allocBegin;
+		}
+		result.seconds /= iterations;
+		result.allocs  /= static_cast<size_t>(iterations);
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int animCount  = 10000;
+	int iterations = 50;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			animCount = std::max(1, std::atoi(argv[i]));
+		}
+	}
+
+	AnimDocument doc = MakeSyntheticDocument(animCount);
+	std::filesystem::path tempPath = std::filesystem::temp_directory_path() / "AnimLoadBench.anim";
+
+	std::printf("%d animations, %d iterations\n", animCount, iterations);
+	std::printf("%-13s %12s %12s %12s %12s\n", "variant", "index (ms)", "allocs", "names (ms)", "allocs");
+
+	for (const Variant& variant : variants)
+	{
+		if (variant.compression == AnimCompression::Zstd && !AnimZstd::IsAvailable())
+		{
+			continue;
+		}
+		if (!AnimCodec::Save(tempPath, doc, variant.format, variant.compression))
+		{
+			continue;
+		}
+
+		//索引だけの分と、リスト表示用の名前まで作る分を分けて測る。
+		AnimIndex* pIndex = nullptr;
+		Result indexResult = Measure(iterations, [&]()
+		{
+			AnimIndex* pNext = new AnimIndex();
+			pNext->Open(tempPath);
+			delete pIndex;
+			pIndex = pNext;
+		});
+
+		std::vector<std::u32string> names;
+		Result loadResult = Measure(iterations, [&]()
+		{
+			Load(tempPath, pIndex, names);
+		});
+
+		std::printf("%-13s %12.3f %12zu %12.3f %12zu\n",
+			variant.label, indexResult.seconds * 1e3, indexResult.allocs, loadResult.seconds * 1e3, loadResult.allocs);
+
+		delete pIndex;
+	}
+
+	std::filesystem::remove(tempPath);
+	return 0;
+}
@@ -0,0 +1,164 @@
+﻿//ばらばらの.animと画像を1つずつ開く読み込みと、パック(AnimPack.hpp)から引く読み込みを比べるベンチマーク。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimPackBench.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AnimIndex.cpp ../animake/AnimPack.cpp ../animake/AnimText.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/AtomicFile.cpp ../animake/DocumentArena.cpp ../animake/MappedFile.cpp -o AnimPackBench
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimPackBench [-files .animの数] [-textures 画像の数] [-n 繰り返し回数]
+//    一時フォルダに.animと画像の代わりのファイルを作り、全て読み込むまでの時間を計る。
+
+#include "AnimCodec.hpp"
+#include "AnimPack.hpp"
+#include "AtomicFile.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	using bench::Clock;
+
+	constexpr size_t textureSize = 16 * 1024;
+
+	//テキストは持たず、画像はパックで共有されるようにtextureNameを指定する。
+	AnimDocument MakeSyntheticDocument(const std::string& textureName, int animCount, int patternCount)
+	{
+		AnimDocument doc = bench::MakeSyntheticDocument(animCount, patternCount);
+		doc.textureName = textureName;
+		doc.textName    = "";
+		return doc;
+	}
+
+	//画像は中身を読むところまでを計測したいので、全バイトを足し合わせておく。
+	uint64_t Touch(const uint8_t* data, size_t size)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < size; i += 64)
+		{
+			sum += data[i];
+		}
+		return sum;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int fileCount    = 2000;
+	int textureCount = 100;
+	int iterations   = 5;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "-files") == 0)
+		{
+			fileCount = std::max(1, std::atoi(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "-textures") == 0)
+		{
+			textureCount = std::max(1, std::atoi(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "-n") == 0)
+		{
+			iterations = std::max(1, std::atoi(argv[i + 1]));
+		}
+	}
+
+	std::filesystem::path rootDir = std::filesystem::temp_directory_path() / "AnimPackBench";
+	std::filesystem::remove_all(rootDir);
+	std::filesystem::create_directories(rootDir / "chara");
+
+	//画像はパスの解決も含めて計るため、.animと同じフォルダに置いて.animにはファイル名だけを書く。
+	std::vector<uint8_t> texture(textureSize);
+	for (int i = 0; i < textureCount; ++i)
+	{
+		std::fill(texture.begin(), texture.end(), static_cast<uint8_t>(i));
+		std::string name = "sheet" + std::to_string(i) + ".png";
+		AtomicFile::Write(rootDir / "chara" / name, texture.data(), texture.size());
+	}
+
+	std::vector<std::filesystem::path> animPaths;
+	for (int i = 0; i < fileCount; ++i)
+	{
+		std::filesystem::path path = rootDir / "chara" / ("chara" + std::to_string(i) + ".anim");
+		AnimCodec::Save(path, MakeSyntheticDocument("sheet" + std::to_string(i % textureCount) + ".png", 8, 12));
+		animPaths.push_back(path);
+	}
+
+	std::filesystem::path packPath = rootDir / "bench.animpack";
+	std::string message;
+	auto buildBegin = Clock::now();
+	if (!AnimPack::Build(rootDir, animPaths, packPath, message))
+	{
+		std::fprintf(stderr, "%s\n", message.c_str());
+		return 1;
+	}
+	double buildSec = std::chrono::duration<double>(Clock::now() - buildBegin).count();
+
+	std::printf("%d .anim files, %d textures, pack %llu bytes (build %.2f ms)\n",
+		fileCount, textureCount, static_cast<unsigned long long>(std::filesystem::file_size(packPath)), buildSec * 1e3);
+
+	//.animを開き、中に書かれた画像のパスを探して開く。今までの読み込み方。
+	uint64_t looseSum = 0;
+	AnimDocument doc;
+	std::vector<uint8_t> buffer;
+	auto looseBegin = Clock::now();
+	for (int n = 0; n < iterations; ++n)
+	{
+		for (const auto& path : animPaths)
+		{
+			AnimCodec::Load(path, doc);
+			std::filesystem::path texturePath = AnimCodec::ResolveTexturePath(path, doc.textureName);
+			if (AnimCodec::ReadFile(texturePath, buffer))
+			{
+				looseSum += Touch(buffer.data(), buffer.size());
+			}
+		}
+	}
+	double looseSec = std::chrono::duration<double>(Clock::now() - looseBegin).count() / iterations;
+
+	//パックを1度だけマップし、名前から.animと画像を引く。
+	uint64_t packSum = 0;
+	std::vector<std::string> names;
+	for (const auto& path : animPaths)
+	{
+		names.push_back(AnimPack::NormalizeName(std::filesystem::relative(path, rootDir).generic_string()));
+	}
+
+	auto packBegin = Clock::now();
+	for (int n = 0; n < iterations; ++n)
+	{
+		AnimPackFile pack;
+		pack.Open(packPath);
+		for (const auto& name : names)
+		{
+			uint32_t index = pack.Find(name);
+			pack.DecodeAnimation(index, doc);
+
+			uint32_t textureIndex = pack.TextureIndex(index);
+			if (textureIndex != animPackNotFound)
+			{
+				packSum += Touch(pack.Data(textureIndex), static_cast<size_t>(pack.Entry(textureIndex).dataSize));
+			}
+		}
+	}
+	double packSec = std::chrono::duration<double>(Clock::now() - packBegin).count() / iterations;
+
+	std::printf("%-10s %10.2f ms %12.0f files/s\n", "loose", looseSec * 1e3, fileCount / looseSec);
+	std::printf("%-10s %10.2f ms %12.0f files/s  (x%.1f)\n", "pack", packSec * 1e3, fileCount / packSec, looseSec / packSec);
+
+	if (looseSum != packSum)
+	{
+		std::printf("texture data mismatch\n");
+	}
+
+	std::filesystem::remove_all(rootDir);
+	return 0;
+}
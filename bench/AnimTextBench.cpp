@@ -0,0 +1,169 @@
+﻿//AnimTextの.txtの読み込み(Parse)と書き出し(Export)の速度を測るベンチマーク。Siv3Dなしでビルドできる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimTextBench.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AnimText.cpp ../animake/AtomicFile.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/MappedFile.cpp -o AnimTextBench
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimTextBench [.txtファイル ...] [-n 繰り返し回数]
+//    引数がなければ生成した数MBのデータで計測する。同じデータの.animのデコードとも比べる。
+
+#include "AnimCodec.hpp"
+#include "AnimText.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	struct BenchInput
+	{
+		std::string                  label;
+		std::string                  text;
+	};
+
+	//手で調整したような端数のある待ち時間や高さも混ぜたデータを作る。
+	AnimDocument MakeSyntheticDocument(int animCount, int patternCount)
+	{
+		AnimDocument doc = bench::MakeSyntheticDocument(animCount, patternCount);
+		for (size_t i = 0; i < doc.animations.size(); ++i)
+		{
+			AnimInfoData& info = doc.animations[i];
+			info.height += static_cast<float>(i % 3) * 0.5f;
+			for (size_t j = 0; j < info.pattern.size(); ++j)
+			{
+				info.pattern[j].wait += static_cast<float>(j % 4) * 0.25f;
+			}
+		}
+		return doc;
+	}
+
+	bool IsSameDocument(const AnimDocument& a, const AnimDocument& b)
+	{
+		if (a.textureName != b.textureName || a.animations.size() != b.animations.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < a.animations.size(); ++i)
+		{
+			const AnimInfoData& infoA = a.animations[i];
+			const AnimInfoData& infoB = b.animations[i];
+			if (infoA.name != infoB.name || infoA.offsetX != infoB.offsetX || infoA.offsetY != infoB.offsetY ||
+				infoA.width != infoB.width || infoA.height != infoB.height || infoA.bLoop != infoB.bLoop ||
+				infoA.pattern.size() != infoB.pattern.size())
+			{
+				return false;
+			}
+
+			for (size_t j = 0; j < infoA.pattern.size(); ++j)
+			{
+				const AnimPatternData& ptnA = infoA.pattern[j];
+				const AnimPatternData& ptnB = infoB.pattern[j];
+				if (ptnA.wait != ptnB.wait || ptnA.no != ptnB.no || ptnA.step != ptnB.step)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void PrintResult(const char* label, size_t bytes, size_t animCount, double seconds)
+	{
+		double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+		std::printf("  %-20s %10.2f MB %10.3f ms %10.1f MB/s %12.0f anims/s\n",
+			label, mb, seconds * 1e3, seconds > 0.0 ? mb / seconds : 0.0, seconds > 0.0 ? animCount / seconds : 0.0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 20;
+	std::vector<BenchInput> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			BenchInput input;
+			std::vector<uint8_t> bytes;
+			if (AnimCodec::ReadFile(argv[i], bytes))
+			{
+				input.label = argv[i];
+				input.text.assign(bytes.begin(), bytes.end());
+				inputs.push_back(std::move(input));
+			}
+		}
+	}
+
+	if (inputs.empty())
+	{
+		//10000個で約3.5MBになる。
+		const int animCounts[] = { 1000, 10000 };
+		for (int animCount : animCounts)
+		{
+			BenchInput input;
+			input.label = "synthetic " + std::to_string(animCount) + "x30";
+			AnimText::Export(MakeSyntheticDocument(animCount, 30), "chara/player_large.anim", input.text);
+			inputs.push_back(std::move(input));
+		}
+	}
+
+	for (const BenchInput& input : inputs)
+	{
+		AnimDocument doc;
+		std::string animPath;
+		AnimTextError error;
+		if (!AnimText::Parse(input.text.data(), input.text.size(), doc, animPath, &error))
+		{
+			std::printf("%s: parse error at line %zu (%s)\n", input.label.c_str(), error.line, error.message);
+			continue;
+		}
+
+		//書き出し直したものを読み込み直して、同じ中身に戻ることを確かめる。
+		std::string exported;
+		AnimText::Export(doc, animPath, exported);
+
+		AnimDocument reparsed;
+		std::string reparsedAnimPath;
+		bool bRoundTrip = AnimText::Parse(exported.data(), exported.size(), reparsed, reparsedAnimPath) &&
+			reparsedAnimPath == animPath && IsSameDocument(doc, reparsed);
+
+		std::printf("%s: %zu animations, round trip %s\n", input.label.c_str(), doc.animations.size(), bRoundTrip ? "ok" : "MISMATCH");
+
+		double parseSec = bench::Measure(iterations, [&]()
+		{
+			AnimText::Parse(input.text.data(), input.text.size(), reparsed, reparsedAnimPath);
+		});
+		PrintResult("txt parse", input.text.size(), doc.animations.size(), parseSec);
+
+		double exportSec = bench::Measure(iterations, [&]()
+		{
+			AnimText::Export(doc, animPath, exported);
+		});
+		PrintResult("txt export", exported.size(), doc.animations.size(), exportSec);
+
+		//同じ中身の.animのデコードと比べる。
+		std::vector<uint8_t> buffer;
+		if (AnimCodec::Encode(doc, buffer))
+		{
+			double decodeSec = bench::Measure(iterations, [&]()
+			{
+				AnimCodec::Decode(buffer.data(), buffer.size(), reparsed);
+			});
+			PrintResult("anim decode", buffer.size(), doc.animations.size(), decodeSec);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,126 @@
+﻿//圧縮した.animと圧縮していない.animのサイズと読み込み時間を比べるベンチマーク。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimZstdBench.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AtomicFile.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/MappedFile.cpp -lzstd -o AnimZstdBench
+//
+//使い方:
+//    AnimZstdBench [.animファイル or ディレクトリ ...] [-n 繰り返し回数]
+//    引数がなければ ../animake/App/Resource のサンプルと生成した大きめのデータで計測する。
+
+#include "AnimCodec.hpp"
+#include "AnimZstd.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	struct Variant
+	{
+		const char*                  label;
+		AnimFormat                   format;
+		AnimCompression              compression;
+	};
+
+	constexpr Variant variants[] =
+	{
+		{ "legacy"      , AnimFormat::Legacy , AnimCompression::None },
+		{ "legacy+zstd" , AnimFormat::Legacy , AnimCompression::Zstd },
+		{ "v2"          , AnimFormat::Flat   , AnimCompression::None },
+		{ "v2+zstd"     , AnimFormat::Flat   , AnimCompression::Zstd },
+		{ "compact"     , AnimFormat::Compact, AnimCompression::None },
+		{ "compact+zstd", AnimFormat::Compact, AnimCompression::Zstd },
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	if (!AnimZstd::IsAvailable())
+	{
+		std::fprintf(stderr, "built without zstd.h\n");
+		return 1;
+	}
+
+	int iterations = 200;
+	std::vector<std::filesystem::path> files;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			bench::CollectFiles(argv[i], files);
+		}
+	}
+
+	std::vector<std::pair<std::string, AnimDocument>> docs;
+	if (files.empty())
+	{
+		bench::CollectFiles("../animake/App/Resource", files);
+		docs.emplace_back("synthetic 500x30", bench::MakeSyntheticDocument(500, 30));
+	}
+
+	for (const auto& path : files)
+	{
+		AnimDocument doc;
+		if (AnimCodec::Load(path, doc))
+		{
+			docs.emplace_back(path.filename().string(), std::move(doc));
+		}
+	}
+
+	std::sort(docs.begin(), docs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::filesystem::path tempPath = std::filesystem::temp_directory_path() / "AnimZstdBench.anim";
+
+	std::printf("%-24s %-13s %10s %8s %14s %14s\n", "file", "variant", "bytes", "ratio", "load (us)", "stream (us)");
+
+	for (const auto& [name, doc] : docs)
+	{
+		size_t rawSize = AnimCodec::EncodedSize(doc);
+
+		for (const Variant& variant : variants)
+		{
+			if (!AnimCodec::Save(tempPath, doc, variant.format, variant.compression))
+			{
+				continue;
+			}
+
+			size_t fileSize = static_cast<size_t>(std::filesystem::file_size(tempPath));
+
+			//ファイルを一度に読み込み、必要なら展開してデコードする。
+			AnimDocument loaded;
+			double loadSec = bench::Measure(iterations, [&]()
+			{
+				AnimCodec::Load(tempPath, loaded);
+			});
+
+			//圧縮ファイルは少しずつ読みながら展開する方法でも計測する。
+			double streamSec = 0.0;
+			if (variant.compression == AnimCompression::Zstd)
+			{
+				std::vector<uint8_t> buffer;
+				streamSec = bench::Measure(iterations, [&]()
+				{
+					AnimZstd::DecompressFile(tempPath, buffer);
+					AnimCodec::Decode(buffer.data(), buffer.size(), loaded);
+				});
+			}
+
+			std::printf("%-24s %-13s %10zu %7.1f%% %14.2f %14.2f\n",
+				name.c_str(), variant.label, fileSize, 100.0 * fileSize / rawSize, loadSec * 1e6, streamSec * 1e6);
+		}
+	}
+
+	std::filesystem::remove(tempPath);
+	return 0;
+}
@@ -0,0 +1,180 @@
+﻿//全てのアニメーションのフレームを順番に辿る速さを、アニメーションごとに配列を持つ形とAnimationBankで比べるベンチマーク。
+//書き出しや検証と同じく、フレームごとに切り出し矩形を計算して合計する。
+//計算済みの切り出し矩形の表(AnimationInfo::FrameRects、AnimationBank::FrameRects)を読むだけの場合も測る。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimationBankBench.cpp ../animake/AnimationBank.cpp -o AnimationBankBench
+//
+//使い方:
+//    AnimationBankBench [アニメーション数] [-n 繰り返し回数]
+//    エディタで追加や削除を繰り返した後のように、アニメーションごとの配列はばらばらの順番で確保する。
+
+#include "AnimationBank.hpp"
+#include "AnimationModel.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	//GUIManager::ApplyAnimDataと同じ形にする。確保する順番は混ぜておく。
+	void LoadModel(const AnimDocument& doc, std::vector<AnimationInfo>& outArray)
+	{
+		outArray.assign(doc.animations.size(), AnimationInfo());
+
+		std::vector<size_t> order(doc.animations.size());
+		std::iota(order.begin(), order.end(), size_t(0));
+		std::shuffle(order.begin(), order.end(), std::mt19937(12345));
+
+		for (size_t i : order)
+		{
+			const AnimInfoData& data = doc.animations[i];
+			AnimationInfo& info      = outArray[i];
+			info.offsetX = data.offsetX;
+			info.offsetY = data.offsetY;
+			info.width   = data.width;
+			info.height  = data.height;
+			info.bLoop   = data.bLoop;
+
+			std::vector<AnimationPattern>& pattern = info.pattern.Edit();
+			pattern.clear();
+			for (const AnimPatternData& ptn : data.pattern)
+			{
+				pattern.push_back(AnimationPattern{ static_cast<double>(ptn.wait), ptn.no, ptn.step });
+			}
+		}
+	}
+
+	double WalkModel(const std::vector<AnimationInfo>& array)
+	{
+		double sum = 0.0;
+		for (const AnimationInfo& info : array)
+		{
+			for (size_t j = 0; j < info.pattern.size(); ++j)
+			{
+				const AnimationPattern& ptn = info.pattern[j];
+				sum += ptn.wait + info.offsetX + ptn.no * info.width + info.offsetY + ptn.step * info.height;
+			}
+		}
+		return sum;
+	}
+
+	double WalkDocument(const AnimDocument& doc)
+	{
+		double sum = 0.0;
+		for (const AnimInfoData& info : doc.animations)
+		{
+			for (const AnimPatternData& ptn : info.pattern)
+			{
+				sum += ptn.wait + info.offsetX + ptn.no * info.width + info.offsetY + ptn.step * info.height;
+			}
+		}
+		return sum;
+	}
+
+	double WalkBank(const AnimationBank& bank)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < bank.AnimCount(); ++i)
+		{
+			float offsetX = bank.OffsetX(i);
+			float offsetY = bank.OffsetY(i);
+			float width   = bank.Width(i);
+			float height  = bank.Height(i);
+			for (const AnimPatternData& ptn : bank.Patterns(i))
+			{
+				sum += ptn.wait + offsetX + ptn.no * width + offsetY + ptn.step * height;
+			}
+		}
+		return sum;
+	}
+
+	//計算済みの表を読む。表はループの外で1度だけ作られ、2回目からは作り直さない。
+	double WalkModelBaked(const std::vector<AnimationInfo>& array)
+	{
+		double sum = 0.0;
+		for (const AnimationInfo& info : array)
+		{
+			const std::vector<AnimationFrameRect>& rects = info.FrameRects(0.0, 0.0);
+			for (size_t j = 0; j < rects.size(); ++j)
+			{
+				sum += info.pattern[j].wait + rects[j].srcX + rects[j].srcY;
+			}
+		}
+		return sum;
+	}
+
+	double WalkBankBaked(const AnimationBank& bank)
+	{
+		const std::vector<AnimPatternData>& patterns = bank.PatternPool();
+		const std::vector<AnimFrameRect>&   rects    = bank.FrameRectPool();
+
+		double sum = 0.0;
+		for (size_t j = 0; j < patterns.size(); ++j)
+		{
+			sum += patterns[j].wait + rects[j].srcX + rects[j].srcY;
+		}
+		return sum;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int animCount  = 100000;
+	int iterations = 50;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			animCount = std::max(1, std::atoi(argv[i]));
+		}
+	}
+
+	AnimDocument doc = bench::MakeSyntheticDocument(animCount, [](int i) { return 4 + i % 28; });
+
+	std::vector<AnimationInfo> model;
+	LoadModel(doc, model);
+
+	AnimationBank bank(doc);
+
+	std::printf("%d animations, %zu patterns, %d iterations\n", animCount, bank.PatternCount(), iterations);
+	std::printf("%-12s %12s %10s\n", "layout", "walk (ms)", "speedup");
+
+	//合計は最適化で消されないように使う。
+	double sumModel = 0.0;
+	double sumDoc   = 0.0;
+	double sumBank  = 0.0;
+	double sumModelBaked = 0.0;
+	double sumBankBaked  = 0.0;
+	double modelSec = bench::MeasureSum(iterations, [&]() { return WalkModel(model); }, sumModel);
+	double docSec   = bench::MeasureSum(iterations, [&]() { return WalkDocument(doc); }, sumDoc);
+	double bankSec  = bench::MeasureSum(iterations, [&]() { return WalkBank(bank); }, sumBank);
+	double modelBakedSec = bench::MeasureSum(iterations, [&]() { return WalkModelBaked(model); }, sumModelBaked);
+	double bankBakedSec  = bench::MeasureSum(iterations, [&]() { return WalkBankBaked(bank); }, sumBankBaked);
+
+	std::printf("%-12s %12.3f %9.1fx\n", "model", modelSec * 1e3, 1.0);
+	std::printf("%-12s %12.3f %9.1fx\n", "document", docSec * 1e3, modelSec / docSec);
+	std::printf("%-12s %12.3f %9.1fx\n", "bank", bankSec * 1e3, modelSec / bankSec);
+	std::printf("%-12s %12.3f %9.1fx\n", "model baked", modelBakedSec * 1e3, modelSec / modelBakedSec);
+	std::printf("%-12s %12.3f %9.1fx\n", "bank baked", bankBakedSec * 1e3, modelSec / bankBakedSec);
+
+	if (sumModel != sumBank || sumDoc != sumBank || sumModelBaked != sumBank || sumBankBaked != sumBank)
+	{
+		std::fprintf(stderr, "sums differ\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,286 @@
+﻿//AnimationInfoとAnimationPatternの追加・削除・読み込みの速さとメモリ確保の回数を測るベンチマーク。Siv3Dなしでビルドできる。
+//以前の手書きのコピーコンストラクタを持つ形(Legacy)と、AnimationModel.hppの形を比べる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimationModelBench.cpp -o AnimationModelBench
+//
+//使い方:
+//    AnimationModelBench [アニメーション数] [-n 繰り返し回数]
+//    Array<AnimationInfo>はstd::vectorと同じように伸びるので、ここではstd::vectorで代わりにする。
+
+#include "AnimationModel.hpp"
+#include "AnimCodec.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::atomic<size_t> allocCount(0);
+}
+
+void* operator new(size_t size)
+{
+	allocCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+using namespace siapp;
+
+namespace
+{
+	using bench::Clock;
+
+	//以前のGUIManager.hppにあった形。コピーは1つずつ作り直し、ムーブはできない。比較用。
+	struct LegacyAnimationPattern
+	{
+		double                       wait    = 1.0;
+		int                          no      = 0;
+		int                          step    = 0;
+
+		LegacyAnimationPattern(void) :
+			wait(1.0),
+			no(0),
+			step(0)
+		{
+		}
+
+		LegacyAnimationPattern(const LegacyAnimationPattern& obj)
+		{
+			wait = obj.wait;
+			no   = obj.no;
+			step = obj.step;
+		}
+
+		void operator= (const LegacyAnimationPattern& obj)
+		{
+			wait = obj.wait;
+			no   = obj.no;
+			step = obj.step;
+		}
+	};
+
+	struct LegacyAnimationInfo
+	{
+		double                       offsetX = 0.0;
+		double                       offsetY = 0.0;
+		double                       width   = 0.0;
+		double                       height  = 0.0;
+		bool                         bLoop   = false;
+		std::vector<LegacyAnimationPattern> pattern;
+
+		LegacyAnimationInfo(void)
+		{
+			for (size_t i = 0; i < defaultPatternCount; ++i)
+			{
+				pattern.push_back(LegacyAnimationPattern());
+			}
+		}
+
+		LegacyAnimationInfo(const LegacyAnimationInfo& obj)
+		{
+			*this = obj;
+		}
+
+		LegacyAnimationInfo& operator= (const LegacyAnimationInfo& obj)
+		{
+			offsetX = obj.offsetX;
+			offsetY = obj.offsetY;
+			width   = obj.width;
+			height  = obj.height;
+			bLoop   = obj.bLoop;
+			pattern.clear();
+			for (size_t i = 0; i < obj.pattern.size(); ++i)
+			{
+				pattern.push_back(LegacyAnimationPattern());
+				pattern[i] = obj.pattern[i];
+			}
+			return *this;
+		}
+	};
+
+	//以前のLoadDataと同じく、初期状態のアニメーションを作ってからパターンを入れ直す。
+	void LoadLegacy(const AnimDocument& doc, std::vector<LegacyAnimationInfo>& outArray)
+	{
+		outArray.clear();
+		for (const AnimInfoData& data : doc.animations)
+		{
+			outArray.push_back(LegacyAnimationInfo());
+			LegacyAnimationInfo& info = outArray.back();
+			info.offsetX = data.offsetX;
+			info.offsetY = data.offsetY;
+			info.width   = data.width;
+			info.height  = data.height;
+			info.bLoop   = data.bLoop;
+			info.pattern.clear();
+			for (const AnimPatternData& ptn : data.pattern)
+			{
+				info.pattern.push_back(LegacyAnimationPattern());
+				info.pattern.back().wait = ptn.wait;
+				info.pattern.back().no   = ptn.no;
+				info.pattern.back().step = ptn.step;
+			}
+		}
+	}
+
+	//GUIManager::ApplyAnimDataと同じく、数を確保してからパターンを詰める。
+	void LoadModel(const AnimDocument& doc, std::vector<AnimationInfo>& outArray)
+	{
+		outArray.clear();
+		outArray.reserve(doc.animations.size());
+		for (const AnimInfoData& data : doc.animations)
+		{
+			outArray.emplace_back();
+			AnimationInfo& info = outArray.back();
+			info.offsetX = data.offsetX;
+			info.offsetY = data.offsetY;
+			info.width   = data.width;
+			info.height  = data.height;
+			info.bLoop   = data.bLoop;
+
+			auto pArray = std::make_shared<std::vector<AnimationPattern>>();
+			pArray->reserve(data.pattern.size());
+			for (const AnimPatternData& ptn : data.pattern)
+			{
+				pArray->push_back(AnimationPattern{ static_cast<double>(ptn.wait), ptn.no, ptn.step });
+			}
+			info.pattern = AnimationPatternArray(std::move(pArray));
+		}
+	}
+
+	//リストの「追加」ボタンと同じく、1つずつ後ろに足す。
+	template<class Info>
+	void Add(std::vector<Info>& array, int count)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			array.push_back(Info());
+		}
+	}
+
+	//リストの途中のアニメーションを消していく。後ろの要素は1つずつ前に詰められる。
+	template<class Info>
+	void Delete(std::vector<Info>& array)
+	{
+		while (array.size() > 1)
+		{
+			array.erase(array.begin() + static_cast<std::ptrdiff_t>(array.size() / 2));
+		}
+	}
+
+	struct Result
+	{
+		double                       seconds = 0.0;
+		size_t                       allocs  = 0;
+	};
+
+	//setupの時間とメモリ確保は数えずに、funcだけを測る。
+	template<class Setup, class Func>
+	Result MeasureWithSetup(int iterations, Setup setup, Func func)
+	{
+		Result result;
+		for (int n = 0; n < iterations; ++n)
+		{
+			setup();
+
+			size_t allocBegin = allocCount.load();
+			auto begin = Clock::now();
+			func();
+			result.seconds += std::chrono::duration<double>(Clock::now() - begin).count();
+			result.allocs  += allocCount.load() - allocBegin;
+		}
+		result.seconds /= iterations;
+		result.allocs  /= static_cast<size_t>(iterations);
+		return result;
+	}
+
+	template<class Func>
+	Result Measure(int iterations, Func func)
+	{
+		return MeasureWithSetup(iterations, []() {}, func);
+	}
+
+	void Print(const char* label, const Result& legacy, const Result& model)
+	{
+		std::printf("%-8s %14.3f %12zu %14.3f %12zu %9.1fx\n",
+			label, legacy.seconds * 1e3, legacy.allocs, model.seconds * 1e3, model.allocs,
+			model.seconds > 0.0 ? legacy.seconds / model.seconds : 0.0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int animCount  = 2000;
+	int iterations = 20;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			animCount = std::max(1, std::atoi(argv[i]));
+		}
+	}
+
+	AnimDocument doc = bench::MakeSyntheticDocument(animCount, [](int i) { return 4 + i % 12; });
+
+	std::printf("%d animations, %d iterations\n", animCount, iterations);
+	std::printf("%-8s %14s %12s %14s %12s %10s\n", "op", "legacy (ms)", "allocs", "model (ms)", "allocs", "speedup");
+
+	Result legacyAdd = Measure(iterations, [&]()
+	{
+		std::vector<LegacyAnimationInfo> array;
+		Add(array, animCount);
+	});
+	Result modelAdd = Measure(iterations, [&]()
+	{
+		std::vector<AnimationInfo> array;
+		Add(array, animCount);
+	});
+	Print("add", legacyAdd, modelAdd);
+
+	//削除は読み込んだ状態から始める。読み込みの分は数えない。
+	std::vector<LegacyAnimationInfo> legacyArray;
+	std::vector<AnimationInfo>       modelArray;
+	Result legacyDelete = MeasureWithSetup(iterations, [&]() { LoadLegacy(doc, legacyArray); }, [&]() { Delete(legacyArray); });
+	Result modelDelete  = MeasureWithSetup(iterations, [&]() { LoadModel(doc, modelArray); }, [&]() { Delete(modelArray); });
+	Print("delete", legacyDelete, modelDelete);
+
+	//読み込みは毎回空の配列から始める。
+	Result legacyLoad = Measure(iterations, [&]()
+	{
+		std::vector<LegacyAnimationInfo> array;
+		LoadLegacy(doc, array);
+	});
+	Result modelLoad = Measure(iterations, [&]()
+	{
+		std::vector<AnimationInfo> array;
+		LoadModel(doc, array);
+	});
+	Print("load", legacyLoad, modelLoad);
+	return 0;
+}
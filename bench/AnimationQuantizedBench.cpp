@@ -0,0 +1,204 @@
+﻿//たくさんのアニメーションを持った時のメモリの大きさを、エディタのAnimationInfoの配列とQuantizedAnimationSetで比べるベンチマーク。
+//確保したバイト数をoperator newで数える。全てのパターンを読む速さと、詰めて戻した値が元と同じかも確かめる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimationQuantizedBench.cpp ../animake/AnimationQuantized.cpp -o AnimationQuantizedBench
+//
+//使い方:
+//    AnimationQuantizedBench [アニメーション数] [-n 繰り返し回数]
+//    waitは整数のフレーム数を中心にし、50個に1個は0.1刻みで足したもの(詰められずにAnimationInfoのまま持つもの)にする。
+
+#include "AnimationQuantized.hpp"
+#include "BenchCommon.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace
+{
+	//解放する時に大きさが分かるように、確保した先頭に大きさを置いておく。
+	constexpr size_t            headerSize = alignof(std::max_align_t);
+	std::atomic<size_t>         liveBytes(0);
+}
+
+void* operator new(size_t size)
+{
+	if (uint8_t* p = static_cast<uint8_t*>(std::malloc(size + headerSize)))
+	{
+		std::memcpy(p, &size, sizeof(size));
+		liveBytes.fetch_add(size, std::memory_order_relaxed);
+		return p + headerSize;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	if (p)
+	{
+		uint8_t* pHead = static_cast<uint8_t*>(p) - headerSize;
+		size_t size;
+		std::memcpy(&size, pHead, sizeof(size));
+		liveBytes.fetch_sub(size, std::memory_order_relaxed);
+		std::free(pHead);
+	}
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+using namespace siapp;
+
+namespace
+{
+	//GUIManager::ApplyAnimDataで読み込んだ後と同じく、アニメーションごとにパターン配列を持たせる。
+	void MakeSyntheticModel(int animCount, std::vector<AnimationInfo>& outArray)
+	{
+		outArray.resize(static_cast<size_t>(animCount));
+		for (int i = 0; i < animCount; ++i)
+		{
+			AnimationInfo& info = outArray[static_cast<size_t>(i)];
+			info.offsetY = static_cast<double>((i % 64) * 64);
+			info.width   = 64.0;
+			info.height  = 64.0;
+			info.bLoop   = (i % 2) == 0;
+
+			std::vector<AnimationPattern>& pattern = info.pattern.Edit();
+			pattern.resize(static_cast<size_t>(4 + i % 28));
+			for (size_t j = 0; j < pattern.size(); ++j)
+			{
+				double wait = (i % 50) == 49 ? 0.1 + 0.1 + 0.1 : static_cast<double>(1 + (i + j) % 8);
+				if ((i % 7) == 3)
+				{
+					wait += 0.5;
+				}
+				pattern[j] = AnimationPattern{ wait, static_cast<int>(j), i % 8 };
+			}
+		}
+	}
+
+	double WalkModel(const std::vector<AnimationInfo>& array)
+	{
+		double sum = 0.0;
+		for (const AnimationInfo& info : array)
+		{
+			for (size_t j = 0; j < info.pattern.size(); ++j)
+			{
+				const AnimationPattern& ptn = info.pattern[j];
+				sum += ptn.wait + info.offsetX + ptn.no * info.width + info.offsetY + ptn.step * info.height;
+			}
+		}
+		return sum;
+	}
+
+	double WalkQuantized(const QuantizedAnimationSet& set)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < set.AnimCount(); ++i)
+		{
+			double offsetX = set.OffsetX(i);
+			double offsetY = set.OffsetY(i);
+			double width   = set.Width(i);
+			double height  = set.Height(i);
+			for (size_t j = 0; j < set.PatternCount(i); ++j)
+			{
+				AnimationPattern ptn = set.Pattern(i, j);
+				sum += ptn.wait + offsetX + ptn.no * width + offsetY + ptn.step * height;
+			}
+		}
+		return sum;
+	}
+
+	bool SameInfo(const AnimationInfo& a, const AnimationInfo& b)
+	{
+		if (std::memcmp(&a.offsetX, &b.offsetX, sizeof(double)) != 0 ||
+			std::memcmp(&a.offsetY, &b.offsetY, sizeof(double)) != 0 ||
+			std::memcmp(&a.width, &b.width, sizeof(double)) != 0 ||
+			std::memcmp(&a.height, &b.height, sizeof(double)) != 0 ||
+			a.bLoop != b.bLoop ||
+			a.pattern.size() != b.pattern.size())
+		{
+			return false;
+		}
+
+		for (size_t j = 0; j < a.pattern.size(); ++j)
+		{
+			if (std::memcmp(&a.pattern[j].wait, &b.pattern[j].wait, sizeof(double)) != 0 ||
+				a.pattern[j].no != b.pattern[j].no ||
+				a.pattern[j].step != b.pattern[j].step)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int animCount  = 100000;
+	int iterations = 20;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			animCount = std::max(1, std::atoi(argv[i]));
+		}
+	}
+
+	size_t modelBegin = liveBytes.load();
+	std::vector<AnimationInfo> model;
+	MakeSyntheticModel(animCount, model);
+	size_t modelBytes = liveBytes.load() - modelBegin;
+
+	size_t quantizedBegin = liveBytes.load();
+	QuantizedAnimationSet set;
+	set.Assign(model.data(), model.size());
+	size_t quantizedBytes = liveBytes.load() - quantizedBegin;
+
+	size_t patternCount = 0;
+	for (const AnimationInfo& info : model)
+	{
+		patternCount += info.pattern.size();
+	}
+
+	std::printf("%d animations, %zu patterns, %zu quantized, %zu fallback, %d iterations\n",
+		animCount, patternCount, set.QuantizedCount(), set.AnimCount() - set.QuantizedCount(), iterations);
+	std::printf("%-10s %12s %10s %12s\n", "layout", "memory (KB)", "ratio", "walk (ms)");
+
+	double sumModel     = 0.0;
+	double sumQuantized = 0.0;
+	double modelSec     = bench::MeasureSum(iterations, [&]() { return WalkModel(model); }, sumModel);
+	double quantizedSec = bench::MeasureSum(iterations, [&]() { return WalkQuantized(set); }, sumQuantized);
+
+	std::printf("%-10s %12.1f %9.1f%% %12.3f\n", "model", modelBytes / 1024.0, 100.0, modelSec * 1e3);
+	std::printf("%-10s %12.1f %9.1f%% %12.3f\n", "quantized", quantizedBytes / 1024.0, 100.0 * quantizedBytes / modelBytes, quantizedSec * 1e3);
+	std::printf("MemorySize() reports %.1f KB\n", set.MemorySize() / 1024.0);
+
+	for (size_t i = 0; i < model.size(); ++i)
+	{
+		if (!SameInfo(model[i], set.Get(i)))
+		{
+			std::fprintf(stderr, "animation %zu differs after quantizing\n", i);
+			return 1;
+		}
+	}
+
+	if (sumModel != sumQuantized)
+	{
+		std::fprintf(stderr, "sums differ\n");
+		return 1;
+	}
+	return 0;
+}
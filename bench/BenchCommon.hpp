@@ -0,0 +1,95 @@
+﻿#pragma once
+#include "AnimCodec.hpp"
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//ベンチマークで共通に使うデータの作り方と時間の測り方。Siv3Dなしでビルドできる。
+//ヘッダーだけなので、各ベンチマークのビルド例に.cppを足す必要はない。
+
+namespace siapp
+{
+	namespace bench
+	{
+		using Clock = std::chrono::steady_clock;
+
+		//よくあるキャラクターのデータを作る。名前は"Animation<番号>"、矩形は64x64を縦に並べ、奇数番目以外はループする。
+		//パターンはnoが連番、stepはアニメーションごとに0～7、waitは5フレーム。patternCountOf(i)がi番目のアニメーションのパターン数。
+		//端数のあるwaitなど、ベンチマークごとの違いは作った後で書き換える。
+		template<class PatternCountFunc>
+		AnimDocument MakeSyntheticDocument(int animCount, PatternCountFunc patternCountOf)
+		{
+			AnimDocument doc;
+			doc.textureName = "chara/player_sheet.png";
+			doc.textName    = "player_large.txt";
+			doc.animations.resize(static_cast<size_t>(animCount));
+			for (int i = 0; i < animCount; ++i)
+			{
+				AnimInfoData& info = doc.animations[static_cast<size_t>(i)];
+				info.name    = "Animation" + std::to_string(i);
+				info.offsetX = 0.0f;
+				info.offsetY = static_cast<float>(i * 64);
+				info.width   = 64.0f;
+				info.height  = 64.0f;
+				info.bLoop   = (i % 2) == 0;
+				info.pattern.resize(static_cast<size_t>(patternCountOf(i)));
+				for (size_t j = 0; j < info.pattern.size(); ++j)
+				{
+					info.pattern[j] = { 5.0f, static_cast<int32_t>(j), i % 8 };
+				}
+			}
+			return doc;
+		}
+
+		//全てのアニメーションが同じパターン数のもの。
+		inline AnimDocument MakeSyntheticDocument(int animCount, int patternCount)
+		{
+			return MakeSyntheticDocument(animCount, [patternCount](int) { return patternCount; });
+		}
+
+		//pathがフォルダならその直下の.animを、ファイルならそのファイルを足す。
+		inline void CollectFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& outFiles)
+		{
+			std::error_code ec;
+			if (std::filesystem::is_directory(path, ec))
+			{
+				for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+				{
+					if (entry.is_regular_file() && entry.path().extension() == ".anim")
+					{
+						outFiles.push_back(entry.path());
+					}
+				}
+			}
+			else if (std::filesystem::is_regular_file(path, ec))
+			{
+				outFiles.push_back(path);
+			}
+		}
+
+		//funcをiterations回呼び、1回あたりの秒数を返す。
+		template<class Func>
+		double Measure(int iterations, Func func)
+		{
+			auto begin = Clock::now();
+			for (int n = 0; n < iterations; ++n)
+			{
+				func();
+			}
+			return std::chrono::duration<double>(Clock::now() - begin).count() / iterations;
+		}
+
+		//Measureと同じく測り、funcの戻り値をoutSumに足していく。合計を使うことで、呼び出しが最適化で消されないようにする。
+		template<class Func>
+		double MeasureSum(int iterations, Func func, double& outSum)
+		{
+			auto begin = Clock::now();
+			for (int n = 0; n < iterations; ++n)
+			{
+				outSum += func();
+			}
+			return std::chrono::duration<double>(Clock::now() - begin).count() / iterations;
+		}
+	}
+}
@@ -0,0 +1,443 @@
+﻿//フォルダ内の.animファイルをまとめて変換・検証・.txt出力するコマンドラインツール。Siv3Dなしでビルドできる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -pthread -I../animake AnimBatch.cpp ../animake/AnimationBank.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AnimExport.cpp ../animake/AnimHeader.cpp ../animake/AnimJournal.cpp ../animake/AnimText.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/AtomicFile.cpp ../animake/MappedFile.cpp ../animake/ThreadPool.cpp -o AnimBatch
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimBatch <コマンド> [オプション] <.animファイル or ディレクトリ ...>
+//
+//    コマンド:
+//        validate   読み込めるか、中身がツールで編集できる状態かを調べる。
+//        convert    指定の形式で保存し直す。ジャーナルがあれば反映して消す。
+//        export     .animと同じ名前の.txtを書き出し直す。(GUIで保存した時と同じ中身)
+//        header     .animと同じ名前のC++ヘッダー(.hpp)を書き出す。(AnimHeader.hpp)
+//        json       .animと同じ名前の.jsonを書き出す。(AnimExport.hpp)
+//        msgpack    .animと同じ名前の.msgpackを書き出す。(AnimExport.hpp)
+//
+//    オプション:
+//        -j <数>            使うスレッド数。(省略時はCPUのコア数)
+//        --format <形式>    convertで使う形式。legacy(従来の形式)、v2、compact(コンパクト形式)のどれか。(省略時はlegacy)
+//        --zstd             convertで圧縮して保存する。
+//
+//    ディレクトリはサブフォルダまで辿って.animファイルを集める。
+//    ファイルごとの処理時間と結果を表示し、失敗したファイルがあれば終了コード1を返す。
+
+#include "AnimationBank.hpp"
+#include "AnimCodec.hpp"
+#include "AnimExport.hpp"
+#include "AnimHeader.hpp"
+#include "AnimJournal.hpp"
+#include "AnimText.hpp"
+#include "AnimZstd.hpp"
+#include "AtomicFile.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum class Command
+	{
+		Validate,
+		Convert,
+		Export,
+		Header,
+		Json,
+		MessagePack,
+	};
+
+	struct Options
+	{
+		Command                            command       = Command::Validate;
+		size_t                             threadCount   = 0;
+		AnimFormat                         format        = AnimFormat::Legacy;
+		AnimCompression                    compression   = AnimCompression::None;
+		std::vector<std::filesystem::path> inputs;
+	};
+
+	//ファイル1つ分の結果。ワーカースレッドで書き込み、全て終わってからメインスレッドで表示する。
+	struct FileResult
+	{
+		std::filesystem::path              path;
+		bool                               bSuccess      = false;
+		size_t                             animCount     = 0;
+		size_t                             fileSize      = 0;
+		double                             seconds       = 0.0;
+		std::string                        message;
+	};
+
+	std::string PathToString(const std::filesystem::path& path)
+	{
+		//C++20ではu8stringがchar8_tになるのでcharとして受け取り直す。
+		auto str = path.u8string();
+		return std::string(reinterpret_cast<const char*>(str.data()), str.size());
+	}
+
+	void PrintUsage(void)
+	{
+		std::fprintf(stderr,
+			"usage: AnimBatch <validate|convert|export|header|json|msgpack> [-j threads] [--format legacy|v2|compact] [--zstd] <path ...>\n");
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& outOptions)
+	{
+		if (argc < 3)
+		{
+			return false;
+		}
+
+		if (std::strcmp(argv[1], "validate") == 0)
+		{
+			outOptions.command = Command::Validate;
+		}
+		else if (std::strcmp(argv[1], "convert") == 0)
+		{
+			outOptions.command = Command::Convert;
+		}
+		else if (std::strcmp(argv[1], "export") == 0)
+		{
+			outOptions.command = Command::Export;
+		}
+		else if (std::strcmp(argv[1], "header") == 0)
+		{
+			outOptions.command = Command::Header;
+		}
+		else if (std::strcmp(argv[1], "json") == 0)
+		{
+			outOptions.command = Command::Json;
+		}
+		else if (std::strcmp(argv[1], "msgpack") == 0)
+		{
+			outOptions.command = Command::MessagePack;
+		}
+		else
+		{
+			return false;
+		}
+
+		for (int i = 2; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			{
+				outOptions.threadCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+			}
+			else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+			{
+				const char* format = argv[++i];
+				if (std::strcmp(format, "legacy") == 0)
+				{
+					outOptions.format = AnimFormat::Legacy;
+				}
+				else if (std::strcmp(format, "v2") == 0)
+				{
+					outOptions.format = AnimFormat::Flat;
+				}
+				else if (std::strcmp(format, "compact") == 0)
+				{
+					outOptions.format = AnimFormat::Compact;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(argv[i], "--zstd") == 0)
+			{
+				outOptions.compression = AnimCompression::Zstd;
+			}
+			else
+			{
+				outOptions.inputs.emplace_back(argv[i]);
+			}
+		}
+		return !outOptions.inputs.empty();
+	}
+
+	void CollectFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& outFiles)
+	{
+		std::error_code ec;
+		if (std::filesystem::is_directory(path, ec))
+		{
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec))
+			{
+				if (entry.is_regular_file() && entry.path().extension() == ".anim")
+				{
+					outFiles.push_back(entry.path());
+				}
+			}
+		}
+		else if (std::filesystem::is_regular_file(path, ec))
+		{
+			outFiles.push_back(path);
+		}
+	}
+
+	//並べ替えて、同じファイルを1つにまとめる。(フォルダとその中のファイルを両方指定した場合など)
+	//同じファイルを並列に処理すると互いの書き込みを壊すので、"dir/x.anim"と"dir/./x.anim"のような表記の違いもそろえて比べる。
+	void SortUniqueFiles(std::vector<std::filesystem::path>& files)
+	{
+		std::vector<std::pair<std::filesystem::path, std::filesystem::path>> keyed;
+		keyed.reserve(files.size());
+		for (std::filesystem::path& file : files)
+		{
+			std::error_code ec;
+			std::filesystem::path key = std::filesystem::weakly_canonical(file, ec);
+			if (ec)
+			{
+				key = file.lexically_normal();
+			}
+			keyed.emplace_back(std::move(key), std::move(file));
+		}
+
+		std::sort(keyed.begin(), keyed.end());
+		keyed.erase(std::unique(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) { return a.first == b.first; }), keyed.end());
+
+		files.clear();
+		for (auto& entry : keyed)
+		{
+			files.push_back(std::move(entry.second));
+		}
+	}
+
+	//GUIで編集できない状態になっていないかを調べる。見つかった問題をoutMessageに返す。
+	//AnimationBankの列ごとに1回ずつ辿るので、アニメーションが多くてもパターン配列を先頭から読むだけで済む。
+	bool Validate(const AnimDocument& doc, std::string& outMessage)
+	{
+		if (doc.animations.empty())
+		{
+			outMessage = "no animations";
+			return false;
+		}
+
+		AnimationBank bank(doc);
+		auto prefix = [](size_t index) { return "animation " + std::to_string(index) + ": "; };
+
+		//同じ名前があるとリストの表示がおかしくなる。(GUIManager::AnimationAddGroup参照)
+		//名前の索引は同じ名前なら一番前の番号を返すので、自分の番号でなければ前に同じ名前がある。
+		const std::vector<std::string>& nameColumn = bank.NameColumn();
+		for (size_t i = 0; i < nameColumn.size(); ++i)
+		{
+			if (bank.FindAnimation(nameColumn[i]) != i)
+			{
+				outMessage = prefix(i) + "duplicate name";
+				return false;
+			}
+		}
+
+		const std::vector<uint32_t>& countColumn = bank.PatternCountColumn();
+		for (size_t i = 0; i < countColumn.size(); ++i)
+		{
+			if (countColumn[i] == 0)
+			{
+				outMessage = prefix(i) + "no patterns";
+				return false;
+			}
+		}
+
+		const std::vector<float>& widthColumn  = bank.WidthColumn();
+		const std::vector<float>& heightColumn = bank.HeightColumn();
+		for (size_t i = 0; i < widthColumn.size(); ++i)
+		{
+			if (widthColumn[i] < 0.0f || heightColumn[i] < 0.0f)
+			{
+				outMessage = prefix(i) + "negative size";
+				return false;
+			}
+		}
+
+		const std::vector<AnimPatternData>& pool = bank.PatternPool();
+		for (size_t j = 0; j < pool.size(); ++j)
+		{
+			const AnimPatternData& ptn = pool[j];
+			if (!(ptn.wait >= 0.0f) || ptn.no < 0 || ptn.step < 0)
+			{
+				size_t index = bank.FindAnimationOfPattern(j);
+				outMessage = prefix(index) + "pattern " + std::to_string(j - bank.PatternOffset(index)) + " out of range";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//画像はGUIやパックと同じ場所を探す。(AnimCodec::ResolveTexturePath)
+	bool TextureExists(const std::filesystem::path& animPath, const std::string& textureName)
+	{
+		return !AnimCodec::ResolveTexturePath(animPath, textureName).empty();
+	}
+
+	void ProcessFile(const Options& options, FileResult& result)
+	{
+		auto begin = Clock::now();
+
+		std::error_code ec;
+		result.fileSize = static_cast<size_t>(std::filesystem::file_size(result.path, ec));
+
+		//ジャーナルがあれば反映した状態を扱う。
+		AnimDocument doc;
+		if (!AnimJournal::Load(result.path, doc))
+		{
+			result.message = "failed to load";
+		}
+		else
+		{
+			result.animCount = doc.animations.size();
+
+			switch (options.command)
+			{
+			case Command::Validate:
+				result.bSuccess = Validate(doc, result.message);
+				if (result.bSuccess && !TextureExists(result.path, doc.textureName))
+				{
+					result.message = "warning: texture not found (" + doc.textureName + ")";
+				}
+				break;
+			case Command::Convert:
+			{
+				std::vector<uint8_t> buffer;
+				if (!AnimCodec::Encode(doc, buffer, options.format, options.compression))
+				{
+					result.message = "failed to encode";
+					break;
+				}
+				if (!AtomicFile::Write(result.path, buffer.data(), buffer.size()))
+				{
+					result.message = "failed to write";
+					break;
+				}
+
+				//ジャーナルの中身は書き出したファイルに含まれている。
+				AnimJournal::Remove(result.path);
+
+				result.message  = std::to_string(result.fileSize) + " -> " + std::to_string(buffer.size()) + " bytes";
+				result.bSuccess = true;
+				break;
+			}
+			case Command::Export:
+			{
+				//GUIManager::SaveDataと同じく、.animと同じ名前の.txtを書き、1行目に.animのパスを書く。
+				std::filesystem::path txtPath = result.path;
+				txtPath.replace_extension(".txt");
+
+				result.bSuccess = AnimText::Save(txtPath, doc, result.path.generic_string());
+				if (!result.bSuccess)
+				{
+					result.message = "failed to write " + PathToString(txtPath);
+				}
+				break;
+			}
+			case Command::Header:
+			{
+				std::filesystem::path headerPath = result.path;
+				headerPath.replace_extension(".hpp");
+
+				result.bSuccess = AnimHeader::Save(headerPath, doc);
+				if (!result.bSuccess)
+				{
+					result.message = "failed to write " + PathToString(headerPath);
+				}
+				break;
+			}
+			case Command::Json:
+			case Command::MessagePack:
+			{
+				AnimExportFormat format = (options.command == Command::Json) ? AnimExportFormat::Json : AnimExportFormat::MessagePack;
+
+				std::filesystem::path exportPath = result.path;
+				exportPath.replace_extension(AnimExport::Extension(format));
+
+				result.bSuccess = AnimExport::Save(exportPath, doc, format);
+				if (!result.bSuccess)
+				{
+					result.message = "failed to write " + PathToString(exportPath);
+				}
+				break;
+			}
+			}
+		}
+
+		result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	if (options.compression == AnimCompression::Zstd && !AnimZstd::IsAvailable())
+	{
+		std::fprintf(stderr, "built without zstd.h\n");
+		return 2;
+	}
+
+	std::vector<std::filesystem::path> files;
+	for (const auto& input : options.inputs)
+	{
+		CollectFiles(input, files);
+	}
+	SortUniqueFiles(files);
+
+	if (files.empty())
+	{
+		std::fprintf(stderr, "no .anim files found\n");
+		return 2;
+	}
+
+	//結果は最初にまとめて確保しておき、ワーカースレッドはそれぞれ自分の分だけに書き込む。
+	std::vector<FileResult> results(files.size());
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		results[i].path = files[i];
+	}
+
+	auto begin = Clock::now();
+	size_t threadCount = 0;
+	{
+		ThreadPool pool(options.threadCount);
+		threadCount = pool.ThreadCount();
+
+		for (FileResult& result : results)
+		{
+			pool.Push([&options, &result]() { ProcessFile(options, result); });
+		}
+		pool.Wait();
+	}
+	double wallSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+	size_t failedCount = 0;
+	double totalSeconds = 0.0;
+
+	std::printf("%-6s %10s %6s  %s\n", "result", "time (ms)", "anims", "file");
+	for (const FileResult& result : results)
+	{
+		std::printf("%-6s %10.3f %6zu  %s", result.bSuccess ? "ok" : "FAILED", result.seconds * 1e3, result.animCount, PathToString(result.path).c_str());
+		if (!result.message.empty())
+		{
+			std::printf("  (%s)", result.message.c_str());
+		}
+		std::printf("\n");
+
+		failedCount  += result.bSuccess ? 0 : 1;
+		totalSeconds += result.seconds;
+	}
+
+	std::printf("\n%zu files, %zu failed, %zu threads: wall %.3f ms, sum %.3f ms, %.1f files/s\n",
+		results.size(), failedCount, threadCount, wallSeconds * 1e3, totalSeconds * 1e3, results.size() / wallSeconds);
+
+	return failedCount == 0 ? 0 : 1;
+}
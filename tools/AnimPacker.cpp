@@ -0,0 +1,203 @@
+﻿//.animファイルと画像をまとめたパック(AnimPack.hpp)を作る・中身を調べるコマンドラインツール。Siv3Dなしでビルドできる。
+//
+//ビルド例:
+//    g++ -std=c++17 -O2 -I../animake AnimPacker.cpp ../animake/AnimCodec.cpp ../animake/AnimCompact.cpp ../animake/AnimIndex.cpp ../animake/AnimPack.cpp ../animake/AnimText.cpp ../animake/AnimV2.cpp ../animake/AnimZstd.cpp ../animake/AtomicFile.cpp ../animake/DocumentArena.cpp ../animake/MappedFile.cpp -o AnimPacker
+//    (zstd.hがある環境では -lzstd も付ける)
+//
+//使い方:
+//    AnimPacker build [--root <フォルダ>] <出力先.animpack> <.animファイル or ディレクトリ ...>
+//        .animファイルとそれぞれが使う画像をまとめる。ディレクトリはサブフォルダまで辿る。
+//        .animと画像の名前は--rootのフォルダ(省略時は作業フォルダ)からの相対パスになる。
+//        画像はGUIと同じく作業フォルダからの相対パスで探すので、GUIと同じ作業フォルダで実行すること。
+//    AnimPacker list <.animpack>
+//        エントリの一覧を表示する。
+//    AnimPacker find <.animpack> <名前 ...>
+//        名前からエントリを引いて、アニメーションならデコードできるかを調べる。
+
+#include "AnimPack.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace siapp;
+
+namespace
+{
+	void PrintUsage(void)
+	{
+		std::fprintf(stderr,
+			"usage: AnimPacker build [--root dir] <out.animpack> <path ...>\n"
+			"       AnimPacker list <pack>\n"
+			"       AnimPacker find <pack> <name ...>\n");
+	}
+
+	void CollectFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& outFiles)
+	{
+		std::error_code ec;
+		if (std::filesystem::is_directory(path, ec))
+		{
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec))
+			{
+				if (entry.is_regular_file() && entry.path().extension() == ".anim")
+				{
+					outFiles.push_back(entry.path());
+				}
+			}
+		}
+		else if (std::filesystem::is_regular_file(path, ec))
+		{
+			outFiles.push_back(path);
+		}
+	}
+
+	const char* KindName(AnimPackKind kind)
+	{
+		return kind == AnimPackKind::Animation ? "anim" : "texture";
+	}
+
+	int Build(int argc, char* argv[])
+	{
+		std::filesystem::path rootDir = std::filesystem::current_path();
+		std::filesystem::path outPath;
+		std::vector<std::filesystem::path> files;
+
+		for (int i = 2; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--root") == 0 && i + 1 < argc)
+			{
+				rootDir = argv[++i];
+			}
+			else if (outPath.empty())
+			{
+				outPath = argv[i];
+			}
+			else
+			{
+				CollectFiles(argv[i], files);
+			}
+		}
+
+		if (outPath.empty() || files.empty())
+		{
+			PrintUsage();
+			return 2;
+		}
+
+		//並び順をそろえて、同じ入力から同じパックができるようにする。
+		std::sort(files.begin(), files.end());
+
+		std::string message;
+		if (!AnimPack::Build(rootDir, files, outPath, message))
+		{
+			std::fprintf(stderr, "%s\n", message.c_str());
+			return 1;
+		}
+
+		AnimPackFile pack;
+		if (!pack.Open(outPath))
+		{
+			std::fprintf(stderr, "failed to open %s\n", outPath.string().c_str());
+			return 1;
+		}
+
+		size_t textureCount = 0;
+		for (uint32_t i = 0; i < pack.EntryCount(); ++i)
+		{
+			textureCount += pack.Entry(i).kind == AnimPackKind::Texture ? 1 : 0;
+		}
+
+		std::printf("%zu animations, %zu textures, %llu bytes\n",
+			files.size(), textureCount, static_cast<unsigned long long>(std::filesystem::file_size(outPath)));
+		return 0;
+	}
+
+	int List(const char* packPath)
+	{
+		AnimPackFile pack;
+		if (!pack.Open(packPath))
+		{
+			std::fprintf(stderr, "failed to open %s\n", packPath);
+			return 1;
+		}
+
+		std::printf("%-8s %12s  %s\n", "kind", "bytes", "name");
+		for (uint32_t i = 0; i < pack.EntryCount(); ++i)
+		{
+			const AnimPackEntry& entry = pack.Entry(i);
+			std::string name(pack.Name(i));
+
+			std::printf("%-8s %12llu  %s", KindName(entry.kind), static_cast<unsigned long long>(entry.dataSize), name.c_str());
+
+			uint32_t textureIndex = pack.TextureIndex(i);
+			if (textureIndex != animPackNotFound)
+			{
+				std::string textureName(pack.Name(textureIndex));
+				std::printf("  -> %s", textureName.c_str());
+			}
+			std::printf("\n");
+		}
+		return 0;
+	}
+
+	int Find(int argc, char* argv[])
+	{
+		AnimPackFile pack;
+		if (!pack.Open(argv[2]))
+		{
+			std::fprintf(stderr, "failed to open %s\n", argv[2]);
+			return 1;
+		}
+
+		int result = 0;
+		for (int i = 3; i < argc; ++i)
+		{
+			uint32_t index = pack.Find(argv[i]);
+			if (index == animPackNotFound)
+			{
+				std::printf("%s: not found\n", argv[i]);
+				result = 1;
+				continue;
+			}
+
+			const AnimPackEntry& entry = pack.Entry(index);
+			std::printf("%s: %s, entry %u, %llu bytes", argv[i], KindName(entry.kind), index, static_cast<unsigned long long>(entry.dataSize));
+
+			if (entry.kind == AnimPackKind::Animation)
+			{
+				AnimDocument doc;
+				if (pack.DecodeAnimation(index, doc))
+				{
+					std::printf(", %zu animations", doc.animations.size());
+				}
+				else
+				{
+					std::printf(", failed to decode");
+					result = 1;
+				}
+			}
+			std::printf("\n");
+		}
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 4 && std::strcmp(argv[1], "build") == 0)
+	{
+		return Build(argc, argv);
+	}
+	if (argc == 3 && std::strcmp(argv[1], "list") == 0)
+	{
+		return List(argv[2]);
+	}
+	if (argc >= 4 && std::strcmp(argv[1], "find") == 0)
+	{
+		return Find(argc, argv);
+	}
+
+	PrintUsage();
+	return 2;
+}